@@ -9,6 +9,8 @@
 #include <OMX_CoreAlg.h>
 #include "base/omx_checker/omx_checker.h"
 #include <cassert>
+#include <cstdlib>
+#include <sstream>
 
 #include <utility/logger.h>
 #include <utility/omx_translate.h>
@@ -89,6 +91,12 @@ void Component::ReturnFilledBuffer(OMX_BUFFERHEADERTYPE* filled, int offset, int
   header->nOffset = offset;
   header->nFilledLen = size;
 
+  if(size > 0 && (header->nFlags & OMX_BUFFERFLAG_ENDOFFRAME))
+  {
+    ++outputFrames;
+    latency.Departed(header->nTimeStamp);
+  }
+
   if(callbacks.FillBufferDone)
     callbacks.FillBufferDone(component, app, header);
 }
@@ -215,6 +223,8 @@ Component::Component(OMX_HANDLETYPE component, shared_ptr<SettingsInterface> med
   shouldClearROI = false;
   shouldPushROI = false;
   shouldFireEventPortSettingsChanges = true;
+  inputFrames = 0;
+  outputFrames = 0;
   version.nVersion = ALLEGRODVT_OMX_VERSION;
   AssociateSpecVersion(spec);
 
@@ -225,9 +235,11 @@ Component::Component(OMX_HANDLETYPE component, shared_ptr<SettingsInterface> med
   auto p = bind(&Component::_ProcessMain, this, placeholders::_1);
   auto p2 = bind(&Component::_ProcessFillBuffer, this, placeholders::_1);
   auto p3 = bind(&Component::_ProcessEmptyBuffer, this, placeholders::_1);
-  processorMain.reset(new ProcessorFifo<Task> { p, nullptr, "OMX - Sched" });
-  processorFill.reset(new ProcessorFifo<Task> { p2, deleteFill, "OMX - Out" });
-  processorEmpty.reset(new ProcessorFifo<Task> { p3, deleteEmpty, "OMX - In" });
+  threadPool = GetSharedThreadPool();
+  processorMain.reset(new ProcessorFifo<Task> { p, nullptr, "OMX - Sched", threadPool });
+  processorFill.reset(new ProcessorFifo<Task> { p2, deleteFill, "OMX - Out", threadPool });
+  processorEmpty.reset(new ProcessorFifo<Task> { p3, deleteEmpty, "OMX - In", threadPool });
+  SetThreadSchedulingsFromEnvironment();
   pauseFillPromise = nullptr;
   pauseEmptyPromise = nullptr;
   eosHandles.input = nullptr;
@@ -1111,6 +1123,12 @@ OMX_ERRORTYPE Component::SetParameter(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR
     this->shouldPrealloc = (p->bDisablePreallocation == OMX_FALSE);
     return OMX_ErrorNone;
   }
+  case OMX_ALG_IndexParamPrepareChannel: // SetParameter only
+  {
+    auto p = static_cast<OMX_ALG_PARAM_PREPARE_CHANNEL*>(param);
+    PrepareChannel(p->bPrepare == OMX_TRUE);
+    return OMX_ErrorNone;
+  }
   case OMX_ALG_IndexParamVideoDecodedPictureBuffer:
   {
     auto dpb = static_cast<OMX_ALG_VIDEO_PARAM_DECODED_PICTURE_BUFFER*>(param);
@@ -1364,6 +1382,14 @@ OMX_ERRORTYPE Component::EmptyThisBuffer(OMX_IN OMX_BUFFERHEADERTYPE* header)
   OMXChecker::CheckStateOperation(OMXChecker::ComponentMethods::EmptyThisBuffer, state);
   CheckPortIndex(header->nInputPortIndex);
 
+  if(header->nFilledLen > 0)
+  {
+    /* A decoder input may carry a part of a frame only */
+    if(header->nFlags & OMX_BUFFERFLAG_ENDOFFRAME)
+      ++inputFrames;
+    latency.Arrived(header->nTimeStamp);
+  }
+
   processorMain->queue(CreateTask(Command::EmptyBuffer, static_cast<OMX_U32>(input.index), shared_ptr<void>(header, nullDeleter)));
 
   return OMX_ErrorNone;
@@ -1388,8 +1414,22 @@ OMX_ERRORTYPE Component::FillThisBuffer(OMX_IN OMX_BUFFERHEADERTYPE* header)
   OMX_CATCH();
 }
 
+static string ToStringCpuTimePerFrame(char const* role, OMX_U64 cpuTime, OMX_U64 frames)
+{
+  return string { role } +": " + to_string(frames ? cpuTime / frames : cpuTime) + (frames ? "us/frame" : "us");
+}
+
 void Component::ComponentDeInit()
 {
+  OMX_ALG_CONFIG_CPU_USAGE usage {};
+  GetCpuUsage(usage);
+  LOG_IMPORTANT(string { name } +" cpu usage over " + to_string(usage.nFrames) + " frames, " +
+                ToStringCpuTimePerFrame("commands", usage.nCommandsCpuTime, usage.nFrames) + ", " +
+                ToStringCpuTimePerFrame("empty", usage.nEmptyCpuTime, usage.nFrames) + ", " +
+                ToStringCpuTimePerFrame("fill", usage.nFillCpuTime, usage.nFrames) + ", " +
+                ToStringCpuTimePerFrame("module threads", usage.nModuleThreadsCpuTime, usage.nFrames) + ", " +
+                ToStringCpuTimePerFrame("module callbacks", usage.nModuleCallbacksCpuTime, usage.nFrames));
+
   if(eosHandles.input)
   {
     delete eosHandles.input;
@@ -1484,6 +1524,42 @@ OMX_ERRORTYPE Component::GetConfig(OMX_IN OMX_INDEXTYPE index, OMX_INOUT OMX_PTR
     hdrSEIs = ConvertMediaToOMXHDRSEI(modHDRSEIs);
     return OMX_ErrorNone;
   }
+  case OMX_ALG_IndexConfigVideoQuantizationParameterTable: // Only gives the size of the table
+  {
+    int size;
+
+    if(module->GetDynamic(DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE, &size) != ModuleInterface::SUCCESS)
+      throw OMX_ErrorUnsupportedIndex;
+    auto& data = *(static_cast<OMX_ALG_VIDEO_CONFIG_DATA*>(config));
+    data.pBuffer = nullptr;
+    data.nAllocLen = size;
+    data.nFilledLen = 0;
+    data.nOffset = 0;
+    return OMX_ErrorNone;
+  }
+  case OMX_ALG_IndexConfigVideoSceneChangeAnalysis:
+  {
+    SceneChangeAnalysis moduleAnalysis;
+
+    if(module->GetDynamic(DYNAMIC_INDEX_SCENE_CHANGE_ANALYSIS, &moduleAnalysis) != ModuleInterface::SUCCESS)
+      throw OMX_ErrorUnsupportedIndex;
+    auto& analysis = *(static_cast<OMX_ALG_VIDEO_CONFIG_SCENE_CHANGE_ANALYSIS*>(config));
+    analysis.bEnableAnalysis = ConvertMediaToOMXBool(moduleAnalysis.isEnabled);
+    analysis.nDetectedSceneChanges = moduleAnalysis.detected;
+    return OMX_ErrorNone;
+  }
+  case OMX_ALG_IndexConfigVideoStaticFrameSkip:
+  {
+    StaticFrameSkip moduleSkip;
+
+    if(module->GetDynamic(DYNAMIC_INDEX_STATIC_FRAME_SKIP, &moduleSkip) != ModuleInterface::SUCCESS)
+      throw OMX_ErrorUnsupportedIndex;
+    auto& skip = *(static_cast<OMX_ALG_VIDEO_CONFIG_STATIC_FRAME_SKIP*>(config));
+    skip.bEnableSkip = ConvertMediaToOMXBool(moduleSkip.isEnabled);
+    skip.nMaxConsecutiveSkips = moduleSkip.maxConsecutiveSkips;
+    skip.nSkippedFrames = moduleSkip.skipped;
+    return OMX_ErrorNone;
+  }
   case OMX_ALG_IndexConfigVideoMaxResolutionChange:
   {
     Dimension<int> maxDimensionSupported;
@@ -1493,6 +1569,45 @@ OMX_ERRORTYPE Component::GetConfig(OMX_IN OMX_INDEXTYPE index, OMX_INOUT OMX_PTR
     dimension.nHeight = maxDimensionSupported.vertical;
     return OMX_ErrorNone;
   }
+  case OMX_ALG_IndexConfigStatistics: // GetConfig only
+  {
+    auto& statistics = *(static_cast<OMX_ALG_CONFIG_STATISTICS*>(config));
+    GetStatistics(statistics);
+    return OMX_ErrorNone;
+  }
+  case OMX_ALG_IndexConfigCpuUsage: // GetConfig only
+  {
+    auto& usage = *(static_cast<OMX_ALG_CONFIG_CPU_USAGE*>(config));
+    GetCpuUsage(usage);
+    return OMX_ErrorNone;
+  }
+  case OMX_ALG_IndexConfigThreadScheduling:
+  {
+    auto& threadScheduling = *(static_cast<OMX_ALG_CONFIG_THREAD_SCHEDULING*>(config));
+    ThreadScheduling scheduling {};
+
+    if(threadScheduling.eThread == OMX_ALG_THREAD_MODULE)
+    {
+      auto ret = module->GetDynamic(DYNAMIC_INDEX_THREAD_SCHEDULING, &scheduling);
+
+      if(ret == ModuleInterface::BAD_INDEX)
+        throw OMX_ErrorUnsupportedIndex;
+
+      // No module thread runs at the moment
+      if(ret != ModuleInterface::SUCCESS)
+        return OMX_ErrorNotReady;
+    }
+    else
+    {
+      unique_lock<std::mutex> lock(processorsMutex);
+      scheduling = GetProcessor(threadScheduling.eThread)->GetScheduling();
+    }
+
+    threadScheduling.nCpuMask = scheduling.cpuMask;
+    threadScheduling.ePolicy = ConvertMediaToOMXSchedulingPolicy(scheduling.policy);
+    threadScheduling.nPriority = scheduling.priority;
+    return OMX_ErrorNone;
+  }
   default:
     LOG_ERROR(ToStringOMXIndex(index) + string { " is unsupported" });
     return OMX_ErrorUnsupportedIndex;
@@ -1503,6 +1618,57 @@ OMX_ERRORTYPE Component::GetConfig(OMX_IN OMX_INDEXTYPE index, OMX_INOUT OMX_PTR
   OMX_CATCH_PARAMETER_OR_CONFIG();
 }
 
+static RegionQuality CreateRegionQualityByPreset(OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST const& roi)
+{
+  RegionQuality rq {};
+  rq.region.point.x = roi.nLeft;
+  rq.region.point.y = roi.nTop;
+  rq.region.dimension.horizontal = roi.nWidth;
+  rq.region.dimension.vertical = roi.nHeight;
+  rq.quality.byPreset = ConvertOMXToMediaQualityPreset(roi.eQuality);
+  return rq;
+}
+
+static RegionQuality CreateRegionQualityByValue(OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST_BY_VALUE const& roi)
+{
+  RegionQuality rq {};
+  rq.region.point.x = roi.nLeft;
+  rq.region.point.y = roi.nTop;
+  rq.region.dimension.horizontal = roi.nWidth;
+  rq.region.dimension.vertical = roi.nHeight;
+  rq.quality.byValue = ConvertOMXToMediaQualityValue(roi.nQuality);
+  return rq;
+}
+
+static RegionQualityList CreateRegionQualityList(OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST_LIST const& list)
+{
+  RegionQualityList rql {};
+  rql.replace = (list.bReplace == OMX_TRUE);
+  rql.regions.reserve(list.nNumRegions);
+
+  for(OMX_U32 i = 0; i < list.nNumRegions; ++i)
+  {
+    auto const& region = list.pRegions[i];
+    RegionQualityListEntry entry {};
+    entry.isByValue = (region.bByValue == OMX_TRUE);
+    entry.regionQuality.region.point.x = region.nLeft;
+    entry.regionQuality.region.point.y = region.nTop;
+    entry.regionQuality.region.dimension.horizontal = region.nWidth;
+    entry.regionQuality.region.dimension.vertical = region.nHeight;
+    entry.endPoint.x = region.nEndLeft;
+    entry.endPoint.y = region.nEndTop;
+    entry.motionFrames = region.nMotionFrames;
+
+    if(entry.isByValue)
+      entry.regionQuality.quality.byValue = ConvertOMXToMediaQualityValue(region.nQuality);
+    else
+      entry.regionQuality.quality.byPreset = ConvertOMXToMediaQualityPreset(region.eQuality);
+    rql.regions.push_back(entry);
+  }
+
+  return rql;
+}
+
 OMX_ERRORTYPE Component::SetConfig(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR config)
 {
   OMX_TRY();
@@ -1560,6 +1726,20 @@ OMX_ERRORTYPE Component::SetConfig(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR co
     processorMain->queue(CreateTask(Command::SetDynamic, OMX_ALG_IndexConfigVideoRegionOfInterestByValue, shared_ptr<void>(roi)));
     return OMX_ErrorNone;
   }
+  case OMX_ALG_IndexConfigVideoRegionOfInterestList:
+  {
+    auto list = static_cast<OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST_LIST*>(config);
+
+    if(list->nNumRegions > OMX_ALG_MAX_REGIONS_OF_INTEREST)
+      throw OMX_ErrorBadParameter;
+
+    if(list->nNumRegions)
+      OMXChecker::CheckNotNull(list->pRegions);
+
+    RegionQualityList* rql = new RegionQualityList { CreateRegionQualityList(*list) };
+    processorMain->queue(CreateTask(Command::SetDynamic, OMX_ALG_IndexConfigVideoRegionOfInterestList, shared_ptr<void>(rql)));
+    return OMX_ErrorNone;
+  }
   case OMX_ALG_IndexConfigVideoNotifySceneChange:
   {
     OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE* notifySceneChange = new OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE;
@@ -1567,6 +1747,20 @@ OMX_ERRORTYPE Component::SetConfig(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR co
     processorMain->queue(CreateTask(Command::SetDynamic, OMX_ALG_IndexConfigVideoNotifySceneChange, shared_ptr<void>(notifySceneChange)));
     return OMX_ErrorNone;
   }
+  case OMX_ALG_IndexConfigVideoSceneChangeAnalysis:
+  {
+    OMX_ALG_VIDEO_CONFIG_SCENE_CHANGE_ANALYSIS* analysis = new OMX_ALG_VIDEO_CONFIG_SCENE_CHANGE_ANALYSIS;
+    memcpy(analysis, static_cast<OMX_ALG_VIDEO_CONFIG_SCENE_CHANGE_ANALYSIS*>(config), sizeof(OMX_ALG_VIDEO_CONFIG_SCENE_CHANGE_ANALYSIS));
+    processorMain->queue(CreateTask(Command::SetDynamic, OMX_ALG_IndexConfigVideoSceneChangeAnalysis, shared_ptr<void>(analysis)));
+    return OMX_ErrorNone;
+  }
+  case OMX_ALG_IndexConfigVideoStaticFrameSkip:
+  {
+    OMX_ALG_VIDEO_CONFIG_STATIC_FRAME_SKIP* skip = new OMX_ALG_VIDEO_CONFIG_STATIC_FRAME_SKIP;
+    memcpy(skip, static_cast<OMX_ALG_VIDEO_CONFIG_STATIC_FRAME_SKIP*>(config), sizeof(OMX_ALG_VIDEO_CONFIG_STATIC_FRAME_SKIP));
+    processorMain->queue(CreateTask(Command::SetDynamic, OMX_ALG_IndexConfigVideoStaticFrameSkip, shared_ptr<void>(skip)));
+    return OMX_ErrorNone;
+  }
   case OMX_ALG_IndexConfigVideoInsertLongTerm:
   {
     OMX_ALG_VIDEO_CONFIG_INSERT* lt = new OMX_ALG_VIDEO_CONFIG_INSERT;
@@ -1617,13 +1811,30 @@ OMX_ERRORTYPE Component::SetConfig(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR co
   }
   case OMX_ALG_IndexConfigVideoQuantizationParameterTable:
   {
-    QPs qps;
-    media->Get(SETTINGS_INDEX_QUANTIZATION_PARAMETER, &qps);
     OMX_ALG_VIDEO_CONFIG_DATA* userData = static_cast<OMX_ALG_VIDEO_CONFIG_DATA*>(config);
+    OMXChecker::CheckNotNull(userData->pBuffer);
+    int size;
+
+    if(module->GetDynamic(DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE, &size) != ModuleInterface::SUCCESS)
+      throw OMX_ErrorUnsupportedIndex;
+
+    if(userData->nOffset + size > userData->nAllocLen)
+      throw OMX_ErrorBadParameter;
+
+    /* The table is copied once, in module memory, and then attached as is to the frame */
     OMX_ALG_VIDEO_CONFIG_DATA* data = new OMX_ALG_VIDEO_CONFIG_DATA {};
     memcpy(data, userData, sizeof(OMX_ALG_VIDEO_CONFIG_DATA));
-    data->pBuffer = new OMX_U8[userData->nAllocLen] {};
-    memcpy(data->pBuffer, userData->pBuffer, userData->nAllocLen);
+    data->pBuffer = static_cast<OMX_U8*>(module->Allocate(size));
+
+    if(!data->pBuffer)
+    {
+      delete data;
+      throw OMX_ErrorInsufficientResources;
+    }
+    memcpy(data->pBuffer, userData->pBuffer + userData->nOffset, size);
+    data->nOffset = 0;
+    data->nAllocLen = size;
+    data->nFilledLen = size;
     processorMain->queue(CreateTask(Command::SetDynamic, OMX_ALG_IndexConfigVideoQuantizationParameterTable, shared_ptr<void>(data)));
     return OMX_ErrorNone;
   }
@@ -1641,6 +1852,33 @@ OMX_ERRORTYPE Component::SetConfig(OMX_IN OMX_INDEXTYPE index, OMX_IN OMX_PTR co
     processorMain->queue(CreateTask(Command::SetDynamic, OMX_ALG_IndexConfigVideoLoopFilterTc, shared_ptr<void>(lftc)));
     return OMX_ErrorNone;
   }
+  case OMX_ALG_IndexConfigThreadScheduling:
+  {
+    auto& threadScheduling = *(static_cast<OMX_ALG_CONFIG_THREAD_SCHEDULING*>(config));
+
+    if(threadScheduling.ePolicy > OMX_ALG_THREAD_POLICY_ROUND_ROBIN)
+      throw OMX_ErrorBadParameter;
+
+    ThreadScheduling scheduling {
+      threadScheduling.nCpuMask, ConvertOMXToMediaSchedulingPolicy(threadScheduling.ePolicy), threadScheduling.nPriority
+    };
+
+    if(threadScheduling.eThread == OMX_ALG_THREAD_MODULE)
+    {
+      // The module guards its threads itself, they may be started and stopped meanwhile
+      auto ret = module->SetDynamic(DYNAMIC_INDEX_THREAD_SCHEDULING, &scheduling);
+
+      if(ret == ModuleInterface::BAD_INDEX)
+        throw OMX_ErrorUnsupportedIndex;
+
+      return ret == ModuleInterface::SUCCESS ? OMX_ErrorNone : OMX_ErrorUnsupportedSetting;
+    }
+
+    unique_lock<std::mutex> lock(processorsMutex);
+    GetProcessor(threadScheduling.eThread);
+    threadSchedulings[threadScheduling.eThread] = scheduling;
+    return ApplyThreadScheduling(threadScheduling.eThread) ? OMX_ErrorNone : OMX_ErrorUnsupportedSetting;
+  }
   default:
     LOG_ERROR(ToStringOMXIndex(index) + string { " is unsupported" });
     return OMX_ErrorUnsupportedIndex;
@@ -1743,8 +1981,11 @@ static inline bool isTransitionToPause(OMX_STATETYPE previousState, OMX_STATETYP
   return true;
 }
 
+/* The application allocates the buffers of the ports at its pace */
 void Component::PopulatingPorts()
 {
+  ThreadPool::BlockingScope blocking {};
+
   for(auto i = videoPortParams.nStartPortNumber; i < videoPortParams.nPorts; i++)
   {
     auto port = GetPort(i);
@@ -1762,6 +2003,8 @@ void Component::PopulatingPorts()
 
 void Component::UnpopulatingPorts()
 {
+  ThreadPool::BlockingScope blocking {};
+
   for(auto i = videoPortParams.nStartPortNumber; i < videoPortParams.nPorts; i++)
   {
     auto port = GetPort(i);
@@ -1787,24 +2030,194 @@ void Component::FlushFillEmptyBuffers(bool fill, bool empty)
   {
     auto deleteFill = bind(&Component::_DeleteFill, this, placeholders::_1);
     auto processFill = bind(&Component::_ProcessFillBuffer, this, placeholders::_1);
-    processorFill.reset(new ProcessorFifo<Task> { processFill, deleteFill, "OMX - Out" });
+    unique_lock<std::mutex> lock(processorsMutex);
+    AccumulateStatistics(flushedFillStatistics, processorFill->GetStatistics());
+    processorFill.reset(new ProcessorFifo<Task> { processFill, deleteFill, "OMX - Out", threadPool });
+    ApplyThreadScheduling(OMX_ALG_THREAD_OUTPUT);
   }
 
   if(empty)
   {
     auto deleteEmpty = bind(&Component::_DeleteEmpty, this, placeholders::_1);
     auto processEmpty = bind(&Component::_ProcessEmptyBuffer, this, placeholders::_1);
-    processorEmpty.reset(new ProcessorFifo<Task> { processEmpty, deleteEmpty, "OMX - In" });
+    unique_lock<std::mutex> lock(processorsMutex);
+    AccumulateStatistics(flushedEmptyStatistics, processorEmpty->GetStatistics());
+    processorEmpty.reset(new ProcessorFifo<Task> { processEmpty, deleteEmpty, "OMX - In", threadPool });
+    ApplyThreadScheduling(OMX_ALG_THREAD_INPUT);
   }
 
   if(buffersFillBlocked || buffersEmptyBlocked)
     BlockFillEmptyBuffers(buffersFillBlocked, buffersEmptyBlocked);
 }
 
+static void ConvertStatistics(ProcessorFifoStatistics const& src, OMX_ALG_QUEUE_STATISTICS& dst)
+{
+  dst.nEnqueued = src.enqueued;
+  dst.nProcessed = src.processed;
+  dst.nDepth = src.depth;
+  dst.nMaxDepth = src.maxDepth;
+  dst.nWaitTime = src.waitTime;
+}
+
+static void ConvertStatistics(PortStatistics const& src, OMX_ALG_PORT_STATISTICS& dst)
+{
+  dst.nWaitFullBlocked = src.waitFullBlocked;
+  dst.nWaitFullTime = src.waitFullTime;
+  dst.nWaitEmptyBlocked = src.waitEmptyBlocked;
+  dst.nWaitEmptyTime = src.waitEmptyTime;
+}
+
+/* The empty and fill processors are recreated on flush, their history is kept aside */
+void Component::GetStatistics(OMX_ALG_CONFIG_STATISTICS& statistics)
+{
+  statistics.nInputFrames = inputFrames;
+  statistics.nOutputFrames = outputFrames;
+  uint64_t cumulativeLatency, latencyFrames;
+  latency.Get(cumulativeLatency, latencyFrames);
+  statistics.nLatency = cumulativeLatency;
+  statistics.nLatencyFrames = latencyFrames;
+  statistics.nBufferMemory = input.GetMemory() + output.GetMemory();
+
+  unique_lock<std::mutex> lock(processorsMutex);
+  auto empty = flushedEmptyStatistics;
+  AccumulateStatistics(empty, processorEmpty->GetStatistics());
+  auto fill = flushedFillStatistics;
+  AccumulateStatistics(fill, processorFill->GetStatistics());
+
+  ConvertStatistics(processorMain->GetStatistics(), statistics.tCommands);
+  ConvertStatistics(empty, statistics.tEmptyQueue);
+  ConvertStatistics(fill, statistics.tFillQueue);
+  ConvertStatistics(input.GetStatistics(), statistics.tInputPort);
+  ConvertStatistics(output.GetStatistics(), statistics.tOutputPort);
+
+  LookAheadStatistics lookAhead {};
+
+  if(module->GetDynamic(DYNAMIC_INDEX_LOOKAHEAD_STATISTICS, &lookAhead) != ModuleInterface::SUCCESS)
+    lookAhead = LookAheadStatistics {};
+
+  statistics.tLookAhead.nEnqueued = lookAhead.queued;
+  statistics.tLookAhead.nProcessed = lookAhead.processed;
+  statistics.tLookAhead.nDepth = lookAhead.depth;
+  statistics.tLookAhead.nMaxDepth = lookAhead.maxDepth;
+  statistics.tLookAhead.nWaitTime = lookAhead.waitTime;
+  statistics.nLookAheadBlocked = lookAhead.blocked;
+  statistics.nLookAheadBlockedTime = lookAhead.blockedTime;
+  statistics.nLookAheadAllocations = lookAhead.metaDataAllocations;
+  statistics.nReconfigurations = reconfigurations;
+  statistics.nReconfigInPlace = reconfigInPlace;
+  statistics.nReconfigDowntime = reconfigDowntime;
+  statistics.nReconfigLostFrames = reconfigLostFrames;
+}
+
+static std::map<OMX_ALG_THREAD, char const*> const THREAD_NAMES {
+  {
+    OMX_ALG_THREAD_COMMANDS, "commands"
+  },
+  {
+    OMX_ALG_THREAD_INPUT, "input"
+  },
+  {
+    OMX_ALG_THREAD_OUTPUT, "output"
+  },
+  {
+    OMX_ALG_THREAD_MODULE, "module"
+  },
+};
+
+ProcessorFifo<Task>* Component::GetProcessor(OMX_ALG_THREAD thread)
+{
+  switch(thread)
+  {
+  case OMX_ALG_THREAD_COMMANDS: return processorMain.get();
+  case OMX_ALG_THREAD_INPUT: return processorEmpty.get();
+  case OMX_ALG_THREAD_OUTPUT: return processorFill.get();
+  default:
+    throw OMX_ErrorBadParameter;
+  }
+}
+
+/* Must be called with the processors lock held */
+bool Component::ApplyThreadScheduling(OMX_ALG_THREAD thread)
+{
+  auto scheduling = threadSchedulings.find(thread);
+
+  if(scheduling == threadSchedulings.end())
+    return true;
+
+  auto processor = GetProcessor(thread);
+  auto isApplied = processor->SetScheduling(scheduling->second);
+  auto applied = string { name } +": " + THREAD_NAMES.at(thread) + " thread runs with " + ToString(processor->GetScheduling());
+
+  if(!isApplied)
+  {
+    LOG_WARNING(applied + " instead of " + ToString(scheduling->second));
+    return false;
+  }
+
+  LOG_IMPORTANT(applied);
+  return true;
+}
+
+/* OMX_ALLEGRO_THREAD_SCHEDULING lists thread=scheduling entries separated by semicolons,
+ * such as "input=0xc,fifo,50;output=0x10,fifo,50;module=0x20". They apply to every component
+ * and are overridden by OMX_ALG_IndexConfigThreadScheduling */
+void Component::SetThreadSchedulingsFromEnvironment()
+{
+  char* envValue = getenv("OMX_ALLEGRO_THREAD_SCHEDULING");
+
+  if(envValue == nullptr)
+    return;
+
+  stringstream entries { string { envValue } };
+  string entry;
+
+  while(getline(entries, entry, ';'))
+  {
+    auto separator = entry.find('=');
+    auto thread = find_if(THREAD_NAMES.begin(), THREAD_NAMES.end(), [&](pair<OMX_ALG_THREAD const, char const*> const& threadName) {
+      return entry.compare(0, separator, threadName.second) == 0;
+    });
+    ThreadScheduling scheduling {};
+
+    if(separator == string::npos || thread == THREAD_NAMES.end() || !ParseThreadScheduling(entry.substr(separator + 1), scheduling))
+    {
+      LOG_ERROR(string { "Ignored thread scheduling entry: " } +entry);
+      continue;
+    }
+
+    if(thread->first == OMX_ALG_THREAD_MODULE)
+    {
+      module->SetDynamic(DYNAMIC_INDEX_THREAD_SCHEDULING, &scheduling);
+      continue;
+    }
+
+    unique_lock<std::mutex> lock(processorsMutex);
+    threadSchedulings[thread->first] = scheduling;
+    ApplyThreadScheduling(thread->first);
+  }
+}
+
+void Component::GetCpuUsage(OMX_ALG_CONFIG_CPU_USAGE& usage)
+{
+  ModuleCpuTime moduleCpuTime {};
+
+  if(module->GetDynamic(DYNAMIC_INDEX_CPU_TIME, &moduleCpuTime) != ModuleInterface::SUCCESS)
+    moduleCpuTime = ModuleCpuTime {};
+
+  unique_lock<std::mutex> lock(processorsMutex);
+  usage.nFrames = outputFrames;
+  usage.nCommandsCpuTime = processorMain->GetStatistics().cpuTime;
+  usage.nEmptyCpuTime = flushedEmptyStatistics.cpuTime + processorEmpty->GetStatistics().cpuTime;
+  usage.nFillCpuTime = flushedFillStatistics.cpuTime + processorFill->GetStatistics().cpuTime;
+  usage.nModuleThreadsCpuTime = moduleCpuTime.threads;
+  usage.nModuleCallbacksCpuTime = moduleCpuTime.callbacks;
+}
+
 void Component::CleanFlushFillEmptyBuffers()
 {
   shared_ptr<promise<void>> signalPromise;
   signalPromise.reset(new promise<void> );
+  ThreadPool::BlockingScope blocking {};
   processorFill->queue(CreateTask(Command::Signal, state, signalPromise));
   signalPromise->get_future().wait();
   signalPromise.reset(new promise<void> );
@@ -1893,7 +2306,10 @@ void Component::TreatSetStateCommand(Task task)
     OMXChecker::CheckStateTransition(state, newState);
 
     if(isTransitionToIdleFromLoadedOrWaitResource(state, newState))
+    {
       PopulatingPorts();
+      ReleasePreparedBuffers();
+    }
 
     if(isTransitionToLoaded(state, newState) && (state != OMX_StateWaitForResources))
     {
@@ -1981,16 +2397,27 @@ void Component::TreatDisablePortCommand(Task task)
   bool isInput = IsInputPort(index);
   FlushFillEmptyBuffers(!isInput, isInput);
   BlockFillEmptyBuffers(true, shouldPrealloc);
+  auto isRunning = (state == OMX_StateExecuting || state == OMX_StatePause);
 
-  if(shouldPrealloc && shouldFireEventPortSettingsChanges && (state == OMX_StateExecuting || state == OMX_StatePause))
+  // The first of the ports disabled together
+  if(!isRunning)
+    disabledAt = chrono::steady_clock::time_point {};
+  else if(disabledAt == chrono::steady_clock::time_point {})
+    disabledAt = chrono::steady_clock::now();
+
+  if(shouldPrealloc && shouldFireEventPortSettingsChanges && isRunning)
   {
-    // Restart component
-    auto error = module->Restart();
+    /* A channel which holds no input gives back those it was given once encoded and gets the
+     * settings when the port is enabled. The inputs kept to reorder or to look ahead wait for the
+     * next ones, which the disabled port doesn't bring, and the outputs held by the channel only
+     * come back with a new one */
+    bool holdsInputs = true;
 
-    if(error)
-    {
+    if(isInput && module->GetDynamic(DYNAMIC_INDEX_HOLDS_INPUTS, &holdsInputs) != ModuleInterface::SUCCESS)
+      holdsInputs = true;
+
+    if((!isInput || holdsInputs) && module->Restart())
       LOG_ERROR("Restart did not complete clean");
-    }
 
     if(shouldFireEventPortSettingsChanges)
     {
@@ -1999,7 +2426,11 @@ void Component::TreatDisablePortCommand(Task task)
     }
   }
 
-  port->WaitEmpty();
+  {
+    // The application frees the buffers of the port at its pace
+    ThreadPool::BlockingScope blocking {};
+    port->WaitEmpty();
+  }
 
   if(port->error)
     return;
@@ -2009,6 +2440,64 @@ void Component::TreatDisablePortCommand(Task task)
   callbacks.EventHandler(component, app, OMX_EventCmdComplete, OMX_CommandPortDisable, index, nullptr);
 }
 
+/* The module creates the channel, the components which allocate the buffers of the ports prepare
+ * them. Nothing is left prepared when either fails */
+void Component::PrepareChannel(bool shouldPrepare)
+{
+  if(state != OMX_StateLoaded || transientState != TransientState::Max)
+    throw OMX_ErrorIncorrectStateOperation;
+
+  ReleasePreparedBuffers();
+  auto error = module->SetDynamic(DYNAMIC_INDEX_PREPARE_CHANNEL, &shouldPrepare);
+
+  if(error == ModuleInterface::BAD_INDEX)
+    throw OMX_ErrorUnsupportedIndex;
+
+  if(error)
+    throw ToOmxError(error);
+
+  if(!shouldPrepare)
+    return;
+
+  try
+  {
+    PrepareBuffers();
+  }
+  catch(OMX_ERRORTYPE&)
+  {
+    ReleasePreparedBuffers();
+    shouldPrepare = false;
+    module->SetDynamic(DYNAMIC_INDEX_PREPARE_CHANNEL, &shouldPrepare);
+    throw;
+  }
+}
+
+/* Applies the settings changed while a port was disabled, on the running channel when the module
+ * can absorb them. The downtime goes from the disabling of the port, it is counted in frame periods
+ * at the framerate of the channel */
+void Component::Reconfigure()
+{
+  auto start = disabledAt != chrono::steady_clock::time_point {} ? disabledAt : chrono::steady_clock::now();
+  disabledAt = chrono::steady_clock::time_point {};
+  auto isInPlace = module->SetDynamic(DYNAMIC_INDEX_RECONFIGURE, nullptr) == ModuleInterface::SUCCESS;
+
+  if(!isInPlace && module->Stop())
+    module->Start(true);
+
+  auto downtime = static_cast<uint64_t>(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+  Clock clock {};
+  uint64_t downtimeFrames = 0;
+
+  if(media->Get(SETTINGS_INDEX_CLOCK, &clock) == SettingsInterface::SUCCESS && clock.clockratio)
+    downtimeFrames = downtime * clock.framerate * 1000 / clock.clockratio / 1000000;
+
+  ++reconfigurations;
+  reconfigInPlace += isInPlace;
+  reconfigDowntime += downtime;
+  reconfigLostFrames += downtimeFrames;
+  LOG_IMPORTANT(string { isInPlace ? "Reconfigured in place" : "Reconfigured with a new channel" } +" in " + to_string(downtime) + "us (" + to_string(downtimeFrames) + " frames)");
+}
+
 void Component::TreatEnablePortCommand(Task task)
 {
   assert(task.cmd == Command::EnablePort);
@@ -2023,7 +2512,10 @@ void Component::TreatEnablePortCommand(Task task)
   }
 
   if(state != OMX_StateLoaded && state != OMX_StateWaitForResources)
+  {
+    ThreadPool::BlockingScope blocking {};
     port->WaitFull();
+  }
 
   if(port->error)
     return;
@@ -2032,8 +2524,7 @@ void Component::TreatEnablePortCommand(Task task)
 
   if(shouldPrealloc && shouldFireEventPortSettingsChanges && (state == OMX_StateExecuting || state == OMX_StatePause))
   {
-    if(module->Stop())
-      module->Start(true);
+    Reconfigure();
 
     if(shouldFireEventPortSettingsChanges)
     {
@@ -2042,6 +2533,9 @@ void Component::TreatEnablePortCommand(Task task)
     }
   }
 
+  if(input.enable && output.enable && !input.isTransientToEnable && !output.isTransientToEnable)
+    disabledAt = chrono::steady_clock::time_point {};
+
   if(input.enable && output.enable && !input.isTransientToEnable && !output.isTransientToEnable && state != OMX_StatePause)
     UnblockFillEmptyBuffers();
 
@@ -2126,28 +2620,6 @@ void Component::TreatFillBufferCommand(Task task)
   assert(success);
 }
 
-static RegionQuality CreateRegionQualityByPreset(OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST const& roi)
-{
-  RegionQuality rq {};
-  rq.region.point.x = roi.nLeft;
-  rq.region.point.y = roi.nTop;
-  rq.region.dimension.horizontal = roi.nWidth;
-  rq.region.dimension.vertical = roi.nHeight;
-  rq.quality.byPreset = ConvertOMXToMediaQualityPreset(roi.eQuality);
-  return rq;
-}
-
-static RegionQuality CreateRegionQualityByValue(OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST_BY_VALUE const& roi)
-{
-  RegionQuality rq {};
-  rq.region.point.x = roi.nLeft;
-  rq.region.point.y = roi.nTop;
-  rq.region.dimension.horizontal = roi.nWidth;
-  rq.region.dimension.vertical = roi.nHeight;
-  rq.quality.byValue = ConvertOMXToMediaQualityValue(roi.nQuality);
-  return rq;
-}
-
 void Component::TreatDynamicCommand(Task task)
 {
   assert(task.cmd == Command::SetDynamic);
@@ -2221,12 +2693,43 @@ void Component::TreatDynamicCommand(Task task)
     shouldPushROI = true;
     return;
   }
+  case OMX_ALG_IndexConfigVideoRegionOfInterestList:
+  {
+    auto rql = static_cast<RegionQualityList*>(opt);
+
+    /* The list is added in one call so that no frame sees it partially applied. A clear
+     * pending since the last frame goes first, as for the single regions */
+    if(shouldClearROI && !rql->replace)
+      module->SetDynamic(DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_CLEAR, nullptr);
+    shouldClearROI = false;
+
+    module->SetDynamic(DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_LIST, rql);
+    shouldPushROI = true;
+    return;
+  }
   case OMX_ALG_IndexConfigVideoNotifySceneChange:
   {
     auto notifySceneChange = static_cast<OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE*>(opt);
     module->SetDynamic(DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE, (void*)(static_cast<intptr_t>(notifySceneChange->nLookAhead)));
     return;
   }
+  case OMX_ALG_IndexConfigVideoSceneChangeAnalysis:
+  {
+    auto analysis = static_cast<OMX_ALG_VIDEO_CONFIG_SCENE_CHANGE_ANALYSIS*>(opt);
+    SceneChangeAnalysis moduleAnalysis {};
+    moduleAnalysis.isEnabled = analysis->bEnableAnalysis == OMX_TRUE;
+    module->SetDynamic(DYNAMIC_INDEX_SCENE_CHANGE_ANALYSIS, &moduleAnalysis);
+    return;
+  }
+  case OMX_ALG_IndexConfigVideoStaticFrameSkip:
+  {
+    auto skip = static_cast<OMX_ALG_VIDEO_CONFIG_STATIC_FRAME_SKIP*>(opt);
+    StaticFrameSkip moduleSkip {};
+    moduleSkip.isEnabled = skip->bEnableSkip == OMX_TRUE;
+    moduleSkip.maxConsecutiveSkips = skip->nMaxConsecutiveSkips;
+    module->SetDynamic(DYNAMIC_INDEX_STATIC_FRAME_SKIP, &moduleSkip);
+    return;
+  }
   case OMX_ALG_IndexConfigVideoInsertLongTerm:
   {
     module->SetDynamic(DYNAMIC_INDEX_IS_LONG_TERM, nullptr);
@@ -2273,8 +2776,10 @@ void Component::TreatDynamicCommand(Task task)
   case OMX_ALG_IndexConfigVideoQuantizationParameterTable:
   {
     auto data = static_cast<OMX_ALG_VIDEO_CONFIG_DATA*>(opt);
-    module->SetDynamic(DYNAMIC_INDEX_INSERT_QUANTIZATION_PARAMETER_BUFFER, data->pBuffer + data->nOffset);
-    delete[] data->pBuffer;
+
+    /* On success, the module takes the ownership of the table */
+    if(module->SetDynamic(DYNAMIC_INDEX_INSERT_QUANTIZATION_PARAMETER_BUFFER, data->pBuffer) != ModuleInterface::SUCCESS)
+      module->Free(data->pBuffer);
     return;
   }
   case OMX_ALG_IndexConfigVideoLoopFilterBeta:
@@ -2297,6 +2802,7 @@ void Component::TreatDynamicCommand(Task task)
 static void TreatSharedFenceCommand(Task* task)
 {
   auto p = (shared_future<void>*)task->opt.get();
+  ThreadPool::BlockingScope blocking {};
   p->wait();
 }
 
@@ -14,10 +14,12 @@
 #include "omx_expertise_interface.h"
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <memory>
 #include <future>
+#include <map>
 #include <cassert>
 #include <utility/logger.h>
 #include <utility/omx_translate.h>
@@ -115,9 +117,22 @@ protected:
 
   EOSHandles eosHandles;
 
+  std::shared_ptr<ThreadPool> threadPool; // the processors have their own threads without it
   std::unique_ptr<ProcessorFifo<Task>> processorMain;
   std::unique_ptr<ProcessorFifo<Task>> processorEmpty;
   std::unique_ptr<ProcessorFifo<Task>> processorFill;
+  std::mutex processorsMutex;
+  std::map<OMX_ALG_THREAD, ThreadScheduling> threadSchedulings; // reapplied to the recreated processors
+  ProcessorFifoStatistics flushedEmptyStatistics;
+  ProcessorFifoStatistics flushedFillStatistics;
+  std::atomic<uint64_t> inputFrames;
+  std::atomic<uint64_t> outputFrames;
+  std::atomic<uint64_t> reconfigurations {};
+  std::atomic<uint64_t> reconfigInPlace {};
+  std::atomic<uint64_t> reconfigDowntime {};
+  std::atomic<uint64_t> reconfigLostFrames {};
+  std::chrono::steady_clock::time_point disabledAt {}; // only used by main
+  LatencyTracker latency;
   std::shared_ptr<std::promise<void>> pauseFillPromise;
   std::shared_ptr<std::promise<void>> pauseEmptyPromise;
   void _ProcessMain(Task task);
@@ -138,6 +153,15 @@ protected:
   void BlockFillEmptyBuffers(bool fill, bool empty);
   void UnblockFillEmptyBuffers();
   void FlushEosHandles();
+  void GetStatistics(OMX_ALG_CONFIG_STATISTICS& statistics);
+  void GetCpuUsage(OMX_ALG_CONFIG_CPU_USAGE& usage);
+  void Reconfigure();
+  void PrepareChannel(bool shouldPrepare);
+  virtual void PrepareBuffers() {}
+  virtual void ReleasePreparedBuffers() {}
+  ProcessorFifo<Task>* GetProcessor(OMX_ALG_THREAD thread);
+  bool ApplyThreadScheduling(OMX_ALG_THREAD thread);
+  void SetThreadSchedulingsFromEnvironment();
   virtual void FlushComponent();
 
   void CreateCommand(OMX_COMMANDTYPE command, OMX_U32 param, OMX_PTR data);
@@ -14,12 +14,18 @@
 
 using namespace std;
 
+/* Only the hardware module knows about dma buffers */
 static DecModule& ToDecModule(ModuleInterface& module)
 {
-  return dynamic_cast<DecModule &>(module);
+  auto decModule = dynamic_cast<DecModule*>(&module);
+
+  if(!decModule)
+    throw OMX_ErrorNotImplemented;
+
+  return *decModule;
 }
 
-DecComponent::DecComponent(OMX_HANDLETYPE component, shared_ptr<SettingsInterface> media, std::unique_ptr<DecModule>&& module, OMX_STRING name, OMX_STRING role, std::unique_ptr<ExpertiseInterface>&& expertise) :
+DecComponent::DecComponent(OMX_HANDLETYPE component, shared_ptr<SettingsInterface> media, std::unique_ptr<ModuleInterface>&& module, OMX_STRING name, OMX_STRING role, std::unique_ptr<ExpertiseInterface>&& expertise) :
   Component{component, media, std::move(module), std::move(expertise), name, role},
   oldTimeStamp{-1},
   dataHasBeenPropagated{false}
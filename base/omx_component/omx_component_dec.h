@@ -11,7 +11,7 @@
 
 struct DecComponent final : Component
 {
-  DecComponent(OMX_HANDLETYPE component, std::shared_ptr<SettingsInterface>, std::unique_ptr<DecModule>&& module, OMX_STRING name, OMX_STRING role, std::unique_ptr<ExpertiseInterface>&& expertise);
+  DecComponent(OMX_HANDLETYPE component, std::shared_ptr<SettingsInterface>, std::unique_ptr<ModuleInterface>&& module, OMX_STRING name, OMX_STRING role, std::unique_ptr<ExpertiseInterface>&& expertise);
   ~DecComponent() override;
   OMX_ERRORTYPE AllocateBuffer(OMX_INOUT OMX_BUFFERHEADERTYPE** header, OMX_IN OMX_U32 index, OMX_IN OMX_PTR app, OMX_IN OMX_U32 size) override;
   OMX_ERRORTYPE FreeBuffer(OMX_IN OMX_U32 index, OMX_IN OMX_BUFFERHEADERTYPE* header) override;
@@ -8,6 +8,7 @@
 #include <OMX_IVCommonAlg.h>
 #include <OMX_CoreAlg.h>
 
+#include <algorithm>
 #include <cmath>
 #include <utility>
 
@@ -17,9 +18,15 @@
 
 using namespace std;
 
+/* Only the hardware module knows about dma buffers */
 static EncModule& ToEncModule(ModuleInterface& module)
 {
-  return dynamic_cast<EncModule &>(module);
+  auto encModule = dynamic_cast<EncModule*>(&module);
+
+  if(!encModule)
+    throw OMX_ErrorNotImplemented;
+
+  return *encModule;
 }
 
 static BufferHandleType GetBufferHandlePort(shared_ptr<SettingsInterface> media, OMX_IN OMX_U32 index)
@@ -30,7 +37,7 @@ static BufferHandleType GetBufferHandlePort(shared_ptr<SettingsInterface> media,
   return bufferHandlePort;
 }
 
-EncComponent::EncComponent(OMX_HANDLETYPE component, shared_ptr<SettingsInterface> media, std::unique_ptr<EncModule>&& module, OMX_STRING name, OMX_STRING role, std::unique_ptr<ExpertiseInterface>&& expertise) :
+EncComponent::EncComponent(OMX_HANDLETYPE component, shared_ptr<SettingsInterface> media, std::unique_ptr<ModuleInterface>&& module, OMX_STRING name, OMX_STRING role, std::unique_ptr<ExpertiseInterface>&& expertise) :
   Component{component, media, std::move(module), std::move(expertise), name, role}
 {
 }
@@ -41,6 +48,24 @@ void EncComponent::EmptyThisBufferCallBack(BufferHandleInterface* handle)
 {
   assert(handle);
   auto header = ((OMXBufferHandle*)(handle))->header;
+
+  /* An input skipped by the module is never associated to an output */
+  if(seisMap.Exist(handle))
+  {
+    for(auto sei : seisMap.Pop(handle))
+      delete[]sei.configSei.pBuffer;
+
+    /* The flush that follows gives its end of stream to the output */
+    if(IsEOSDetected(header->nFlags) && !eosHandles.input)
+    {
+      eosHandles.input = handle;
+      return;
+    }
+
+    if(IsCompMarked(header->hMarkTargetComponent, component))
+      callbacks.EventHandler(component, app, OMX_EventMark, 0, 0, header->pMarkData);
+  }
+
   delete handle;
 
   if(roiMap.Exist(header))
@@ -52,7 +77,7 @@ void EncComponent::EmptyThisBufferCallBack(BufferHandleInterface* handle)
   ReturnEmptiedBuffer(header);
 }
 
-static void AddEncoderFlags(OMX_BUFFERHEADERTYPE* header, shared_ptr<SettingsInterface> media, EncModule& module)
+static void AddEncoderFlags(OMX_BUFFERHEADERTYPE* header, shared_ptr<SettingsInterface> media, ModuleInterface& module)
 {
   Flags flags;
   auto success = module.GetDynamic(DYNAMIC_INDEX_STREAM_FLAGS, &flags);
@@ -90,7 +115,7 @@ void EncComponent::AssociateCallBack(BufferHandleInterface* empty_, BufferHandle
 
   PropagateHeaderData(*emptyHeader, *fillHeader);
 
-  AddEncoderFlags(fillHeader, media, ToEncModule(*module));
+  AddEncoderFlags(fillHeader, media, *module);
 
   /* backward datacorrupt to source buffer */
   if(fillHeader->nFlags & OMX_BUFFERFLAG_DATACORRUPT)
@@ -188,7 +213,14 @@ uint8_t* EncComponent::AllocateROIBuffer()
 {
   int roiSize;
   module->GetDynamic(DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE, &roiSize);
-  return static_cast<uint8_t*>(calloc(roiSize, sizeof(uint8_t)));
+  /* Allocated by the module so the ROI buffer is attached to the encoder without copy */
+  auto roiBuffer = static_cast<uint8_t*>(module->Allocate(roiSize * sizeof(uint8_t)));
+
+  if(!roiBuffer)
+    throw OMX_ErrorInsufficientResources;
+
+  memset(roiBuffer, 0, roiSize * sizeof(uint8_t));
+  return roiBuffer;
 }
 
 OMX_ERRORTYPE EncComponent::UseBuffer(OMX_OUT OMX_BUFFERHEADERTYPE** header, OMX_IN OMX_U32 index, OMX_IN OMX_PTR app, OMX_IN OMX_U32 size, OMX_IN OMX_U8* buffer)
@@ -236,10 +268,10 @@ OMX_ERRORTYPE EncComponent::AllocateBuffer(OMX_INOUT OMX_BUFFERHEADERTYPE** head
 
   auto bufferHandlePort = GetBufferHandlePort(media, index);
   bool dmaOnPort = (bufferHandlePort == BufferHandleType::BUFFER_HANDLE_FD);
-  auto buffer = dmaOnPort ? reinterpret_cast<OMX_U8*>(ToEncModule(*module).AllocateDMA(size * sizeof(OMX_U8))) : static_cast<OMX_U8*>(module->Allocate(size * sizeof(OMX_U8)));
+  OMX_U8* buffer;
 
-  if(dmaOnPort ? (static_cast<int>((intptr_t)buffer) < 0) : !buffer)
-    throw OMX_ErrorInsufficientResources;
+  if(!TakePreparedBuffer(index, dmaOnPort, size, buffer))
+    buffer = AllocatePortBuffer(dmaOnPort, size);
 
   *header = AllocateHeader(app, size, buffer, true, index);
   assert(*header);
@@ -262,7 +294,79 @@ OMX_ERRORTYPE EncComponent::AllocateBuffer(OMX_INOUT OMX_BUFFERHEADERTYPE** head
 
 void EncComponent::DestroyROIBuffer(uint8_t* roiBuffer)
 {
-  free(roiBuffer);
+  module->Free(roiBuffer);
+}
+
+OMX_U8* EncComponent::AllocatePortBuffer(bool dmaOnPort, OMX_U32 size)
+{
+  auto buffer = dmaOnPort ? reinterpret_cast<OMX_U8*>(ToEncModule(*module).AllocateDMA(size * sizeof(OMX_U8))) : static_cast<OMX_U8*>(module->Allocate(size * sizeof(OMX_U8)));
+
+  if(dmaOnPort ? (static_cast<int>((intptr_t)buffer) < 0) : !buffer)
+    throw OMX_ErrorInsufficientResources;
+
+  return buffer;
+}
+
+void EncComponent::FreePortBuffer(bool dmaOnPort, OMX_U8* buffer)
+{
+  dmaOnPort ? ToEncModule(*module).FreeDMA(static_cast<int>((intptr_t)buffer)) : module->Free(buffer);
+}
+
+bool EncComponent::TakePreparedBuffer(OMX_U32 index, bool dmaOnPort, OMX_U32 size, OMX_U8*& buffer)
+{
+  lock_guard<mutex> lock(preparedBuffersMutex);
+  auto prepared = find_if(preparedBuffers.begin(), preparedBuffers.end(), [&](PreparedBuffer const& prepared) {
+    return prepared.index == index && prepared.dmaOnPort == dmaOnPort && prepared.size >= size;
+  });
+
+  if(prepared == preparedBuffers.end())
+    return false;
+
+  buffer = prepared->buffer;
+  preparedBuffers.erase(prepared);
+  return true;
+}
+
+/* As many buffers as the port definitions ask for, the application may still use its own */
+void EncComponent::PrepareBuffers()
+{
+  for(auto port : { &input, &output })
+  {
+    OMX_PARAM_PORTDEFINITIONTYPE definition;
+    ConstructPortDefinition(definition, *port, media);
+    bool dmaOnPort = (GetBufferHandlePort(media, port->index) == BufferHandleType::BUFFER_HANDLE_FD);
+
+    for(OMX_U32 i = 0; i < definition.nBufferCountActual; ++i)
+    {
+      auto buffer = AllocatePortBuffer(dmaOnPort, definition.nBufferSize);
+      lock_guard<mutex> lock(preparedBuffersMutex);
+      preparedBuffers.push_back(PreparedBuffer { static_cast<OMX_U32>(port->index), dmaOnPort, definition.nBufferSize, buffer });
+    }
+  }
+}
+
+void EncComponent::ReleasePreparedBuffers()
+{
+  lock_guard<mutex> lock(preparedBuffersMutex);
+
+  for(auto const& prepared : preparedBuffers)
+    FreePortBuffer(prepared.dmaOnPort, prepared.buffer);
+
+  preparedBuffers.clear();
+}
+
+/* A prepared channel doesn't outlive the component */
+void EncComponent::ComponentDeInit()
+{
+  ReleasePreparedBuffers();
+
+  if(state == OMX_StateLoaded)
+  {
+    bool shouldPrepare = false;
+    module->SetDynamic(DYNAMIC_INDEX_PREPARE_CHANNEL, &shouldPrepare);
+  }
+
+  Component::ComponentDeInit();
 }
 
 OMX_ERRORTYPE EncComponent::FreeBuffer(OMX_IN OMX_U32 index, OMX_IN OMX_BUFFERHEADERTYPE* header)
@@ -280,7 +384,7 @@ OMX_ERRORTYPE EncComponent::FreeBuffer(OMX_IN OMX_U32 index, OMX_IN OMX_BUFFERHE
   {
     auto bufferHandlePort = GetBufferHandlePort(media, index);
     bool dmaOnPort = (bufferHandlePort == BufferHandleType::BUFFER_HANDLE_FD);
-    dmaOnPort ? ToEncModule(*module).FreeDMA(static_cast<int>((intptr_t)header->pBuffer)) : module->Free(header->pBuffer);
+    FreePortBuffer(dmaOnPort, header->pBuffer);
   }
 
   if(IsInputPort(index))
@@ -10,15 +10,21 @@
 
 struct EncComponent final : public Component
 {
-  EncComponent(OMX_HANDLETYPE component, std::shared_ptr<SettingsInterface> media, std::unique_ptr<EncModule>&& module, OMX_STRING name, OMX_STRING role, std::unique_ptr<ExpertiseInterface>&& expertise);
+  EncComponent(OMX_HANDLETYPE component, std::shared_ptr<SettingsInterface> media, std::unique_ptr<ModuleInterface>&& module, OMX_STRING name, OMX_STRING role, std::unique_ptr<ExpertiseInterface>&& expertise);
   ~EncComponent() override;
   OMX_ERRORTYPE AllocateBuffer(OMX_INOUT OMX_BUFFERHEADERTYPE** header, OMX_IN OMX_U32 index, OMX_IN OMX_PTR app, OMX_IN OMX_U32 size) override;
   OMX_ERRORTYPE UseBuffer(OMX_OUT OMX_BUFFERHEADERTYPE** header, OMX_IN OMX_U32 index, OMX_IN OMX_PTR app, OMX_IN OMX_U32 size, OMX_IN OMX_U8* buffer) override;
   OMX_ERRORTYPE FreeBuffer(OMX_IN OMX_U32 index, OMX_IN OMX_BUFFERHEADERTYPE* header) override;
+  void ComponentDeInit() override;
 
 private:
   uint8_t* AllocateROIBuffer();
   void DestroyROIBuffer(uint8_t* roiBuffer);
+  OMX_U8* AllocatePortBuffer(bool dmaOnPort, OMX_U32 size);
+  void FreePortBuffer(bool dmaOnPort, OMX_U8* buffer);
+  bool TakePreparedBuffer(OMX_U32 index, bool dmaOnPort, OMX_U32 size, OMX_U8*& buffer);
+  void PrepareBuffers() override;
+  void ReleasePreparedBuffers() override;
   void EmptyThisBufferCallBack(BufferHandleInterface* handle) override;
   void AssociateCallBack(BufferHandleInterface* empty, BufferHandleInterface* fill) override;
   void FillThisBufferCallBack(BufferHandleInterface* filled) override;
@@ -28,4 +34,16 @@ private:
   ThreadSafeMap<OMX_BUFFERHEADERTYPE*, uint8_t*> roiDestroyMap;
 
   ThreadSafeMap<BufferHandleInterface*, std::vector<OMXSei>> seisMap;
+
+  /* Allocated with the prepared channel, handed out by AllocateBuffer */
+  struct PreparedBuffer
+  {
+    OMX_U32 index;
+    bool dmaOnPort;
+    OMX_U32 size;
+    OMX_U8* buffer;
+  };
+
+  std::mutex preparedBuffersMutex;
+  std::vector<PreparedBuffer> preparedBuffers;
 };
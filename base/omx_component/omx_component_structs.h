@@ -7,6 +7,9 @@
 
 #include <utility/processor_fifo.h>
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <mutex>
 #include <memory>
 
@@ -51,6 +54,14 @@ struct Task
   std::shared_ptr<void> opt;
 };
 
+struct PortStatistics
+{
+  uint64_t waitFullBlocked = 0;
+  uint64_t waitFullTime = 0; // microseconds
+  uint64_t waitEmptyBlocked = 0;
+  uint64_t waitEmptyTime = 0; // microseconds
+};
+
 struct Port
 {
   Port(int index, int expected) :
@@ -98,6 +109,7 @@ struct Port
   {
     std::lock_guard<std::mutex> lock(mutex);
     buffers.push_back(header);
+    memory += header->nAllocLen;
 
     if((int)buffers.size() < expected)
       return;
@@ -109,7 +121,11 @@ struct Port
   void Remove(OMX_BUFFERHEADERTYPE* header)
   {
     std::lock_guard<std::mutex> lock(mutex);
-    buffers.erase(std::remove(buffers.begin(), buffers.end(), header), buffers.end());
+    auto it = std::remove(buffers.begin(), buffers.end(), header);
+
+    if(it != buffers.end())
+      memory -= header->nAllocLen;
+    buffers.erase(it, buffers.end());
 
     if((buffers.size() > 0 || expected == 0))
       return;
@@ -121,24 +137,103 @@ struct Port
   void WaitEmpty()
   {
     std::unique_lock<std::mutex> lck(mutex);
-    cv_empty.wait(lck, [&] {
-      return !playable || expected == 0 || error;
-    });
+    auto isEmpty = [&] {
+                     return !playable || expected == 0 || error;
+                   };
+
+    if(isEmpty())
+      return;
+
+    auto start = std::chrono::steady_clock::now();
+    cv_empty.wait(lck, isEmpty);
+    ++statistics.waitEmptyBlocked;
+    statistics.waitEmptyTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
   }
 
   void WaitFull()
   {
     std::unique_lock<std::mutex> lck(mutex);
-    cv_full.wait(lck, [&] {
-      return playable || error;
-    });
+    auto isFull = [&] {
+                    return playable || error;
+                  };
+
+    if(isFull())
+      return;
+
+    auto start = std::chrono::steady_clock::now();
+    cv_full.wait(lck, isFull);
+    ++statistics.waitFullBlocked;
+    statistics.waitFullTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  PortStatistics GetStatistics()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return statistics;
+  }
+
+  /* Bytes of the buffers currently populating the port */
+  uint64_t GetMemory()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return memory;
   }
 
 private:
   int expected;
+  PortStatistics statistics;
+  uint64_t memory = 0;
 
   std::mutex mutex;
   std::vector<OMX_BUFFERHEADERTYPE*> buffers;
   std::condition_variable cv_full;
   std::condition_variable cv_empty;
 };
+
+/* Matches the outputted frames with their input through the propagated timestamp */
+struct LatencyTracker
+{
+  void Arrived(OMX_TICKS timestamp)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if(arrivals.size() >= MAX_PENDING)
+      arrivals.pop_front();
+
+    arrivals.push_back(std::make_pair(timestamp, std::chrono::steady_clock::now()));
+  }
+
+  void Departed(OMX_TICKS timestamp)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto arrival = std::find_if(arrivals.begin(), arrivals.end(), [timestamp](Arrival const& arrival) {
+      return arrival.first == timestamp;
+    });
+
+    if(arrival == arrivals.end())
+      return;
+
+    cumulativeLatency += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - arrival->second).count();
+    ++count;
+    arrivals.erase(arrival);
+  }
+
+  void Get(uint64_t& cumulativeLatency, uint64_t& count)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    cumulativeLatency = this->cumulativeLatency;
+    count = this->count;
+  }
+
+private:
+  using Arrival = std::pair<OMX_TICKS, std::chrono::steady_clock::time_point>;
+
+  /* Inputs that never produce a frame must not grow the fifo forever: the oldest arrival goes
+   * first, whatever the order of the timestamps */
+  static size_t constexpr MAX_PENDING = 64;
+
+  std::mutex mutex;
+  std::deque<Arrival> arrivals;
+  uint64_t cumulativeLatency = 0; // microseconds
+  uint64_t count = 0;
+};
@@ -236,6 +236,18 @@ OMX_ALG_BUFFER_MODE ConvertMediaToOMXBufferHandle(BufferHandleType handle)
   }
 }
 
+OMX_ALG_THREAD_POLICY ConvertMediaToOMXSchedulingPolicy(SchedulingPolicy policy)
+{
+  switch(policy)
+  {
+  case SchedulingPolicy::OTHER: return OMX_ALG_THREAD_POLICY_OTHER;
+  case SchedulingPolicy::FIFO: return OMX_ALG_THREAD_POLICY_FIFO;
+  case SchedulingPolicy::ROUND_ROBIN: return OMX_ALG_THREAD_POLICY_ROUND_ROBIN;
+  default:
+    throw invalid_argument("policy");
+  }
+}
+
 bool ConvertOMXToMediaBool(OMX_BOOL boolean)
 {
   switch(boolean)
@@ -428,6 +440,21 @@ BufferHandleType ConvertOMXToMediaBufferHandle(OMX_ALG_BUFFER_MODE bufferMode)
   throw invalid_argument("bufferMode");
 }
 
+SchedulingPolicy ConvertOMXToMediaSchedulingPolicy(OMX_ALG_THREAD_POLICY policy)
+{
+  switch(policy)
+  {
+  case OMX_ALG_THREAD_POLICY_OTHER: return SchedulingPolicy::OTHER;
+  case OMX_ALG_THREAD_POLICY_FIFO: return SchedulingPolicy::FIFO;
+  case OMX_ALG_THREAD_POLICY_ROUND_ROBIN: return SchedulingPolicy::ROUND_ROBIN;
+  case OMX_ALG_THREAD_POLICY_MAX_ENUM: // fallthrough
+  default:
+    throw invalid_argument("policy");
+  }
+
+  throw invalid_argument("policy");
+}
+
 DecodedPictureBufferType ConvertOMXToMediaDecodedPictureBuffer(OMX_ALG_EDpbMode mode)
 {
   switch(mode)
@@ -9,6 +9,7 @@
 
 #include "module/module_enums.h"
 #include "module/module_structs.h"
+#include <utility/thread_scheduling.h>
 
 Format ConvertOMXToMediaFormat(OMX_COLOR_FORMATTYPE format);
 OMX_COLOR_FORMATTYPE ConvertMediaToOMXFormat(Format format);
@@ -26,6 +27,9 @@ OMX_BOOL ConvertMediaToOMXBool(bool boolean);
 BufferHandleType ConvertOMXToMediaBufferHandle(OMX_ALG_BUFFER_MODE bufferMode);
 OMX_ALG_BUFFER_MODE ConvertMediaToOMXBufferHandle(BufferHandleType handle);
 
+SchedulingPolicy ConvertOMXToMediaSchedulingPolicy(OMX_ALG_THREAD_POLICY policy);
+OMX_ALG_THREAD_POLICY ConvertMediaToOMXSchedulingPolicy(SchedulingPolicy policy);
+
 DecodedPictureBufferType ConvertOMXToMediaDecodedPictureBuffer(OMX_ALG_EDpbMode mode);
 OMX_ALG_EDpbMode ConvertMediaToOMXDecodedPictureBuffer(DecodedPictureBufferType mode);
 
@@ -7,6 +7,8 @@
 #include "module/module_dec.h"
 
 #include "module/device_dec_hardware_riscv.h"
+#include "module/module_mock.h"
+#include "utility/shared_instances.h"
 
 #include <utility>
 #include <cstring>
@@ -33,6 +35,29 @@ static char const* RISCV_DEVICE_DEC_NAME()
   return "/dev/al_d3xx";
 }
 
+static SharedInstances<string, DecDeviceHardwareRiscV> sharedDevices;
+static SharedInstances<string, AL_TAllocator> sharedAllocators;
+
+/* The channels opened on a device share its context and its allocator */
+static shared_ptr<DecDeviceHardwareRiscV> GetSharedDevice(string const& deviceName)
+{
+  return sharedDevices.Get(deviceName, [&]() {
+    return make_shared<DecDeviceHardwareRiscV>(deviceName);
+  });
+}
+
+static shared_ptr<AL_TAllocator> GetSharedAllocator(string const& deviceName, shared_ptr<DecDeviceHardwareRiscV> device)
+{
+  return sharedAllocators.Get(deviceName, [&]() {
+    // The allocator keeps the context it allocates from alive
+    return shared_ptr<AL_TAllocator> {
+      AL_Riscv_Decode_DmaAlloc_Create(device->GetDeviceContext()), [device](AL_TAllocator* allocator) {
+        AL_Allocator_Destroy(allocator);
+      }
+    };
+  });
+}
+
 #include "base/omx_component/omx_expertise_avc.h"
 #include "module/settings_dec_avc.h"
 
@@ -45,17 +70,8 @@ static DecComponent* GenerateAvcComponentRiscV(OMX_HANDLETYPE hComponent, OMX_ST
   if(nCoreParamIndex == OMX_ALG_CoreIndexDevice)
     deviceName = ((OMX_ALG_CORE_DEVICE*)pSettings)->cDevice;
 
-  shared_ptr<DecDeviceHardwareRiscV> device {
-    new DecDeviceHardwareRiscV {
-      deviceName
-    }
-  };
-
-  shared_ptr<AL_TAllocator> allocator = std::shared_ptr<AL_TAllocator> {
-    AL_Riscv_Decode_DmaAlloc_Create(device->GetDeviceContext()), [](AL_TAllocator* allocator) {
-      AL_Allocator_Destroy(allocator);
-    }
-  };
+  auto device = GetSharedDevice(deviceName);
+  auto allocator = GetSharedAllocator(deviceName, device);
 
   shared_ptr<DecSettingsAVC> media {
     new DecSettingsAVC {
@@ -88,17 +104,8 @@ static DecComponent* GenerateJpegComponentRiscV(OMX_HANDLETYPE hComponent, OMX_S
   if(nCoreParamIndex == OMX_ALG_CoreIndexDevice)
     deviceName = ((OMX_ALG_CORE_DEVICE*)pSettings)->cDevice;
 
-  shared_ptr<DecDeviceHardwareRiscV> device {
-    new DecDeviceHardwareRiscV {
-      deviceName
-    }
-  };
-
-  shared_ptr<AL_TAllocator> allocator = std::shared_ptr<AL_TAllocator> {
-    AL_Riscv_Decode_DmaAlloc_Create(device->GetDeviceContext()), [](AL_TAllocator* allocator) {
-      AL_Allocator_Destroy(allocator);
-    }
-  };
+  auto device = GetSharedDevice(deviceName);
+  auto allocator = GetSharedAllocator(deviceName, device);
 
   shared_ptr<DecSettingsJPEG> media {
     new DecSettingsJPEG {
@@ -126,27 +133,69 @@ static DecComponent* GenerateHevcComponentRiscV(OMX_HANDLETYPE hComponent, OMX_S
   if(nCoreParamIndex == OMX_ALG_CoreIndexDevice)
     deviceName = ((OMX_ALG_CORE_DEVICE*)pSettings)->cDevice;
 
-  shared_ptr<DecDeviceHardwareRiscV> device {
-    new DecDeviceHardwareRiscV {
-      deviceName
+  auto device = GetSharedDevice(deviceName);
+  auto allocator = GetSharedAllocator(deviceName, device);
+
+  shared_ptr<DecSettingsHEVC> media {
+    new DecSettingsHEVC {
+      device->GetBufferContiguities(), device->GetBufferBytesAlignments(), STRIDE_ALIGNMENTS_HARDWARE
+    }
+  };
+
+  unique_ptr<DecModule> module {
+    new DecModule {
+      media, device, allocator
+    }
+  };
+  unique_ptr<ExpertiseHEVC> expertise {
+    new ExpertiseHEVC {}
+  };
+  return new DecComponent {
+           hComponent, media, std::move(module), cComponentName, cRole, std::move(expertise)
+  };
+}
+
+static BufferContiguities constexpr MOCK_BUFFER_CONTIGUITIES {
+  true, true
+};
+
+static BufferBytesAlignments constexpr MOCK_BUFFER_BYTES_ALIGNMENTS {
+  64, 64
+};
+
+static DecComponent* GenerateAvcComponentMock(OMX_HANDLETYPE hComponent, OMX_STRING cComponentName, OMX_STRING cRole)
+{
+  shared_ptr<DecSettingsAVC> media {
+    new DecSettingsAVC {
+      MOCK_BUFFER_CONTIGUITIES, MOCK_BUFFER_BYTES_ALIGNMENTS, STRIDE_ALIGNMENTS_HARDWARE
     }
   };
 
-  shared_ptr<AL_TAllocator> allocator = std::shared_ptr<AL_TAllocator> {
-    AL_Riscv_Decode_DmaAlloc_Create(device->GetDeviceContext()), [](AL_TAllocator* allocator) {
-      AL_Allocator_Destroy(allocator);
+  unique_ptr<MockModule> module {
+    new MockModule {
+      GetMockModuleSettings(true)
     }
   };
+  unique_ptr<ExpertiseAVC> expertise {
+    new ExpertiseAVC {}
+  };
+
+  return new DecComponent {
+           hComponent, media, std::move(module), cComponentName, cRole, std::move(expertise)
+  };
+}
 
+static DecComponent* GenerateHevcComponentMock(OMX_HANDLETYPE hComponent, OMX_STRING cComponentName, OMX_STRING cRole)
+{
   shared_ptr<DecSettingsHEVC> media {
     new DecSettingsHEVC {
-      device->GetBufferContiguities(), device->GetBufferBytesAlignments(), STRIDE_ALIGNMENTS_HARDWARE
+      MOCK_BUFFER_CONTIGUITIES, MOCK_BUFFER_BYTES_ALIGNMENTS, STRIDE_ALIGNMENTS_HARDWARE
     }
   };
 
-  unique_ptr<DecModule> module {
-    new DecModule {
-      media, device, allocator
+  unique_ptr<MockModule> module {
+    new MockModule {
+      GetMockModuleSettings(true)
     }
   };
   unique_ptr<ExpertiseHEVC> expertise {
@@ -168,6 +217,12 @@ static OMX_PTR GenerateDefaultComponent(OMX_IN OMX_HANDLETYPE hComponent, OMX_IN
 
   if(!strncmp(cComponentName, "OMX.allegro.mjpeg.riscv.decoder", strlen(cComponentName)))
     return GenerateJpegComponentRiscV(hComponent, cComponentName, cRole, nCoreParamIndex, pSettings);
+
+  if(!strncmp(cComponentName, "OMX.allegro.h265.mock.decoder", strlen(cComponentName)))
+    return GenerateHevcComponentMock(hComponent, cComponentName, cRole);
+
+  if(!strncmp(cComponentName, "OMX.allegro.h264.mock.decoder", strlen(cComponentName)))
+    return GenerateAvcComponentMock(hComponent, cComponentName, cRole);
   return nullptr;
 }
 
@@ -13,6 +13,8 @@
 #endif
 
 #include "module/device_enc_hardware_riscv.h"
+#include "module/module_mock.h"
+#include "utility/shared_instances.h"
 
 #include <cstring>
 #include <memory>
@@ -65,6 +67,29 @@ static char const* RISCV_DEVICE_ENC_NAME()
   return "/dev/al_e2xx";
 }
 
+static SharedInstances<string, EncDeviceHardwareRiscV> sharedDevices;
+static SharedInstances<string, AL_TAllocator> sharedAllocators;
+
+/* The channels opened on a device share its context and its allocator */
+static shared_ptr<EncDeviceHardwareRiscV> GetSharedDevice(string const& deviceName)
+{
+  return sharedDevices.Get(deviceName, [&]() {
+    return make_shared<EncDeviceHardwareRiscV>(deviceName);
+  });
+}
+
+static shared_ptr<AL_TAllocator> GetSharedAllocator(string const& deviceName, shared_ptr<EncDeviceHardwareRiscV> device)
+{
+  return sharedAllocators.Get(deviceName, [&]() {
+    // The allocator keeps the context it allocates from alive
+    return shared_ptr<AL_TAllocator> {
+      AL_Riscv_Encode_DmaAlloc_Create(device->GetDeviceContext()), [device](AL_TAllocator* allocator) {
+        AL_Allocator_Destroy(allocator);
+      }
+    };
+  });
+}
+
 #include "base/omx_component/omx_expertise_avc.h"
 #include "module/settings_enc_avc.h"
 
@@ -77,17 +102,8 @@ static EncComponent* GenerateAvcComponentRiscV(OMX_HANDLETYPE hComponent, OMX_ST
   if(nCoreParamIndex == OMX_ALG_CoreIndexDevice)
     deviceName = ((OMX_ALG_CORE_DEVICE*)pSettings)->cDevice;
 
-  shared_ptr<EncDeviceHardwareRiscV> device {
-    new EncDeviceHardwareRiscV {
-      string(deviceName),
-    }
-  };
-
-  shared_ptr<AL_TAllocator> allocator = std::shared_ptr<AL_TAllocator> {
-    AL_Riscv_Encode_DmaAlloc_Create(device->GetDeviceContext()), [](AL_TAllocator* allocator) {
-      AL_Allocator_Destroy(allocator);
-    }
-  };
+  auto device = GetSharedDevice(deviceName);
+  auto allocator = GetSharedAllocator(deviceName, device);
 
   shared_ptr<EncSettingsAVC> media {
     new EncSettingsAVC {
@@ -120,17 +136,8 @@ static EncComponent* GenerateHevcComponentRiscV(OMX_HANDLETYPE hComponent, OMX_S
   if(nCoreParamIndex == OMX_ALG_CoreIndexDevice)
     deviceName = ((OMX_ALG_CORE_DEVICE*)pSettings)->cDevice;
 
-  shared_ptr<EncDeviceHardwareRiscV> device {
-    new EncDeviceHardwareRiscV {
-      string(deviceName),
-    }
-  };
-
-  shared_ptr<AL_TAllocator> allocator = std::shared_ptr<AL_TAllocator> {
-    AL_Riscv_Encode_DmaAlloc_Create(device->GetDeviceContext()), [](AL_TAllocator* allocator) {
-      AL_Allocator_Destroy(allocator);
-    }
-  };
+  auto device = GetSharedDevice(deviceName);
+  auto allocator = GetSharedAllocator(deviceName, device);
 
   shared_ptr<EncSettingsHEVC> media {
     new EncSettingsHEVC {
@@ -154,6 +161,63 @@ static EncComponent* GenerateHevcComponentRiscV(OMX_HANDLETYPE hComponent, OMX_S
   };
 }
 
+static BufferContiguities constexpr MOCK_BUFFER_CONTIGUITIES {
+  true, true
+};
+
+static BufferBytesAlignments constexpr MOCK_BUFFER_BYTES_ALIGNMENTS {
+  64, 64
+};
+
+static shared_ptr<AL_TAllocator> CreateMockAllocator()
+{
+  return shared_ptr<AL_TAllocator> {
+           AL_GetDefaultAllocator(), [](AL_TAllocator*) {}
+  };
+}
+
+static EncComponent* GenerateAvcComponentMock(OMX_HANDLETYPE hComponent, OMX_STRING cComponentName, OMX_STRING cRole)
+{
+  shared_ptr<EncSettingsAVC> media {
+    new EncSettingsAVC {
+      MOCK_BUFFER_CONTIGUITIES, MOCK_BUFFER_BYTES_ALIGNMENTS, STRIDE_ALIGNMENTS_AVC, IS_SEPARATE_CONFIGURATION_FROM_DATA_ENABLED, CreateMockAllocator()
+    }
+  };
+
+  unique_ptr<MockModule> module {
+    new MockModule {
+      GetMockModuleSettings(false)
+    }
+  };
+  unique_ptr<ExpertiseAVC> expertise {
+    new ExpertiseAVC {}
+  };
+  return new EncComponent {
+           hComponent, media, std::move(module), cComponentName, cRole, std::move(expertise)
+  };
+}
+
+static EncComponent* GenerateHevcComponentMock(OMX_HANDLETYPE hComponent, OMX_STRING cComponentName, OMX_STRING cRole)
+{
+  shared_ptr<EncSettingsHEVC> media {
+    new EncSettingsHEVC {
+      MOCK_BUFFER_CONTIGUITIES, MOCK_BUFFER_BYTES_ALIGNMENTS, STRIDE_ALIGNMENTS_HEVC, IS_SEPARATE_CONFIGURATION_FROM_DATA_ENABLED, CreateMockAllocator()
+    }
+  };
+
+  unique_ptr<MockModule> module {
+    new MockModule {
+      GetMockModuleSettings(false)
+    }
+  };
+  unique_ptr<ExpertiseHEVC> expertise {
+    new ExpertiseHEVC {}
+  };
+  return new EncComponent {
+           hComponent, media, std::move(module), cComponentName, cRole, std::move(expertise)
+  };
+}
+
 static OMX_PTR GenerateDefaultComponent(OMX_IN OMX_HANDLETYPE hComponent, OMX_IN OMX_STRING cComponentName, OMX_IN OMX_STRING cRole, OMX_IN OMX_ALG_COREINDEXTYPE nCoreParamIndex, OMX_IN OMX_PTR pSettings)
 {
 
@@ -162,6 +226,12 @@ static OMX_PTR GenerateDefaultComponent(OMX_IN OMX_HANDLETYPE hComponent, OMX_IN
 
   if(!strncmp(cComponentName, "OMX.allegro.h264.riscv.encoder", strlen(cComponentName)))
     return GenerateAvcComponentRiscV(hComponent, cComponentName, cRole, nCoreParamIndex, pSettings);
+
+  if(!strncmp(cComponentName, "OMX.allegro.h265.mock.encoder", strlen(cComponentName)))
+    return GenerateHevcComponentMock(hComponent, cComponentName, cRole);
+
+  if(!strncmp(cComponentName, "OMX.allegro.h264.mock.encoder", strlen(cComponentName)))
+    return GenerateAvcComponentMock(hComponent, cComponentName, cRole);
   return nullptr;
 }
 
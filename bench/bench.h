@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct BenchResult
+{
+  std::string name;
+  std::string params;
+  int64_t iterations;
+  double nsPerOp;
+};
+
+/* Collects timings and dumps them as json */
+struct Bench
+{
+  Bench(std::string filter) : filter{filter}
+  {
+  }
+
+  bool IsSelected(std::string const& name) const
+  {
+    return filter.empty() || name.find(filter) != std::string::npos;
+  }
+
+  /* Times iterations calls of op, after one untimed warm up call */
+  void Run(std::string const& name, std::string const& params, int64_t iterations, std::function<void()> const& op)
+  {
+    if(!IsSelected(name))
+      return;
+
+    op();
+    auto start = std::chrono::steady_clock::now();
+
+    for(int64_t i = 0; i < iterations; ++i)
+      op();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    Add(name, params, iterations, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+  }
+
+  void Add(std::string const& name, std::string const& params, int64_t iterations, std::chrono::nanoseconds elapsed)
+  {
+    if(!IsSelected(name))
+      return;
+
+    results.push_back(BenchResult { name, params, iterations, static_cast<double>(elapsed.count()) / iterations });
+  }
+
+  /* Records a check that went wrong, the executable then exits with an error */
+  void Fail(std::string const& name, std::string const& message)
+  {
+    failures.push_back(name + ": " + message);
+  }
+
+  std::vector<std::string> const& GetFailures() const
+  {
+    return failures;
+  }
+
+  void Dump(std::ostream& out) const
+  {
+    out << "{\n  \"benchmarks\": [";
+
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+      auto const& result = results[i];
+      out << (i ? ",\n" : "\n");
+      out << "    { \"name\": \"" << result.name << "\", \"params\": \"" << result.params << "\", \"iterations\": " << result.iterations << ", \"ns_per_op\": " << result.nsPerOp << " }";
+    }
+
+    out << "\n  ]\n}\n";
+  }
+
+private:
+  std::string filter;
+  std::vector<BenchResult> results;
+  std::vector<std::string> failures;
+};
+
+void BenchUtility(Bench& bench);
+void BenchRoi(Bench& bench);
+void BenchTwoPass(Bench& bench);
+void BenchYuv(Bench& bench);
+void BenchStream(Bench& bench);
+void BenchSceneChange(Bench& bench);
+void BenchStaticFrame(Bench& bench);
+void BenchSharedDevice(Bench& bench);
+void BenchWarmPool(Bench& bench);
+void BenchLoad(Bench& bench);
+void BenchReconfigure(Bench& bench);
+void BenchDensity(Bench& bench);
+void BenchThreadScheduling(Bench& bench);
@@ -0,0 +1,371 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench_component.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <OMX_Component.h>
+
+#include <base/omx_checker/omx_checker.h>
+
+using namespace std;
+
+static chrono::seconds constexpr TIMEOUT {
+  10
+};
+
+BenchComponent::~BenchComponent()
+{
+  Close();
+}
+
+BenchComponent::Port& BenchComponent::GetPort(OMX_U32 index)
+{
+  return index == input ? ports[0] : ports[1];
+}
+
+OMX_ERRORTYPE BenchComponent::Open(string const& name)
+{
+  auto ret = GetHandle(name);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  return SetState(OMX_StateIdle);
+}
+
+OMX_ERRORTYPE BenchComponent::GetHandle(string const& name)
+{
+  static OMX_CALLBACKTYPE callbacks {
+    OnEvent, OnEmptyBufferDone, OnFillBufferDone
+  };
+  auto ret = OMX_GetHandle(&handle, const_cast<char*>(name.c_str()), this, &callbacks);
+
+  if(ret != OMX_ErrorNone)
+  {
+    handle = nullptr;
+    return ret;
+  }
+
+  OMX_PORT_PARAM_TYPE videoPorts;
+  OMXChecker::SetHeaderVersion(videoPorts);
+  ret = OMX_GetParameter(handle, OMX_IndexParamVideoInit, &videoPorts);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  input = videoPorts.nStartPortNumber;
+  output = videoPorts.nStartPortNumber + 1;
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE BenchComponent::SetState(OMX_STATETYPE state)
+{
+  OMX_STATETYPE current;
+  auto ret = OMX_GetState(handle, &current);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  {
+    lock_guard<std::mutex> lock(mutex);
+    isStopping = (state != OMX_StateExecuting);
+  }
+
+  ret = OMX_SendCommand(handle, OMX_CommandStateSet, state, nullptr);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  if(current == OMX_StateLoaded && state == OMX_StateIdle)
+  {
+    for(auto index : { input, output })
+    {
+      ret = AllocateBuffers(index);
+
+      if(ret != OMX_ErrorNone)
+        return ret;
+    }
+  }
+
+  // The component gave all the buffers back when it left executing
+  if(current == OMX_StateIdle && state == OMX_StateLoaded)
+  {
+    FreeBuffers(input);
+    FreeBuffers(output);
+  }
+
+  return WaitCommand(OMX_CommandStateSet, state);
+}
+
+void BenchComponent::Close()
+{
+  if(!handle)
+    return;
+
+  OMX_STATETYPE state;
+
+  if(OMX_GetState(handle, &state) == OMX_ErrorNone)
+  {
+    if(state == OMX_StateExecuting || state == OMX_StatePause)
+      state = SetState(OMX_StateIdle) == OMX_ErrorNone ? OMX_StateIdle : OMX_StateInvalid;
+
+    if(state == OMX_StateIdle)
+      SetState(OMX_StateLoaded);
+  }
+
+  // Left by a transition which didn't complete
+  FreeBuffers(input);
+  FreeBuffers(output);
+  OMX_FreeHandle(handle);
+  handle = nullptr;
+
+  lock_guard<std::mutex> lock(mutex);
+  completions.clear();
+  error = OMX_ErrorNone;
+  isStopping = false;
+
+  for(auto& port : ports)
+    port.isEnabled = true;
+}
+
+OMX_ERRORTYPE BenchComponent::DisablePort(OMX_U32 index)
+{
+  auto& port = GetPort(index);
+  {
+    lock_guard<std::mutex> lock(mutex);
+    port.isEnabled = false;
+  }
+
+  auto ret = OMX_SendCommand(handle, OMX_CommandPortDisable, index, nullptr);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  {
+    unique_lock<std::mutex> lock(mutex);
+
+    if(!changed.wait_for(lock, TIMEOUT, [&]() {
+      return port.atComponent == 0 || error != OMX_ErrorNone;
+    }))
+      return OMX_ErrorTimeout;
+
+    if(error != OMX_ErrorNone)
+      return error;
+  }
+
+  FreeBuffers(index);
+  return WaitCommand(OMX_CommandPortDisable, index);
+}
+
+OMX_ERRORTYPE BenchComponent::EnablePort(OMX_U32 index)
+{
+  auto ret = OMX_SendCommand(handle, OMX_CommandPortEnable, index, nullptr);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  ret = AllocateBuffers(index);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  ret = WaitCommand(OMX_CommandPortEnable, index);
+
+  lock_guard<std::mutex> lock(mutex);
+  GetPort(index).isEnabled = true;
+  return ret;
+}
+
+OMX_ERRORTYPE BenchComponent::SetRawPort(int width, int height, int framerate)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE definition;
+  OMXChecker::SetHeaderVersion(definition);
+  definition.nPortIndex = input;
+  auto ret = OMX_GetParameter(handle, OMX_IndexParamPortDefinition, &definition);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  auto& video = definition.format.video;
+  video.nFrameWidth = width;
+  video.nFrameHeight = height;
+  video.nStride = 0;
+  video.nSliceHeight = 0;
+  video.xFramerate = framerate << 16;
+  return OMX_SetParameter(handle, OMX_IndexParamPortDefinition, &definition);
+}
+
+OMX_BUFFERHEADERTYPE* BenchComponent::Take(OMX_U32 index, chrono::milliseconds timeout)
+{
+  auto& port = GetPort(index);
+  unique_lock<std::mutex> lock(mutex);
+
+  if(!changed.wait_for(lock, timeout, [&]() {
+    return !port.available.empty();
+  }))
+    return nullptr;
+
+  auto header = port.available.front();
+  port.available.pop_front();
+  return header;
+}
+
+OMX_ERRORTYPE BenchComponent::Empty(OMX_BUFFERHEADERTYPE* header)
+{
+  auto& port = GetPort(input);
+  {
+    lock_guard<std::mutex> lock(mutex);
+    ++port.atComponent;
+  }
+
+  auto ret = OMX_EmptyThisBuffer(handle, header);
+
+  if(ret != OMX_ErrorNone)
+    Return(port, header, nullptr);
+
+  return ret;
+}
+
+OMX_ERRORTYPE BenchComponent::Fill(OMX_BUFFERHEADERTYPE* header)
+{
+  auto& port = GetPort(output);
+  {
+    lock_guard<std::mutex> lock(mutex);
+    ++port.atComponent;
+  }
+
+  auto ret = OMX_FillThisBuffer(handle, header);
+
+  if(ret != OMX_ErrorNone)
+    Return(port, header, nullptr);
+
+  return ret;
+}
+
+OMX_ERRORTYPE BenchComponent::AllocateBuffers(OMX_U32 index)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE definition;
+  OMXChecker::SetHeaderVersion(definition);
+  definition.nPortIndex = index;
+  auto ret = OMX_GetParameter(handle, OMX_IndexParamPortDefinition, &definition);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  auto& port = GetPort(index);
+
+  for(OMX_U32 i = 0; i < definition.nBufferCountActual; ++i)
+  {
+    OMX_BUFFERHEADERTYPE* header;
+    ret = OMX_AllocateBuffer(handle, &header, index, this, definition.nBufferSize);
+
+    if(ret != OMX_ErrorNone)
+      return ret;
+
+    lock_guard<std::mutex> lock(mutex);
+    port.buffers.push_back(header);
+    port.available.push_back(header);
+  }
+
+  return OMX_ErrorNone;
+}
+
+void BenchComponent::FreeBuffers(OMX_U32 index)
+{
+  auto& port = GetPort(index);
+  vector<OMX_BUFFERHEADERTYPE*> buffers;
+  {
+    lock_guard<std::mutex> lock(mutex);
+    buffers.swap(port.buffers);
+    port.available.clear();
+    port.atComponent = 0;
+  }
+
+  for(auto header : buffers)
+    OMX_FreeBuffer(handle, index, header);
+}
+
+OMX_ERRORTYPE BenchComponent::WaitCommand(OMX_COMMANDTYPE command, OMX_U32 data)
+{
+  unique_lock<std::mutex> lock(mutex);
+  auto isCompleted = [&](Completion const& completion) {
+                       return completion.command == static_cast<OMX_U32>(command) && completion.data == data;
+                     };
+
+  if(!changed.wait_for(lock, TIMEOUT, [&]() {
+    return error != OMX_ErrorNone || any_of(completions.begin(), completions.end(), isCompleted);
+  }))
+    return OMX_ErrorTimeout;
+
+  if(error != OMX_ErrorNone)
+    return error;
+
+  completions.erase(find_if(completions.begin(), completions.end(), isCompleted));
+  return OMX_ErrorNone;
+}
+
+void BenchComponent::Return(Port& port, OMX_BUFFERHEADERTYPE* header, function<void(OMX_BUFFERHEADERTYPE*)> const& callback)
+{
+  {
+    lock_guard<std::mutex> lock(mutex);
+    --port.atComponent;
+
+    if(!callback || isStopping || !port.isEnabled)
+    {
+      port.available.push_back(header);
+      changed.notify_all();
+      return;
+    }
+
+    changed.notify_all();
+  }
+
+  callback(header);
+}
+
+OMX_ERRORTYPE BenchComponent::OnEvent(OMX_HANDLETYPE, OMX_PTR app, OMX_EVENTTYPE event, OMX_U32 data1, OMX_U32 data2, OMX_PTR)
+{
+  auto self = static_cast<BenchComponent*>(app);
+  lock_guard<std::mutex> lock(self->mutex);
+
+  if(event == OMX_EventCmdComplete)
+    self->completions.push_back(Completion { data1, data2 });
+  else if(event == OMX_EventError && self->error == OMX_ErrorNone)
+    self->error = static_cast<OMX_ERRORTYPE>(data1);
+
+  self->changed.notify_all();
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE BenchComponent::OnEmptyBufferDone(OMX_HANDLETYPE, OMX_PTR app, OMX_BUFFERHEADERTYPE* header)
+{
+  auto self = static_cast<BenchComponent*>(app);
+  self->Return(self->GetPort(self->input), header, self->emptied);
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE BenchComponent::OnFillBufferDone(OMX_HANDLETYPE, OMX_PTR app, OMX_BUFFERHEADERTYPE* header)
+{
+  auto self = static_cast<BenchComponent*>(app);
+  self->Return(self->GetPort(self->output), header, self->filled);
+  return OMX_ErrorNone;
+}
+
+ScopedEnvironment::ScopedEnvironment(char const* name, string const& value) : name{name}, wasSet{getenv(name) != nullptr}
+{
+  if(wasSet)
+    previous = getenv(name);
+
+  setenv(name, value.c_str(), 1);
+}
+
+ScopedEnvironment::~ScopedEnvironment()
+{
+  if(wasSet)
+    setenv(name.c_str(), previous.c_str(), 1);
+  else
+    unsetenv(name.c_str());
+}
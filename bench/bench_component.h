@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <OMX_Core.h>
+
+/* A component of the core driven the way an application does: the component allocates the buffers
+ * of its ports and the commands are waited for through their events. The calls return the first
+ * error of the component, OMX_ErrorTimeout when it doesn't answer */
+struct BenchComponent
+{
+  BenchComponent() = default;
+  ~BenchComponent();
+
+  BenchComponent(BenchComponent const &) = delete;
+  BenchComponent & operator = (BenchComponent const &) = delete;
+
+  /* OMX_GetHandle then idle, with all the buffers of the ports */
+  OMX_ERRORTYPE Open(std::string const& name);
+  /* Only OMX_GetHandle, the ports can be set before idle */
+  OMX_ERRORTYPE GetHandle(std::string const& name);
+  OMX_ERRORTYPE SetState(OMX_STATETYPE state);
+  /* Back to loaded, then the handle is freed */
+  void Close();
+
+  /* The buffers of the port are waited for and freed. The other port keeps going meanwhile, through
+   * its callback when it has one */
+  OMX_ERRORTYPE DisablePort(OMX_U32 index);
+  /* With new buffers */
+  OMX_ERRORTYPE EnablePort(OMX_U32 index);
+
+  /* The raw port of an encoder, with the smallest stride and slice height for the resolution */
+  OMX_ERRORTYPE SetRawPort(int width, int height, int framerate);
+
+  /* A buffer the component gave back on the port, nullptr when none came in time */
+  OMX_BUFFERHEADERTYPE* Take(OMX_U32 index, std::chrono::milliseconds timeout = std::chrono::seconds(10));
+  OMX_ERRORTYPE Empty(OMX_BUFFERHEADERTYPE* header);
+  OMX_ERRORTYPE Fill(OMX_BUFFERHEADERTYPE* header);
+
+  OMX_HANDLETYPE handle {};
+  OMX_U32 input {};
+  OMX_U32 output {};
+
+  /* When set, the buffers given back go there, on the threads of the component, instead of being
+   * kept for Take. Not called once the component leaves executing */
+  std::function<void(OMX_BUFFERHEADERTYPE* header)> emptied;
+  std::function<void(OMX_BUFFERHEADERTYPE* header)> filled;
+
+private:
+  struct Port
+  {
+    std::vector<OMX_BUFFERHEADERTYPE*> buffers;
+    std::deque<OMX_BUFFERHEADERTYPE*> available;
+    int atComponent = 0;
+    bool isEnabled = true;
+  };
+
+  struct Completion
+  {
+    OMX_U32 command;
+    OMX_U32 data;
+  };
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  Port ports[2]; // input then output
+  std::vector<Completion> completions;
+  OMX_ERRORTYPE error = OMX_ErrorNone;
+  bool isStopping = false;
+
+  Port& GetPort(OMX_U32 index);
+  OMX_ERRORTYPE AllocateBuffers(OMX_U32 index);
+  void FreeBuffers(OMX_U32 index);
+  OMX_ERRORTYPE WaitCommand(OMX_COMMANDTYPE command, OMX_U32 data);
+  OMX_ERRORTYPE Give(Port& port, OMX_BUFFERHEADERTYPE* header);
+  void Return(Port& port, OMX_BUFFERHEADERTYPE* header, std::function<void(OMX_BUFFERHEADERTYPE*)> const& callback);
+
+  static OMX_ERRORTYPE OnEvent(OMX_HANDLETYPE handle, OMX_PTR app, OMX_EVENTTYPE event, OMX_U32 data1, OMX_U32 data2, OMX_PTR data);
+  static OMX_ERRORTYPE OnEmptyBufferDone(OMX_HANDLETYPE handle, OMX_PTR app, OMX_BUFFERHEADERTYPE* header);
+  static OMX_ERRORTYPE OnFillBufferDone(OMX_HANDLETYPE handle, OMX_PTR app, OMX_BUFFERHEADERTYPE* header);
+};
+
+/* Sets an environment variable for its scope, such as the ALLEGRO_MOCK_* settings of the mock
+ * components created meanwhile */
+struct ScopedEnvironment
+{
+  ScopedEnvironment(char const* name, std::string const& value);
+  ~ScopedEnvironment();
+
+  ScopedEnvironment(ScopedEnvironment const &) = delete;
+  ScopedEnvironment & operator = (ScopedEnvironment const &) = delete;
+
+private:
+  std::string const name;
+  bool wasSet;
+  std::string previous;
+};
@@ -0,0 +1,217 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+#include "bench_component.h"
+
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include <sys/resource.h>
+
+using namespace std;
+
+static char const* MOCK_ENCODER = "OMX.allegro.h264.mock.encoder";
+static int constexpr WIDTH = 320;
+static int constexpr HEIGHT = 240;
+static int constexpr FRAMERATE = 60;
+static int constexpr NUM_FRAMES = 200;
+static int constexpr LATENCY = 200; // of a frame on the mock module, in microseconds
+static int constexpr JITTER = 50;
+
+/* A mock encoder of the core fed as fast as it goes: each input given back is filled again and
+ * each output given back is handed back, from the callbacks on the threads of the component */
+struct DensityStream
+{
+  DensityStream()
+  {
+    component.emptied = [this](OMX_BUFFERHEADERTYPE* header) {
+                          EmptyNext(header);
+                        };
+    component.filled = [this](OMX_BUFFERHEADERTYPE* header) {
+                         if(header->nFilledLen && (header->nFlags & OMX_BUFFERFLAG_ENDOFFRAME) && ++encoded == NUM_FRAMES)
+                           done.set_value();
+
+                         component.Fill(header);
+                       };
+  }
+
+  /* The callbacks stop before the members they use go */
+  ~DensityStream()
+  {
+    component.Close();
+  }
+
+  OMX_ERRORTYPE Open()
+  {
+    auto ret = component.GetHandle(MOCK_ENCODER);
+
+    if(ret == OMX_ErrorNone)
+      ret = component.SetRawPort(WIDTH, HEIGHT, FRAMERATE);
+
+    if(ret == OMX_ErrorNone)
+      ret = component.SetState(OMX_StateIdle);
+
+    if(ret == OMX_ErrorNone)
+      ret = component.SetState(OMX_StateExecuting);
+
+    return ret;
+  }
+
+  /* All the buffers of both ports are given to the component */
+  OMX_ERRORTYPE Start()
+  {
+    auto ret = OMX_ErrorNone;
+
+    while(auto header = component.Take(component.output, chrono::milliseconds(0)))
+    {
+      ret = component.Fill(header);
+
+      if(ret != OMX_ErrorNone)
+        return ret;
+    }
+
+    while(auto header = component.Take(component.input, chrono::milliseconds(0)))
+    {
+      ret = EmptyNext(header);
+
+      if(ret != OMX_ErrorNone)
+        return ret;
+    }
+
+    return ret;
+  }
+
+  bool Wait(chrono::seconds timeout)
+  {
+    return done.get_future().wait_for(timeout) == future_status::ready;
+  }
+
+private:
+  BenchComponent component;
+  atomic<int> submitted {
+    0
+  };
+  atomic<int> encoded {
+    0
+  };
+  promise<void> done;
+
+  OMX_ERRORTYPE EmptyNext(OMX_BUFFERHEADERTYPE* header)
+  {
+    if(submitted++ >= NUM_FRAMES)
+      return OMX_ErrorNone;
+
+    header->nOffset = 0;
+    header->nFilledLen = header->nAllocLen;
+    header->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+    return component.Empty(header);
+  }
+};
+
+static int CountThreads()
+{
+  ifstream status { "/proc/self/status" };
+  string line;
+
+  while(getline(status, line))
+  {
+    if(line.compare(0, 8, "Threads:") == 0)
+      return stoi(line.substr(8));
+  }
+
+  return 0;
+}
+
+struct Usage
+{
+  int64_t contextSwitches;
+  int64_t cpuTime; // microseconds
+};
+
+static Usage GetUsage()
+{
+  struct rusage usage {};
+  getrusage(RUSAGE_SELF, &usage);
+  auto cpuTime = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+  return Usage { usage.ru_nvcsw + usage.ru_nivcsw, cpuTime };
+}
+
+/* Wall time per frame of numStreams mock encoders running together through the core, with a
+ * thread per processor or the processors of all the components on the shared pool of
+ * OMX_ALLEGRO_SHARED_THREADS. The mock module keeps its own worker and delivery threads in both
+ * cases */
+void BenchDensity(Bench& bench)
+{
+  if(!bench.IsSelected("density.frame"))
+    return;
+
+  if(OMX_Init() != OMX_ErrorNone)
+  {
+    bench.Fail("density.frame", "no component library in OMX_ALLEGRO_PATH");
+    return;
+  }
+
+  ScopedEnvironment latency { "ALLEGRO_MOCK_LATENCY", to_string(LATENCY) };
+  ScopedEnvironment jitter { "ALLEGRO_MOCK_JITTER", to_string(JITTER) };
+
+  for(auto numStreams : { 8, 32 })
+  {
+    for(auto poolSize : { 0, 4 })
+    {
+      // Read by each component when it is created
+      ScopedEnvironment sharedThreads { "OMX_ALLEGRO_SHARED_THREADS", to_string(poolSize) };
+      auto params = to_string(numStreams) + " streams, " + (poolSize ? "pool of " + to_string(poolSize) : string { "thread per processor" });
+      vector<unique_ptr<DensityStream>> streams;
+      auto error = OMX_ErrorNone;
+
+      for(int i = 0; i < numStreams && error == OMX_ErrorNone; ++i)
+      {
+        streams.emplace_back(new DensityStream {});
+        error = streams.back()->Open();
+      }
+
+      auto threads = CountThreads();
+      auto usageAtStart = GetUsage();
+      auto start = chrono::steady_clock::now();
+
+      for(auto& stream : streams)
+      {
+        if(error == OMX_ErrorNone)
+          error = stream->Start();
+      }
+
+      for(auto& stream : streams)
+      {
+        if(error == OMX_ErrorNone && !stream->Wait(chrono::seconds(60)))
+          error = OMX_ErrorTimeout;
+      }
+
+      auto elapsed = chrono::steady_clock::now() - start;
+      auto usage = GetUsage();
+
+      if(error != OMX_ErrorNone)
+      {
+        stringstream message;
+        message << params << ": error 0x" << hex << error;
+        bench.Fail("density.frame", message.str());
+        continue;
+      }
+
+      int64_t numFrames = numStreams * NUM_FRAMES;
+      stringstream description;
+      description.precision(3);
+      description << params
+                  << ", " << threads << " threads"
+                  << ", " << static_cast<double>(usage.contextSwitches - usageAtStart.contextSwitches) / numFrames << " switches/frame"
+                  << ", " << static_cast<double>(usage.cpuTime - usageAtStart.cpuTime) / numFrames << " cpu us/frame";
+      bench.Add("density.frame", description.str(), numFrames, chrono::duration_cast<chrono::nanoseconds>(elapsed));
+    }
+  }
+
+  OMX_Deinit();
+}
@@ -0,0 +1,189 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <cstring>
+#include <sstream>
+
+#include <OMX_Component.h>
+#include <OMX_CoreAlg.h>
+
+#include <core/omx_core_load.h>
+
+using namespace std;
+
+static char const* FAKE_DEVICE = "/dev/bench_fake";
+static int constexpr WIDTH = 1920;
+static int constexpr HEIGHT = 1080;
+static int constexpr FRAMERATE = 60;
+static int constexpr AVC_WEIGHT = 100;
+
+/* Stands for an avc encoder on the tracker: a raw 1080p60 nv12 input and a compressed output,
+ * moving between loaded and idle at once */
+struct FakeComponent
+{
+  FakeComponent()
+  {
+    memset(&component, 0, sizeof(component));
+    component.nSize = sizeof(component);
+    component.pComponentPrivate = this;
+    component.GetParameter = GetParameter;
+    component.GetState = GetState;
+    component.SendCommand = SendCommand;
+    component.SetCallbacks = SetCallbacks;
+  }
+
+  OMX_COMPONENTTYPE component;
+  OMX_STATETYPE state = OMX_StateLoaded;
+  OMX_CALLBACKTYPE callbacks {};
+  OMX_PTR app = nullptr;
+
+  static FakeComponent& Get(OMX_HANDLETYPE handle)
+  {
+    return *static_cast<FakeComponent*>(static_cast<OMX_COMPONENTTYPE*>(handle)->pComponentPrivate);
+  }
+
+  static OMX_ERRORTYPE GetParameter(OMX_HANDLETYPE, OMX_INDEXTYPE index, OMX_PTR param)
+  {
+    if(index == OMX_IndexParamVideoInit)
+    {
+      auto ports = static_cast<OMX_PORT_PARAM_TYPE*>(param);
+      ports->nStartPortNumber = 0;
+      ports->nPorts = 2;
+      return OMX_ErrorNone;
+    }
+
+    if(index == OMX_IndexParamPortDefinition)
+    {
+      auto definition = static_cast<OMX_PARAM_PORTDEFINITIONTYPE*>(param);
+      auto& video = definition->format.video;
+      video.nFrameWidth = WIDTH;
+      video.nFrameHeight = HEIGHT;
+      video.xFramerate = FRAMERATE << 16;
+      video.eCompressionFormat = definition->nPortIndex == 0 ? OMX_VIDEO_CodingUnused : OMX_VIDEO_CodingAVC;
+      definition->nBufferSize = WIDTH * HEIGHT * 3 / 2;
+      return OMX_ErrorNone;
+    }
+
+    if(index == OMX_IndexParamVideoProfileLevelCurrent)
+    {
+      static_cast<OMX_VIDEO_PARAM_PROFILELEVELTYPE*>(param)->eProfile = OMX_VIDEO_AVCProfileHigh;
+      return OMX_ErrorNone;
+    }
+
+    return OMX_ErrorUnsupportedIndex;
+  }
+
+  static OMX_ERRORTYPE GetState(OMX_HANDLETYPE handle, OMX_STATETYPE* state)
+  {
+    *state = Get(handle).state;
+    return OMX_ErrorNone;
+  }
+
+  static OMX_ERRORTYPE SendCommand(OMX_HANDLETYPE handle, OMX_COMMANDTYPE cmd, OMX_U32 param, OMX_PTR)
+  {
+    auto& fake = Get(handle);
+
+    if(cmd != OMX_CommandStateSet)
+      return OMX_ErrorNotImplemented;
+
+    fake.state = static_cast<OMX_STATETYPE>(param);
+
+    if(fake.callbacks.EventHandler)
+      fake.callbacks.EventHandler(handle, fake.app, OMX_EventCmdComplete, OMX_CommandStateSet, param, nullptr);
+    return OMX_ErrorNone;
+  }
+
+  static OMX_ERRORTYPE SetCallbacks(OMX_HANDLETYPE handle, OMX_CALLBACKTYPE* callbacks, OMX_PTR app)
+  {
+    auto& fake = Get(handle);
+    fake.callbacks = *callbacks;
+    fake.app = app;
+    return OMX_ErrorNone;
+  }
+};
+
+static int numLoadedEvents = 0;
+
+static OMX_ERRORTYPE CountLoadedEvents(OMX_HANDLETYPE, OMX_PTR, OMX_EVENTTYPE event, OMX_U32 data1, OMX_U32 data2, OMX_PTR)
+{
+  if(event == OMX_EventCmdComplete && data1 == OMX_CommandStateSet && data2 == OMX_StateLoaded)
+    ++numLoadedEvents;
+  return OMX_ErrorNone;
+}
+
+/* The admission of the core on a fake device of the capacity of two channels: a third channel
+ * is refused until one goes back to loaded or is freed, and is admitted then. Each step checks
+ * the result of the command, the load and the channels of the device */
+static void CheckAdmission(Bench& bench)
+{
+  if(!bench.IsSelected("load.admission_check"))
+    return;
+
+  auto& tracker = GetDeviceLoadTracker();
+  auto load = ComputeChannelLoad(WIDTH, HEIGHT, FRAMERATE, AVC_WEIGHT);
+  tracker.SetCapacity(FAKE_DEVICE, 2 * load + load / 2);
+
+  FakeComponent fakes[3];
+  OMX_CALLBACKTYPE callbacks {};
+  callbacks.EventHandler = CountLoadedEvents;
+  int numSteps = 0;
+  auto start = chrono::steady_clock::now();
+
+  for(auto& fake : fakes)
+    EnableAdmissionControl(&fake.component, "bench.fake", FAKE_DEVICE, nullptr, &callbacks);
+
+  auto step = [&](char const* name, FakeComponent& fake, OMX_STATETYPE state, OMX_ERRORTYPE expected, int expectedChannels) {
+                auto ret = OMX_SendCommand(&fake.component, OMX_CommandStateSet, state, nullptr);
+                ++numSteps;
+                stringstream error;
+
+                if(ret != expected)
+                  error << "returned 0x" << hex << ret << " instead of 0x" << expected << dec << ", ";
+
+                if(tracker.GetChannels(FAKE_DEVICE) != expectedChannels || tracker.GetLoad(FAKE_DEVICE) != expectedChannels * load)
+                  error << tracker.GetChannels(FAKE_DEVICE) << " channels and a load of " << tracker.GetLoad(FAKE_DEVICE) << " instead of " << expectedChannels << " and " << expectedChannels * load << ", ";
+
+                if(!error.str().empty())
+                  bench.Fail("load.admission_check", string { name } +": " + error.str().substr(0, error.str().size() - 2));
+              };
+
+  auto refused = static_cast<OMX_ERRORTYPE>(OMX_ALG_ErrorChannelHardwareCapacityExceeded);
+  step("first channel admitted", fakes[0], OMX_StateIdle, OMX_ErrorNone, 1);
+  step("second channel admitted", fakes[1], OMX_StateIdle, OMX_ErrorNone, 2);
+  step("third channel refused", fakes[2], OMX_StateIdle, refused, 2);
+
+  if(fakes[2].state != OMX_StateLoaded)
+    bench.Fail("load.admission_check", "the refused channel left loaded");
+
+  step("first channel released in loaded", fakes[0], OMX_StateLoaded, OMX_ErrorNone, 1);
+
+  if(numLoadedEvents != 1)
+    bench.Fail("load.admission_check", "the application got " + to_string(numLoadedEvents) + " loaded events instead of 1");
+
+  step("third channel admitted", fakes[2], OMX_StateIdle, OMX_ErrorNone, 2);
+  step("first channel refused again", fakes[0], OMX_StateIdle, refused, 2);
+
+  // As OMX_FreeHandle does, without going back to loaded
+  DisableAdmissionControl(&fakes[1].component);
+
+  if(tracker.GetChannels(FAKE_DEVICE) != 1)
+    bench.Fail("load.admission_check", "freed channel: " + to_string(tracker.GetChannels(FAKE_DEVICE)) + " channels instead of 1");
+
+  step("first channel admitted again", fakes[0], OMX_StateIdle, OMX_ErrorNone, 2);
+
+  for(auto& fake : fakes)
+    DisableAdmissionControl(&fake.component);
+
+  if(tracker.GetChannels(FAKE_DEVICE) != 0 || tracker.GetLoad(FAKE_DEVICE) != 0)
+    bench.Fail("load.admission_check", "the load of the freed channels is still reserved");
+
+  auto params = "capacity of " + to_string(tracker.GetCapacity(FAKE_DEVICE)) + ", channels of " + to_string(load);
+  bench.Add("load.admission_check", params, numSteps, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start));
+}
+
+void BenchLoad(Bench& bench)
+{
+  CheckAdmission(bench);
+}
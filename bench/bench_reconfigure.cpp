@@ -0,0 +1,222 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+#include "bench_component.h"
+
+#include <atomic>
+#include <future>
+#include <sstream>
+#include <thread>
+
+#include <OMX_Component.h>
+#include <OMX_ComponentAlg.h>
+#include <OMX_IndexAlg.h>
+
+#include <base/omx_checker/omx_checker.h>
+
+using namespace std;
+
+static char const* MOCK_ENCODER = "OMX.allegro.h264.mock.encoder";
+static int constexpr WIDTH = 1280;
+static int constexpr HEIGHT = 720;
+static int constexpr FRAMERATE = 60;
+static chrono::microseconds constexpr PERIOD {
+  1000000 / FRAMERATE
+};
+static int constexpr LATENCY = 5000; // of a frame on the mock module, in microseconds
+static int constexpr NUM_RECONFIGURATIONS = 3;
+static int constexpr FRAMES_BETWEEN = 20;
+
+struct ReconfigureCase
+{
+  char const* description;
+  bool canReconfigure;
+  int reorderDepth;
+};
+
+struct ReconfigureRun
+{
+  int fed;
+  atomic<int> encoded;
+  chrono::nanoseconds downtime;
+  int downtimeFrames;
+  OMX_ALG_CONFIG_STATISTICS statistics;
+};
+
+/* Feeds the raw frames at the framerate, from next on */
+static OMX_ERRORTYPE Feed(BenchComponent& component, int numFrames, chrono::steady_clock::time_point& next, ReconfigureRun& run)
+{
+  for(int i = 0; i < numFrames; ++i)
+  {
+    this_thread::sleep_until(next);
+    next += PERIOD;
+    auto header = component.Take(component.input);
+
+    if(!header)
+      return OMX_ErrorTimeout;
+
+    header->nOffset = 0;
+    header->nFilledLen = header->nAllocLen;
+    header->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+    header->nTimeStamp = run.fed * PERIOD.count();
+    auto ret = component.Empty(header);
+
+    if(ret != OMX_ErrorNone)
+      return ret;
+
+    ++run.fed;
+  }
+
+  return OMX_ErrorNone;
+}
+
+/* The framerate changes while the input port is disabled, the frames which would have come
+ * meanwhile are skipped. The stream ends with an end of stream, which the module outputs after the
+ * frames it holds */
+static OMX_ERRORTYPE Run(ReconfigureCase const& test, ReconfigureRun& run)
+{
+  ScopedEnvironment latency { "ALLEGRO_MOCK_LATENCY", to_string(LATENCY) };
+  ScopedEnvironment reorderDepth { "ALLEGRO_MOCK_REORDER_DEPTH", to_string(test.reorderDepth) };
+  ScopedEnvironment canReconfigure { "ALLEGRO_MOCK_RECONFIGURE", test.canReconfigure ? "1" : "0" };
+  BenchComponent component;
+  promise<void> eos;
+  atomic_flag isEos = ATOMIC_FLAG_INIT;
+  component.filled = [&](OMX_BUFFERHEADERTYPE* header) {
+                       if(header->nFilledLen && (header->nFlags & OMX_BUFFERFLAG_ENDOFFRAME))
+                         ++run.encoded;
+
+                       if((header->nFlags & OMX_BUFFERFLAG_EOS) && !isEos.test_and_set())
+                         eos.set_value();
+
+                       component.Fill(header);
+                     };
+
+  auto ret = component.GetHandle(MOCK_ENCODER);
+
+  if(ret == OMX_ErrorNone)
+    ret = component.SetRawPort(WIDTH, HEIGHT, FRAMERATE);
+
+  if(ret == OMX_ErrorNone)
+    ret = component.SetState(OMX_StateIdle);
+
+  if(ret == OMX_ErrorNone)
+    ret = component.SetState(OMX_StateExecuting);
+
+  while(ret == OMX_ErrorNone)
+  {
+    auto header = component.Take(component.output, chrono::milliseconds(0));
+
+    if(!header)
+      break;
+    ret = component.Fill(header);
+  }
+
+  auto next = chrono::steady_clock::now();
+
+  for(int i = 0; i < NUM_RECONFIGURATIONS && ret == OMX_ErrorNone; ++i)
+  {
+    ret = Feed(component, FRAMES_BETWEEN, next, run);
+
+    if(ret != OMX_ErrorNone)
+      break;
+
+    auto start = chrono::steady_clock::now();
+    ret = component.DisablePort(component.input);
+
+    if(ret == OMX_ErrorNone)
+      ret = component.SetRawPort(WIDTH, HEIGHT, i % 2 ? FRAMERATE : FRAMERATE / 2);
+
+    if(ret == OMX_ErrorNone)
+      ret = component.EnablePort(component.input);
+
+    next = chrono::steady_clock::now();
+    auto downtime = next - start;
+    run.downtime += downtime;
+    // A frame period which started is a frame missed
+    run.downtimeFrames += static_cast<int>((downtime + PERIOD - chrono::nanoseconds(1)) / PERIOD);
+  }
+
+  if(ret == OMX_ErrorNone)
+    ret = Feed(component, FRAMES_BETWEEN, next, run);
+
+  auto header = ret == OMX_ErrorNone ? component.Take(component.input) : nullptr;
+
+  if(header)
+  {
+    header->nFilledLen = 0;
+    header->nFlags = OMX_BUFFERFLAG_EOS;
+    ret = component.Empty(header);
+
+    if(ret == OMX_ErrorNone && eos.get_future().wait_for(chrono::seconds(10)) != future_status::ready)
+      ret = OMX_ErrorTimeout;
+  }
+  else if(ret == OMX_ErrorNone)
+    ret = OMX_ErrorTimeout;
+
+  OMXChecker::SetHeaderVersion(run.statistics);
+
+  if(ret == OMX_ErrorNone)
+    ret = OMX_GetConfig(component.handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigStatistics), &run.statistics);
+
+  return ret;
+}
+
+/* Downtime of the input port disabled and enabled again around a new framerate, while executing
+ * on the mock module. The channel applies the new settings in place, or the module refuses them
+ * and a new channel is created when the port is enabled. A channel which reorders is restarted
+ * when the port is disabled instead: the frames it held are lost. The downtime counts the frames
+ * the application couldn't feed at the framerate, the lost frames those fed but never encoded */
+void BenchReconfigure(Bench& bench)
+{
+  if(!bench.IsSelected("reconfigure.downtime"))
+    return;
+
+  if(OMX_Init() != OMX_ErrorNone)
+  {
+    bench.Fail("reconfigure.downtime", "no component library in OMX_ALLEGRO_PATH");
+    return;
+  }
+
+  ReconfigureCase const tests[] = {
+    { "in place", true, 0 },
+    { "new channel", false, 0 },
+    { "new channel, reordering", true, 2 },
+  };
+
+  for(auto const& test : tests)
+  {
+    ReconfigureRun run {};
+    auto ret = Run(test, run);
+    auto const& statistics = run.statistics;
+
+    if(ret != OMX_ErrorNone)
+    {
+      stringstream message;
+      message << test.description << ": error 0x" << hex << ret;
+      bench.Fail("reconfigure.downtime", message.str());
+      continue;
+    }
+
+    auto expectedInPlace = test.canReconfigure ? NUM_RECONFIGURATIONS : 0;
+
+    if(statistics.nReconfigurations != NUM_RECONFIGURATIONS || statistics.nReconfigInPlace != static_cast<OMX_U64>(expectedInPlace))
+      bench.Fail("reconfigure.downtime", string { test.description } +": " + to_string(statistics.nReconfigInPlace) + " of " + to_string(statistics.nReconfigurations) + " reconfigurations in place instead of " + to_string(expectedInPlace) + " of " + to_string(NUM_RECONFIGURATIONS));
+
+    auto lostFrames = run.fed - run.encoded;
+
+    // Only the restart of a channel which holds frames loses some
+    if(lostFrames && !test.reorderDepth)
+      bench.Fail("reconfigure.downtime", string { test.description } +": " + to_string(lostFrames) + " frames lost");
+
+    stringstream params;
+    params.precision(3);
+    params << WIDTH << "x" << HEIGHT << "@" << FRAMERATE << ", " << test.description
+           << ", " << static_cast<double>(run.downtimeFrames) / NUM_RECONFIGURATIONS << " frames of downtime"
+           << ", " << static_cast<double>(lostFrames) / NUM_RECONFIGURATIONS << " frames lost"
+           << ", " << static_cast<double>(statistics.nReconfigLostFrames) / NUM_RECONFIGURATIONS << " frames of downtime for the component";
+    bench.Add("reconfigure.downtime", params.str(), NUM_RECONFIGURATIONS, run.downtime);
+  }
+
+  OMX_Deinit();
+}
@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <module/ROIMngr.h>
+
+using namespace std;
+
+extern "C"
+{
+#include <lib_common/Profiles.h>
+#include <lib_common_enc/EncBuffers.h>
+}
+
+static uint8_t constexpr LOG2_MAX_CU_SIZE = 5;
+
+static AL_ERoiQuality const QUALITIES[] =
+{
+  AL_ROI_QUALITY_HIGH, AL_ROI_QUALITY_LOW, AL_ROI_QUALITY_MEDIUM, AL_ROI_QUALITY_INTRA
+};
+
+/* Spreads numRois overlapping regions of a quarter of the picture over a diagonal.
+ * Without region, only the background is filled */
+static void AddRois(AL_TRoiMngrCtx* ctx, int width, int height, int numRois)
+{
+  for(int i = 0; i < numRois; ++i)
+  {
+    auto posX = (width * 3 / 4) * i / numRois;
+    auto posY = (height * 3 / 4) * ((i * 7) % numRois) / numRois;
+    AL_RoiMngr_AddROI(ctx, posX, posY, width / 4, height / 4, QUALITIES[i % 4]);
+  }
+}
+
+void BenchRoi(Bench& bench)
+{
+  struct
+  {
+    char const* name;
+    int width;
+    int height;
+  } const formats[] =
+  {
+    { "1080p", 1920, 1080 }, { "4K", 3840, 2160 }
+  };
+
+  for(auto const& format : formats)
+  {
+    AL_TDimension dimension { format.width, format.height };
+    auto size = AL_GetAllocSizeEP2(dimension, AL_CODEC_HEVC, LOG2_MAX_CU_SIZE);
+    vector<uint8_t> qps(size);
+
+    for(auto numRois : { 0, 1, 4, 16, 64 })
+    {
+      auto ctx = AL_RoiMngr_Create(format.width, format.height, AL_PROFILE_HEVC_MAIN, LOG2_MAX_CU_SIZE, AL_ROI_QUALITY_MEDIUM, AL_ROI_INCOMING_ORDER);
+      AddRois(ctx, format.width, format.height, numRois);
+
+      auto params = string { format.name } +", " + to_string(numRois) + " rois";
+      bench.Run("roi.fill_buff", params, 200, [&]() {
+        AL_RoiMngr_FillBuff(ctx, 1, 1, qps.data() + EP2_BUF_QP_BY_MB.Offset, 0);
+      });
+
+      /* What the encoder module does while the ROI generation is unchanged */
+      vector<uint8_t> cached(qps);
+      bench.Run("roi.cached_copy", params, 200, [&]() {
+        copy(cached.begin(), cached.end(), qps.begin());
+      });
+
+      AL_RoiMngr_Destroy(ctx);
+    }
+
+    /* One region crossing the picture in 300 frames, with the generation cache of the encoder module */
+    auto ctx = AL_RoiMngr_Create(format.width, format.height, AL_PROFILE_HEVC_MAIN, LOG2_MAX_CU_SIZE, AL_ROI_QUALITY_MEDIUM, AL_ROI_INCOMING_ORDER);
+    AL_RoiMngr_AddMovingROI(ctx, 0, 0, format.width * 3 / 4, format.height * 3 / 4, format.width / 4, format.height / 4, 300, AL_ROI_QUALITY_HIGH);
+    vector<uint8_t> cached(size);
+    auto generation = ctx->uGeneration - 1;
+    bench.Run("roi.moving", string { format.name } +", 1 roi", 300, [&]() {
+      if(generation != ctx->uGeneration)
+      {
+        AL_RoiMngr_FillBuff(ctx, 1, 1, cached.data() + EP2_BUF_QP_BY_MB.Offset, 0);
+        generation = ctx->uGeneration;
+      }
+      copy(cached.begin(), cached.end(), qps.begin());
+      AL_RoiMngr_NextFrame(ctx);
+    });
+    AL_RoiMngr_Destroy(ctx);
+  }
+}
@@ -0,0 +1,234 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include <module/scene_change_analyzer.h>
+
+using namespace std;
+
+/* A gradient moving by a few samples each frame, every other frame is a cut to its negative */
+static void FillSyntheticLuma(vector<uint8_t>& luma, int pitch, int rowSize, int rows, int frame)
+{
+  auto isCut = (frame % 2) != 0;
+
+  for(int y = 0; y < rows; ++y)
+  {
+    for(int x = 0; x < rowSize; ++x)
+    {
+      auto sample = static_cast<uint8_t>((x + y + frame * 3) & 0xFF);
+      luma[y * pitch + x] = isCut ? 255 - sample : sample;
+    }
+  }
+}
+
+/* A scene of a check sequence: a smooth texture at a mean level and contrast, panning at its
+ * own speed, with an optional fade, under a sensor noise */
+struct CheckScene
+{
+  int texture;
+  int level;
+  int contrast; // in percent
+  int numFrames;
+  int panX;
+  int panY;
+  int fade; // percent of brightness lost (or gained when negative) over the scene
+};
+
+/* How a scene differs from the previous one */
+enum class CheckCut
+{
+  DISTINCT, // another texture, at a mean level 40 apart at least
+  SAME_LEVEL, // another texture at the same mean level and contrast
+  BRIGHTNESS_STEP, // the same texture, 24 levels brighter or darker
+};
+
+static uint32_t Hash(uint32_t value)
+{
+  value ^= value >> 16;
+  value *= 0x7feb352d;
+  value ^= value >> 15;
+  value *= 0x846ca68b;
+  value ^= value >> 16;
+  return value;
+}
+
+/* Value noise on a grid of 32 samples, smoothly interpolated, over a gradient, centered on 0 */
+static int SampleTexture(int texture, int x, int y)
+{
+  static int constexpr CELL = 32;
+  auto cellX = x >= 0 ? x / CELL : (x - CELL + 1) / CELL;
+  auto cellY = y >= 0 ? y / CELL : (y - CELL + 1) / CELL;
+  auto fracX = x - cellX * CELL;
+  auto fracY = y - cellY * CELL;
+
+  auto corner = [&](int dx, int dy) {
+                  return static_cast<int>(Hash(texture * 0x9E3779B9u ^ Hash((cellX + dx) * 73856093u ^ (cellY + dy) * 19349663u)) & 0xFF);
+                };
+
+  auto top = corner(0, 0) * (CELL - fracX) + corner(1, 0) * fracX;
+  auto bottom = corner(0, 1) * (CELL - fracX) + corner(1, 1) * fracX;
+  auto noise = (top * (CELL - fracY) + bottom * fracY) / (CELL * CELL) - 128;
+  auto gradient = static_cast<int>(Hash(texture) % 64) * (x + y) / 1024 - 16;
+  return noise + gradient;
+}
+
+static void FillCheckFrame(vector<uint8_t>& luma, int width, int height, CheckScene const& scene, int frame, uint32_t seed)
+{
+  auto gain = 100 - scene.fade * frame / max(1, scene.numFrames - 1) - (scene.fade < 0 ? scene.fade : 0);
+
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      auto sample = (scene.level + SampleTexture(scene.texture, x + scene.panX * frame, y + scene.panY * frame) * scene.contrast / 100) * gain / 100;
+      auto noise = static_cast<int>(Hash(seed ^ Hash(frame * 1000003u + y * width + x)) % 7) - 3;
+      luma[y * width + x] = static_cast<uint8_t>(min(255, max(0, sample + noise)));
+    }
+  }
+}
+
+/* Scenes of 5 to 65 frames. Every scene pans, one out of three fades in or out */
+static vector<CheckScene> CreateCheckScenes(int numScenes, uint32_t seed, CheckCut cut)
+{
+  vector<CheckScene> scenes;
+
+  for(int i = 0; i < numScenes; ++i)
+  {
+    auto random = Hash(seed * 7919u + i);
+    CheckScene scene {};
+    scene.texture = static_cast<int>(Hash(random) % 100000);
+    scene.level = 48 + static_cast<int>(Hash(random + 1) % 160);
+    scene.contrast = 20 + static_cast<int>(Hash(random + 2) % 60);
+    scene.numFrames = 5 + static_cast<int>(random % 61);
+    scene.panX = static_cast<int>((random >> 8) % 9) - 4;
+    scene.panY = static_cast<int>((random >> 12) % 5) - 2;
+    scene.fade = (random >> 16) % 3 == 0 ? static_cast<int>((random >> 18) % 61) - 30 : 0;
+
+    if(!scenes.empty())
+    {
+      auto const& previous = scenes.back();
+
+      if(cut == CheckCut::DISTINCT && abs(scene.level - previous.level) < 40)
+        scene.level = previous.level < 128 ? previous.level + 40 + scene.level % 40 : previous.level - 40 - scene.level % 40;
+      else if(cut == CheckCut::SAME_LEVEL)
+      {
+        scene.level = previous.level;
+        scene.contrast = previous.contrast;
+      }
+      else if(cut == CheckCut::BRIGHTNESS_STEP)
+      {
+        scene.texture = previous.texture;
+        scene.contrast = previous.contrast;
+        scene.level = previous.level < 128 ? previous.level + 24 : previous.level - 24;
+      }
+    }
+
+    scenes.push_back(scene);
+  }
+
+  return scenes;
+}
+
+/* Frames starting a scene, other than the first one, are the expected cuts. Sequences of
+ * distinct scenes must give exactly them. The analyzer relies on the luma histogram, so it
+ * may miss the cuts between scenes of alike histograms: there, only the false detections fail
+ * the check and the missed cuts are reported */
+static void CheckSceneChange(Bench& bench)
+{
+  if(!bench.IsSelected("scene_change.check"))
+    return;
+
+  static int constexpr WIDTH = 640;
+  static int constexpr HEIGHT = 360;
+  static int constexpr NUM_SCENES = 20;
+  static int constexpr NUM_SEQUENCES = 5;
+
+  struct
+  {
+    CheckCut cut;
+    char const* name;
+  } const cuts[] =
+  {
+    { CheckCut::DISTINCT, "distinct scenes" }, { CheckCut::SAME_LEVEL, "same level scenes" }, { CheckCut::BRIGHTNESS_STEP, "brightness steps" }
+  };
+
+  for(auto const& cut : cuts)
+  {
+    int numCuts = 0, numDetected = 0, numFalse = 0, numFrames = 0;
+    vector<uint8_t> luma(WIDTH * HEIGHT);
+    auto start = chrono::steady_clock::now();
+
+    for(int sequence = 0; sequence < NUM_SEQUENCES; ++sequence)
+    {
+      SceneChangeAnalyzer analyzer;
+      auto scenes = CreateCheckScenes(NUM_SCENES, sequence, cut.cut);
+
+      for(size_t i = 0; i < scenes.size(); ++i)
+      {
+        for(int frame = 0; frame < scenes[i].numFrames; ++frame)
+        {
+          FillCheckFrame(luma, WIDTH, HEIGHT, scenes[i], frame, sequence);
+          LumaPlane plane { luma.data(), WIDTH, HEIGHT, WIDTH, 1, 0 };
+          auto isDetected = analyzer.Analyze(plane);
+          auto isCut = i > 0 && frame == 0;
+          numCuts += isCut ? 1 : 0;
+          numDetected += isCut && isDetected ? 1 : 0;
+          numFalse += !isCut && isDetected ? 1 : 0;
+          ++numFrames;
+        }
+      }
+    }
+
+    stringstream params;
+    params << cut.name << ", " << numDetected << " of " << numCuts << " cuts detected, " << numFalse << " false detections";
+
+    if(numFalse)
+      bench.Fail("scene_change.check", to_string(numFalse) + " false detections on " + cut.name);
+
+    if(cut.cut == CheckCut::DISTINCT && numDetected != numCuts)
+      bench.Fail("scene_change.check", to_string(numCuts - numDetected) + " cuts missed between distinct scenes");
+    bench.Add("scene_change.check", params.str(), numFrames, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start));
+  }
+}
+
+void BenchSceneChange(Bench& bench)
+{
+  CheckSceneChange(bench);
+
+  struct
+  {
+    char const* name;
+    int width;
+    int height;
+  } const formats[] =
+  {
+    { "1080p", 1920, 1080 }, { "4K", 3840, 2160 }
+  };
+
+  for(auto const& format : formats)
+  {
+    for(auto bytesPerSample : { 1, 2 })
+    {
+      auto rowSize = format.width * bytesPerSample;
+      auto pitch = (rowSize + 255) / 256 * 256;
+      vector<uint8_t> frames[2] { vector<uint8_t>(pitch * format.height), vector<uint8_t>(pitch * format.height) };
+
+      for(int i = 0; i < 2; ++i)
+        FillSyntheticLuma(frames[i], pitch, rowSize, format.height, i);
+
+      SceneChangeAnalyzer analyzer;
+      int frame = 0;
+      auto params = string { format.name } +", " + (bytesPerSample == 1 ? "8" : "10") + " bits";
+      bench.Run("scene_change.analyze", params, 200, [&]() {
+        LumaPlane plane { frames[frame++ % 2].data(), rowSize, format.height, pitch, bytesPerSample, bytesPerSample == 1 ? 0 : 2 };
+        analyzer.Analyze(plane);
+      });
+    }
+  }
+}
@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+#include "bench_component.h"
+
+#include <memory>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+static char const* RISCV_ENCODER = "OMX.allegro.h264.riscv.encoder";
+static char const* MOCK_ENCODER = "OMX.allegro.h264.mock.encoder";
+
+/* Time from OMX_GetHandle to OMX_StateIdle of one more encoder, until numChannels are opened
+ * together. The handles of a device share its context and allocator: the first handle opens them,
+ * the next ones take them. The riscv encoder is only timed where its device is, the mock one has no
+ * device and gives the cost of the component alone */
+void BenchSharedDevice(Bench& bench)
+{
+  if(!bench.IsSelected("shared_device.get_handle_to_idle"))
+    return;
+
+  if(OMX_Init() != OMX_ErrorNone)
+  {
+    bench.Fail("shared_device.get_handle_to_idle", "no component library in OMX_ALLEGRO_PATH");
+    return;
+  }
+
+  static int constexpr ROUNDS = 10;
+
+  for(auto name : { RISCV_ENCODER, MOCK_ENCODER })
+  {
+    for(auto numChannels : { 1, 4, 16 })
+    {
+      chrono::nanoseconds first {};
+      chrono::nanoseconds next {};
+      auto error = OMX_ErrorNone;
+      int numOpened = 0;
+
+      for(int round = 0; round < ROUNDS && error == OMX_ErrorNone; ++round)
+      {
+        // The channels of the round are closed together, the device with the last one
+        vector<unique_ptr<BenchComponent>> channels;
+
+        for(int i = 0; i < numChannels && error == OMX_ErrorNone; ++i)
+        {
+          channels.emplace_back(new BenchComponent {});
+          auto start = chrono::steady_clock::now();
+          error = channels.back()->Open(name);
+          (i == 0 ? first : next) += chrono::steady_clock::now() - start;
+          numOpened += (error == OMX_ErrorNone);
+        }
+      }
+
+      // No riscv device here
+      if(numOpened == 0 && name == RISCV_ENCODER)
+        break;
+
+      auto params = string { name } +", " + to_string(numChannels) + " channels";
+
+      if(error != OMX_ErrorNone)
+      {
+        stringstream message;
+        message << params << ": error 0x" << hex << error;
+        bench.Fail("shared_device.get_handle_to_idle", message.str());
+        continue;
+      }
+
+      bench.Add("shared_device.get_handle_to_idle", params + ", first handle", ROUNDS, first);
+
+      if(numChannels > 1)
+        bench.Add("shared_device.get_handle_to_idle", params + ", next handles", ROUNDS * (numChannels - 1), next);
+    }
+  }
+
+  OMX_Deinit();
+}
@@ -0,0 +1,125 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <module/static_frame_detector.h>
+
+using namespace std;
+
+/* A sequence of frames where up to three bytes change at random positions, among them the
+ * first and last bytes of the tiles, or which goes back to the frame before the previous one.
+ * Each frame must be found unchanged exactly when it equals the previous one. The size is
+ * not a multiple of the tile size, it changes once and the detector is reset once */
+static void CheckStaticFrame(Bench& bench)
+{
+  if(!bench.IsSelected("static_frame.check"))
+    return;
+
+  static int constexpr NUM_FRAMES = 20000;
+  size_t const sizes[] = { 10 * StaticFrameDetector::TILE_SIZE + 123, 3 * StaticFrameDetector::TILE_SIZE };
+  StaticFrameDetector detector;
+  vector<uint8_t> frame(sizes[0]);
+  vector<uint8_t> previous {};
+  vector<uint8_t> older {};
+  uint32_t random = 1;
+  int mismatches = 0, numUnchanged = 0;
+  auto start = chrono::steady_clock::now();
+
+  for(size_t i = 0; i < frame.size(); ++i)
+    frame[i] = static_cast<uint8_t>(i * 7);
+
+  auto next = [&]() {
+                random = random * 1664525u + 1013904223u;
+                return random >> 8;
+              };
+
+  for(int i = 0; i < NUM_FRAMES; ++i)
+  {
+    auto isReset = i == NUM_FRAMES / 4;
+
+    if(i == NUM_FRAMES / 2)
+      frame.resize(sizes[1]);
+    else if(next() % 8 == 0 && older.size() == frame.size())
+      frame = older;
+    else
+    {
+      auto numChanges = next() % 4;
+
+      for(size_t change = 0; change < numChanges; ++change)
+      {
+        auto tile = next() % ((frame.size() + StaticFrameDetector::TILE_SIZE - 1) / StaticFrameDetector::TILE_SIZE);
+        auto tileStart = tile * StaticFrameDetector::TILE_SIZE;
+        auto tileSize = min(StaticFrameDetector::TILE_SIZE, frame.size() - tileStart);
+        auto where = next() % 4;
+        auto position = tileStart + (where == 0 ? 0 : where == 1 ? tileSize - 1 : next() % tileSize);
+        frame[position] ^= static_cast<uint8_t>(1 << (next() % 8));
+      }
+    }
+
+    if(isReset)
+      detector.Reset();
+
+    auto isExpected = !isReset && frame == previous;
+    auto isUnchanged = detector.IsUnchanged(frame.data(), frame.size());
+    mismatches += isUnchanged == isExpected ? 0 : 1;
+    numUnchanged += isUnchanged ? 1 : 0;
+    older = previous;
+    previous = frame;
+  }
+
+  if(mismatches)
+    bench.Fail("static_frame.check", to_string(mismatches) + " frames of " + to_string(NUM_FRAMES) + " wrongly found unchanged or changed");
+  auto params = to_string(numUnchanged) + " unchanged frames, " + to_string(mismatches) + " wrong results";
+  bench.Add("static_frame.check", params, NUM_FRAMES, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start));
+}
+
+/* An nv12 frame compared with itself, or changed at a given position on every other frame */
+void BenchStaticFrame(Bench& bench)
+{
+  CheckStaticFrame(bench);
+
+  struct
+  {
+    char const* name;
+    int width;
+    int height;
+  } const formats[] =
+  {
+    { "1080p", 1920, 1080 }, { "4K", 3840, 2160 }
+  };
+
+  struct
+  {
+    char const* name;
+    double position; // of the changed byte in the frame, negative when the frame is static
+  } const changes[] =
+  {
+    { "static", -1 }, { "change at top", 0.01 }, { "change at bottom", 0.99 }
+  };
+
+  for(auto const& format : formats)
+  {
+    auto size = static_cast<size_t>(format.width) * format.height * 3 / 2;
+    vector<uint8_t> frame(size);
+
+    for(size_t i = 0; i < size; ++i)
+      frame[i] = static_cast<uint8_t>(i * 7);
+
+    for(auto const& change : changes)
+    {
+      StaticFrameDetector detector;
+      detector.IsUnchanged(frame.data(), size);
+      auto position = static_cast<size_t>(change.position * size);
+      auto params = string { format.name } +", " + change.name;
+      bench.Run("static_frame.compare", params, 200, [&]() {
+        if(change.position >= 0)
+          frame[position] ^= 1;
+        detector.IsUnchanged(frame.data(), size);
+      });
+    }
+  }
+}
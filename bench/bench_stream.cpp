@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <algorithm>
+#include <memory>
+
+#include <module/cpp_memory.h>
+#include <module/stream_sections.h>
+
+using namespace std;
+
+extern "C"
+{
+#include <lib_common/Allocator.h>
+#include <lib_common/BufferAPI.h>
+#include <lib_common/BufferStreamMeta.h>
+}
+
+static int constexpr NUM_CONFIG_SECTIONS = 3;
+static int constexpr CONFIG_SECTION_SIZE = 64;
+static int constexpr SECTION_ALIGNMENT = 4096;
+
+/* Sections are spread with gaps, as the hardware writes them at aligned offsets */
+static AL_TBuffer* CreateSyntheticStream(int numSections, int sectionSize)
+{
+  auto numTotalSections = NUM_CONFIG_SECTIONS + numSections;
+  auto stride = (max(sectionSize, CONFIG_SECTION_SIZE) + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+  auto stream = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), numTotalSections * stride, AL_Buffer_Destroy);
+  auto meta = AL_StreamMetaData_Create(numTotalSections);
+
+  for(int i = 0; i < NUM_CONFIG_SECTIONS; ++i)
+    AL_StreamMetaData_AddSection(meta, i * stride, CONFIG_SECTION_SIZE, AL_SECTION_CONFIG_FLAG);
+
+  for(int i = 0; i < numSections; ++i)
+  {
+    auto isLast = (i == numSections - 1);
+    AL_StreamMetaData_AddSection(meta, (NUM_CONFIG_SECTIONS + i) * stride, sectionSize, isLast ? AL_SECTION_END_FRAME_FLAG : AL_SECTION_NO_FLAG);
+  }
+
+  AL_Buffer_AddMetaData(stream, reinterpret_cast<AL_TMetaData*>(meta));
+  return stream;
+}
+
+void BenchStream(Bench& bench)
+{
+  shared_ptr<MemoryInterface> memory { new CPPMemory {} };
+  auto config = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), NUM_CONFIG_SECTIONS * CONFIG_SECTION_SIZE, AL_Buffer_Destroy);
+
+  for(auto numSections : { 1, 8, 32 })
+  {
+    for(auto frameSize : { 16 * 1024, 512 * 1024 })
+    {
+      auto stream = CreateSyntheticStream(numSections, frameSize / numSections);
+      auto params = to_string(numSections) + " sections, " + to_string(frameSize / 1024) + " KiB";
+
+      bench.Run("stream.construct_config", params, 1000, [&]() {
+        int firstSection = 0;
+        ConstructConfigStream(memory, config, stream, firstSection);
+      });
+
+      bench.Run("stream.reconstruct", params, 1000, [&]() {
+        ReconstructStream(memory, stream, NUM_CONFIG_SECTIONS);
+      });
+
+      AL_Buffer_Destroy(stream);
+    }
+  }
+
+  AL_Buffer_Destroy(config);
+}
@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <utility/processor_fifo.h>
+#include <utility/semaphore.h>
+
+using namespace std;
+
+/* Time from the queueing of a task to its start on the processor thread, one task per
+ * millisecond, with the default scheduling or with the thread pinned on the first cpu
+ * under SCHED_FIFO. The params tell when the system refused the real time policy */
+void BenchThreadScheduling(Bench& bench)
+{
+  if(!bench.IsSelected("processor_fifo.wake_up"))
+    return;
+
+  static int constexpr NUM_TASKS = 500;
+
+  for(auto isRealTime : { false, true })
+  {
+    vector<chrono::nanoseconds> latencies;
+    semaphore done {};
+    ProcessorFifo<chrono::steady_clock::time_point> fifo { [&](chrono::steady_clock::time_point queuedAt) {
+                                                             latencies.push_back(chrono::steady_clock::now() - queuedAt);
+                                                             done.notify();
+                                                           }, nullptr, "Bench - Wake" };
+    string params = "default";
+
+    if(isRealTime)
+    {
+      ThreadScheduling scheduling {
+        1, SchedulingPolicy::FIFO, 50
+      };
+      params = fifo.SetScheduling(scheduling) ? ToString(fifo.GetScheduling()) : "refused, " + ToString(fifo.GetScheduling());
+    }
+
+    for(int i = 0; i < NUM_TASKS; ++i)
+    {
+      this_thread::sleep_for(chrono::milliseconds(1));
+      fifo.queue(chrono::steady_clock::now());
+      done.wait();
+    }
+
+    sort(latencies.begin(), latencies.end());
+
+    for(auto percentile : { 50, 99 })
+    {
+      auto index = min(latencies.size() - 1, latencies.size() * percentile / 100);
+      bench.Add("processor_fifo.wake_up", params + ", p" + to_string(percentile), 1, latencies[index]);
+    }
+
+    bench.Add("processor_fifo.wake_up", params + ", max", 1, latencies.back());
+  }
+}
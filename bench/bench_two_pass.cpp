@@ -0,0 +1,618 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <sstream>
+#include <thread>
+
+#include <module/TwoPassMngr.h>
+#include <module/two_pass_log.h>
+
+using namespace std;
+
+extern "C"
+{
+#include <lib_common/Allocator.h>
+#include <lib_common/BufferAPI.h>
+#include <lib_common/BufferLookAheadMeta.h>
+}
+
+static char const* LOG_FILE = "omx_bench_two_pass.log";
+static char const* TEXT_LOG_FILE = "omx_bench_two_pass.txt";
+static int constexpr GOP_LENGTH = 30;
+static int constexpr CPB_LEVEL = 1000;
+static int constexpr INITIAL_LEVEL = 500;
+static int constexpr FRAMERATE = 30;
+static int constexpr LOOKAHEAD = 30;
+static int constexpr FIRST_PASS_FRAMES = 1200;
+static chrono::microseconds constexpr FIRST_PASS_ENCODE_TIME { 500 };
+
+/* Intra frame every gop, a scene cut every 7 gops */
+static void FillSyntheticFrame(AL_TLookAheadMetaData* meta, int frame)
+{
+  AL_LookAheadMetaData_Reset(meta);
+  auto isIntra = (frame % GOP_LENGTH) == 0;
+  auto isCut = (frame % (7 * GOP_LENGTH)) == 3;
+  meta->iPictureSize = (isIntra ? 60000 : 8000) + (frame * 7919) % 4000;
+  meta->iPercentIntra[0] = isCut ? 98 : isIntra ? 100 : (frame * 13) % 30;
+}
+
+/* A src buffer per frame, kept until it leaves a lookahead window, as in the encoder module */
+static void BenchMetaData(Bench& bench)
+{
+  deque<AL_TBuffer*> window;
+  auto pool = make_shared<LookAheadMetaDataPool>(LOOKAHEAD + 2);
+  auto params = to_string(LOOKAHEAD) + " frames lookahead";
+
+  auto addFrame = [&](bool pooled) {
+                    auto src = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), 64, AL_Buffer_Destroy);
+                    AL_Buffer_Ref(src);
+                    auto meta = pooled ? pool->CreateAndAttach(src) : AL_LookAheadMetaData_Create();
+
+                    if(!pooled)
+                      AL_Buffer_AddMetaData(src, reinterpret_cast<AL_TMetaData*>(meta));
+                    window.push_back(src);
+
+                    if((int)window.size() > LOOKAHEAD)
+                    {
+                      AL_Buffer_Unref(window.front());
+                      window.pop_front();
+                    }
+                  };
+
+  auto drain = [&]() {
+                 for(auto src : window)
+                   AL_Buffer_Unref(src);
+
+                 window.clear();
+               };
+
+  bench.Run("two_pass.meta_create", params, 100000, [&]() { addFrame(false); });
+  drain();
+  bench.Run("two_pass.meta_pool", params, 100000, [&]() { addFrame(true); });
+  drain();
+}
+
+/* Each chunk on its own channel, where a frame takes the time of its encoding, then the merge of their logfiles */
+static void BenchFirstPassChunks(Bench& bench)
+{
+  if(!bench.IsSelected("two_pass.first_pass_chunks"))
+    return;
+
+  for(auto numChunks : { 1, 2, 4, 8 })
+  {
+    auto start = chrono::steady_clock::now();
+    auto chunks = SplitTwoPassIntoChunks(FIRST_PASS_FRAMES, numChunks, GOP_LENGTH);
+    vector<thread> channels;
+
+    for(int i = 0; i < (int)chunks.size(); ++i)
+    {
+      channels.emplace_back([&, i]() {
+        auto const& chunk = chunks[i];
+        auto meta = AL_LookAheadMetaData_Create();
+        {
+          TwoPassMngr pass1 { GetTwoPassChunkLogName(LOG_FILE, i), 1, false, GOP_LENGTH, CPB_LEVEL, INITIAL_LEVEL, FRAMERATE };
+
+          for(int frame = chunk.iFirstFrame - chunk.iNumWarmUpFrames; frame < chunk.iFirstFrame + chunk.iNumFrames; ++frame)
+          {
+            this_thread::sleep_for(FIRST_PASS_ENCODE_TIME);
+            FillSyntheticFrame(meta, frame);
+            pass1.AddFrame(meta);
+          }
+
+          pass1.Flush();
+        }
+        AL_MetaData_Destroy(reinterpret_cast<AL_TMetaData*>(meta));
+      });
+    }
+
+    for(auto& channel : channels)
+      channel.join();
+
+    MergeTwoPassChunkLogs(LOG_FILE, chunks);
+    bench.Add("two_pass.first_pass_chunks", to_string(chunks.size()) + " chunks", FIRST_PASS_FRAMES, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start));
+
+    for(int i = 0; i < (int)chunks.size(); ++i)
+      remove(GetTwoPassChunkLogName(LOG_FILE, i).c_str());
+  }
+
+  remove(LOG_FILE);
+}
+
+/* The second pass as it was before the sliding window: the logfile is cut in chunks of
+ * CHECK_CHUNK_SIZE frames, each computed as a whole sequence. Kept as the reference of the
+ * window, which must give the same frames on the logfiles holding in a chunk */
+static int constexpr CHECK_CHUNK_SIZE = 1000;
+
+struct CheckFrame
+{
+  int iPictureSize;
+  int iPercentIntra;
+};
+
+static bool IsReferenceSceneChange(AL_TLookAheadMetaData const& tPrev, AL_TLookAheadMetaData const& tCurrent)
+{
+  auto iPercent = 100 * tCurrent.iPercentIntra[0];
+  auto iIntraRatio = (tPrev.iPercentIntra[0] != 0) ? iPercent / tPrev.iPercentIntra[0] : iPercent;
+  return (tCurrent.iPercentIntra[0] >= 95 && iIntraRatio > 135) || (tCurrent.iPercentIntra[0] >= 80 && iIntraRatio > 200);
+}
+
+static int32_t GetReferenceIPRatio(AL_TLookAheadMetaData const& tCurrent, AL_TLookAheadMetaData const& tNext)
+{
+  if(!tNext.iPictureSize)
+    return 1000;
+
+  return max(static_cast<int64_t>(100), 1000 * static_cast<int64_t>(tCurrent.iPictureSize) / tNext.iPictureSize);
+}
+
+static bool HasReferencePatternTwoFrames(vector<AL_TLookAheadMetaData> const& tFrames)
+{
+  if(tFrames.size() < 5)
+    return false;
+
+  int iNumZeros = 0, iRun = 0, iRunMax = 0;
+
+  for(size_t i = 1; i < tFrames.size(); i++)
+  {
+    if(tFrames[i].iPercentIntra[0] == 0)
+    {
+      iNumZeros++;
+      iRunMax = max(iRunMax, iRun);
+      iRun = 0;
+    }
+    else
+      iRun++;
+  }
+
+  return iRunMax == 1 && iNumZeros >= (static_cast<int>(tFrames.size()) - 1) / 2;
+}
+
+static void ComputeReferenceChunk(vector<AL_TLookAheadMetaData>& tFrames)
+{
+  auto iSize = static_cast<int>(tFrames.size());
+
+  if(HasReferencePatternTwoFrames(tFrames))
+  {
+    for(int i = 0; i < iSize - 1; i++)
+      tFrames[i].iPictureSize = 0;
+
+    return;
+  }
+
+  for(int i = 0; i < iSize - 1; i++)
+    tFrames[i].eSceneChange = IsReferenceSceneChange(tFrames[i], tFrames[i + 1]) ? AL_SC_NEXT : AL_SC_NONE;
+
+  for(int i = 0; i < iSize - 1; i++)
+  {
+    tFrames[i].iIPRatio = GetReferenceIPRatio(tFrames[i], tFrames[i + 1]);
+
+    for(int k = i + 2; k < min(iSize, i + 4) && !IsReferenceSceneChange(tFrames[k - 1], tFrames[k]); k++)
+      tFrames[i].iIPRatio = min(tFrames[i].iIPRatio, GetReferenceIPRatio(tFrames[i], tFrames[k]));
+  }
+
+  /* The gops end on the scene changes */
+  vector<int> tGopLengths;
+  size_t uSumCompGops = 0;
+
+  for(int iIndex = 0; iIndex < iSize;)
+  {
+    int iLength = 0;
+    size_t uSumComp = 0;
+
+    while(iLength < GOP_LENGTH && iIndex + iLength < iSize)
+    {
+      uSumComp += tFrames[iIndex + iLength].iPictureSize;
+      iLength++;
+
+      if(tFrames[iIndex + iLength - 1].eSceneChange == AL_SC_NEXT)
+        break;
+    }
+
+    for(int k = 0; k < iLength; k++)
+      tFrames[iIndex + k].iComplexity = uSumComp / iLength;
+
+    uSumCompGops += uSumComp / iLength;
+    tGopLengths.push_back(iLength);
+    iIndex += iLength;
+  }
+
+  int iMeanComp = uSumCompGops / tGopLengths.size();
+  int iLevel = 0, iLevelMax = 0, iLevelMin = 0;
+
+  for(auto& tFrame : tFrames)
+  {
+    tFrame.iComplexity = (tFrame.iComplexity * 1000 / iMeanComp) - 1000;
+    iLevel -= tFrame.iComplexity / FRAMERATE;
+    iLevelMax = max(iLevelMax, iLevel);
+    iLevelMin = min(iLevelMin, iLevel);
+  }
+
+  int iCoeff = 1000;
+
+  if(iLevelMax > 0)
+    iCoeff = min(iCoeff, (CPB_LEVEL - INITIAL_LEVEL) * 1000 / iLevelMax);
+
+  if(iLevelMin < 0)
+    iCoeff = min(iCoeff, -INITIAL_LEVEL * 900 / iLevelMin);
+
+  for(auto& tFrame : tFrames)
+    tFrame.iComplexity = (tFrame.iComplexity * iCoeff / 1000) + 1000;
+
+  iLevel = INITIAL_LEVEL;
+  int iIndex = 0;
+
+  for(auto iLength : tGopLengths)
+  {
+    int iTarget = iLevel - GOP_LENGTH * (tFrames[iIndex].iComplexity - 1000) / FRAMERATE;
+    iLevel -= iLength * (tFrames[iIndex].iComplexity - 1000) / FRAMERATE;
+
+    for(int k = 0; k < iLength; k++)
+      tFrames[iIndex + k].iTargetLevel = iTarget;
+
+    iIndex += iLength;
+  }
+}
+
+static vector<AL_TLookAheadMetaData> ComputeReference(vector<CheckFrame> const& tLog)
+{
+  vector<AL_TLookAheadMetaData> tResult;
+
+  for(size_t uStart = 0; uStart < tLog.size(); uStart += CHECK_CHUNK_SIZE)
+  {
+    vector<AL_TLookAheadMetaData> tChunk;
+
+    for(size_t i = uStart; i < min(tLog.size(), uStart + CHECK_CHUNK_SIZE); i++)
+    {
+      AL_TLookAheadMetaData tMeta {};
+      tMeta.iPictureSize = tLog[i].iPictureSize;
+      tMeta.iPercentIntra[0] = tLog[i].iPercentIntra;
+      tMeta.eSceneChange = AL_SC_NONE;
+      tMeta.iIPRatio = 1000;
+      tChunk.push_back(tMeta);
+    }
+
+    ComputeReferenceChunk(tChunk);
+    tResult.insert(tResult.end(), tChunk.begin(), tChunk.end());
+  }
+
+  return tResult;
+}
+
+/* Random walk of the complexity with scene cuts, or the two frames pattern when isPattern is set */
+static vector<CheckFrame> CreateCheckLog(int numFrames, int seed, bool isPattern)
+{
+  vector<CheckFrame> tLog;
+  uint32_t random = seed * 2654435761u + 1;
+  int level = 8000;
+
+  for(int frame = 0; frame < numFrames; ++frame)
+  {
+    random = random * 1664525u + 1013904223u;
+    level = min(30000, max(2000, level + static_cast<int>(random >> 20) % 1001 - 500));
+    auto isIntra = (frame % GOP_LENGTH) == 0;
+    auto isCut = (random >> 8) % 97 == 0;
+    auto percentIntra = isPattern ? (frame % 2) * 5 : isCut ? 98 : isIntra ? 100 : static_cast<int>((random >> 12) % 30);
+    tLog.push_back(CheckFrame { (isIntra ? 6 : 1) * level, percentIntra });
+  }
+
+  return tLog;
+}
+
+static bool IsSameFrame(AL_TLookAheadMetaData const& tWindow, AL_TLookAheadMetaData const& tReference)
+{
+  return tWindow.iPictureSize == tReference.iPictureSize && tWindow.iPercentIntra[0] == tReference.iPercentIntra[0]
+         && tWindow.eSceneChange == tReference.eSceneChange && tWindow.iIPRatio == tReference.iIPRatio
+         && tWindow.iComplexity == tReference.iComplexity && tWindow.iTargetLevel == tReference.iTargetLevel;
+}
+
+/* Mean jump of the complexity between two consecutive frames without a scene change between
+ * them, at the chunk borders of the reference or elsewhere */
+static void GetComplexityJumps(vector<AL_TLookAheadMetaData> const& tFrames, double& atBorders, double& elsewhere)
+{
+  int64_t sums[2] {};
+  int64_t counts[2] {};
+
+  for(size_t i = 1; i < tFrames.size(); i++)
+  {
+    if(tFrames[i - 1].eSceneChange == AL_SC_NEXT)
+      continue;
+
+    auto isBorder = (i % CHECK_CHUNK_SIZE) == 0;
+    sums[isBorder] += abs(tFrames[i].iComplexity - tFrames[i - 1].iComplexity);
+    counts[isBorder]++;
+  }
+
+  atBorders = counts[1] ? static_cast<double>(sums[1]) / counts[1] : 0;
+  elsewhere = counts[0] ? static_cast<double>(sums[0]) / counts[0] : 0;
+}
+
+/* The window must give the frames of the chunked reference when the whole logfile holds in a
+ * chunk. On longer logfiles, the complexity must no longer jump at the chunk borders */
+static void CheckWindow(Bench& bench)
+{
+  if(!bench.IsSelected("two_pass.window_check"))
+    return;
+
+  auto meta = AL_LookAheadMetaData_Create();
+
+  for(auto numFrames : { 1, 5, 299, 500, 501, 999, 1000, 1001, 100000 })
+  {
+    int mismatches = 0;
+    double jumps[2][2] {};
+    auto start = chrono::steady_clock::now();
+
+    for(int seed = 0; seed < 4; ++seed)
+    {
+      auto tLog = CreateCheckLog(numFrames, seed, seed == 3);
+      {
+        TwoPassMngr pass1 { LOG_FILE, 1, false, GOP_LENGTH, CPB_LEVEL, INITIAL_LEVEL, FRAMERATE };
+
+        for(auto const& frame : tLog)
+        {
+          AL_LookAheadMetaData_Reset(meta);
+          meta->iPictureSize = frame.iPictureSize;
+          meta->iPercentIntra[0] = frame.iPercentIntra;
+          pass1.AddFrame(meta);
+        }
+
+        pass1.Flush();
+      }
+
+      vector<AL_TLookAheadMetaData> tWindow;
+      {
+        TwoPassMngr pass2 { LOG_FILE, 2, false, GOP_LENGTH, CPB_LEVEL, INITIAL_LEVEL, FRAMERATE };
+
+        for(int frame = 0; frame < numFrames; ++frame)
+        {
+          pass2.GetFrame(meta);
+          tWindow.push_back(*meta);
+        }
+      }
+
+      auto tReference = ComputeReference(tLog);
+
+      if(numFrames <= CHECK_CHUNK_SIZE)
+      {
+        for(int frame = 0; frame < numFrames; ++frame)
+          mismatches += IsSameFrame(tWindow[frame], tReference[frame]) ? 0 : 1;
+      }
+
+      double atBorders, elsewhere;
+      GetComplexityJumps(tWindow, atBorders, elsewhere);
+      jumps[0][0] += atBorders / 4;
+      jumps[0][1] += elsewhere / 4;
+      GetComplexityJumps(tReference, atBorders, elsewhere);
+      jumps[1][0] += atBorders / 4;
+      jumps[1][1] += elsewhere / 4;
+    }
+
+    stringstream params;
+    params.precision(3);
+    params << numFrames << " frames";
+
+    if(numFrames <= CHECK_CHUNK_SIZE)
+    {
+      params << ", " << mismatches << " frames differ from the chunks";
+
+      if(mismatches)
+        bench.Fail("two_pass.window_check", to_string(mismatches) + " frames of the " + to_string(numFrames) + " frames logfiles differ from the chunked second pass");
+    }
+    else
+      params << ", complexity jump at chunk borders " << jumps[0][0] << " instead of " << jumps[1][0]
+             << ", elsewhere " << jumps[0][1] << " instead of " << jumps[1][1];
+    bench.Add("two_pass.window_check", params.str(), 4 * numFrames, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start));
+  }
+
+  AL_MetaData_Destroy(reinterpret_cast<AL_TMetaData*>(meta));
+  remove(LOG_FILE);
+}
+
+/* The lookahead as it was before LookAheadMngr kept its scene changes and sizes: each
+ * processed frame rescans the fifo. Kept as the reference of LookAheadMngr */
+struct ReferenceLookAhead
+{
+  ReferenceLookAhead(int size) : size{size}, isComplexityUsed{size >= 10}
+  {
+  }
+
+  int size;
+  bool isComplexityUsed;
+  deque<AL_TLookAheadMetaData*> fifo;
+  int complexity = 1000;
+  int frameCount = 0;
+  int complexityDiff = 0;
+
+  int GetNextSceneChange()
+  {
+    int iFifoSize = static_cast<int>(fifo.size());
+    int iIndex = 0;
+
+    while((iIndex + 1 < iFifoSize) && !IsReferenceSceneChange(*fifo[iIndex], *fifo[iIndex + 1]))
+      iIndex++;
+
+    if(iFifoSize < 2 || iIndex + 1 == iFifoSize)
+      return iFifoSize;
+    return iIndex + 1;
+  }
+
+  void ComputeComplexity()
+  {
+    int iFifoSize = static_cast<int>(fifo.size());
+
+    if(frameCount % 5 == 0)
+    {
+      frameCount = 0;
+      complexity = 1000;
+
+      if(iFifoSize >= 5)
+      {
+        intmax_t iComp[2] = { 0, 0 };
+
+        for(int i = 0; i < iFifoSize; i++)
+          iComp[(i < 5) ? 0 : 1] += fifo[i]->iPictureSize;
+
+        complexity = ((1000 * iFifoSize / 5) + complexityDiff) * iComp[0] / (iComp[0] + iComp[1]);
+        complexity = min(3000, max(100, complexity));
+        complexityDiff += (1000 - complexity);
+      }
+    }
+
+    frameCount++;
+
+    if(iFifoSize >= 2 && IsReferenceSceneChange(*fifo[0], *fifo[1]))
+      frameCount = 0;
+  }
+
+  void ProcessLookAheadParams()
+  {
+    auto pMeta = fifo.front();
+
+    if(isComplexityUsed)
+    {
+      ComputeComplexity();
+      pMeta->iComplexity = complexity;
+    }
+
+    if(fifo.size() < 2)
+      return;
+
+    pMeta->eSceneChange = IsReferenceSceneChange(*fifo[0], *fifo[1]) ? AL_SC_NEXT : AL_SC_NONE;
+    pMeta->iIPRatio = GetReferenceIPRatio(*fifo[0], *fifo[1]);
+    int iNextSceneChange = GetNextSceneChange();
+
+    for(int i = 2; i < min(iNextSceneChange, 4); i++)
+      pMeta->iIPRatio = min(pMeta->iIPRatio, GetReferenceIPRatio(*fifo[0], *fifo[i]));
+  }
+};
+
+/* Drives LookAheadMngr and the reference the way the engine thread of the encoder module
+ * does, over two streams separated by an end of stream: the last frames are processed with
+ * fewer frames behind them */
+static void CheckLookAhead(Bench& bench)
+{
+  if(!bench.IsSelected("two_pass.lookahead_check"))
+    return;
+
+  static int constexpr NUM_FRAMES = 2000;
+
+  for(auto size : { 2, 5, 10, 30, 60 })
+  {
+    int mismatches = 0;
+    auto start = chrono::steady_clock::now();
+
+    for(int seed = 0; seed < 4; ++seed)
+    {
+      LookAheadMngr mngr { size, false };
+      ReferenceLookAhead reference { size };
+      vector<AL_TLookAheadMetaData*> references;
+
+      auto process = [&]() {
+                       mngr.ProcessLookAheadParams();
+                       reference.ProcessLookAheadParams();
+                       auto src = mngr.Pop();
+                       auto pMeta = reinterpret_cast<AL_TLookAheadMetaData*>(AL_Buffer_GetMetaData(src, AL_META_TYPE_LOOKAHEAD));
+                       auto pReference = reference.fifo.front();
+                       reference.fifo.pop_front();
+
+                       if(pMeta->eSceneChange != pReference->eSceneChange || pMeta->iIPRatio != pReference->iIPRatio || pMeta->iComplexity != pReference->iComplexity)
+                         mismatches++;
+
+                       AL_Buffer_Unref(src);
+                     };
+
+      for(auto numFrames : { NUM_FRAMES / 2 + seed, NUM_FRAMES / 2 - seed })
+      {
+        for(auto const& frame : CreateCheckLog(numFrames, seed + numFrames, seed == 3))
+        {
+          auto src = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), 64, AL_Buffer_Destroy);
+          AL_Buffer_Ref(src);
+          auto pMeta = AL_LookAheadMetaData_Create();
+          pMeta->iPictureSize = frame.iPictureSize;
+          pMeta->iPercentIntra[0] = frame.iPercentIntra;
+          AL_Buffer_AddMetaData(src, reinterpret_cast<AL_TMetaData*>(pMeta));
+
+          auto pReference = AL_LookAheadMetaData_Create();
+          AL_LookAheadMetaData_Copy(pMeta, pReference);
+          references.push_back(pReference);
+
+          mngr.Push(src);
+          reference.fifo.push_back(pReference);
+
+          while((int)mngr.m_fifo.size() >= size)
+            process();
+        }
+
+        // End of stream
+        while(!mngr.m_fifo.empty())
+          process();
+      }
+
+      for(auto pReference : references)
+        AL_MetaData_Destroy(reinterpret_cast<AL_TMetaData*>(pReference));
+    }
+
+    auto params = to_string(size) + " frames lookahead, " + to_string(mismatches) + " frames differ from the rescan";
+
+    if(mismatches)
+      bench.Fail("two_pass.lookahead_check", to_string(mismatches) + " frames with a " + to_string(size) + " frames lookahead differ from the rescan of the fifo");
+    bench.Add("two_pass.lookahead_check", params, 4 * NUM_FRAMES, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start));
+  }
+}
+
+void BenchTwoPass(Bench& bench)
+{
+  BenchMetaData(bench);
+  BenchFirstPassChunks(bench);
+  CheckWindow(bench);
+  CheckLookAhead(bench);
+
+  auto meta = AL_LookAheadMetaData_Create();
+
+  /* The text format is written when the logfile name ends with .txt */
+  for(auto logFile : { LOG_FILE, TEXT_LOG_FILE })
+  {
+    for(auto numFrames : { 10000, 100000, 1000000 })
+    {
+      auto params = to_string(numFrames) + " frames, " + (logFile == LOG_FILE ? "binary" : "text");
+
+      if(bench.IsSelected("two_pass.write_log"))
+      {
+        auto start = chrono::steady_clock::now();
+        {
+          TwoPassMngr pass1 { logFile, 1, false, GOP_LENGTH, CPB_LEVEL, INITIAL_LEVEL, FRAMERATE };
+
+          for(int frame = 0; frame < numFrames; ++frame)
+          {
+            FillSyntheticFrame(meta, frame);
+            pass1.AddFrame(meta);
+          }
+
+          pass1.Flush();
+        }
+        bench.Add("two_pass.write_log", params, numFrames, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start));
+      }
+
+      /* Reading back includes the parsing and ComputeTwoPass of each chunk */
+      if(bench.IsSelected("two_pass.read_log"))
+      {
+        auto start = chrono::steady_clock::now();
+        {
+          TwoPassMngr pass2 { logFile, 2, false, GOP_LENGTH, CPB_LEVEL, INITIAL_LEVEL, FRAMERATE };
+
+          for(int frame = 0; frame < numFrames; ++frame)
+            pass2.GetFrame(meta);
+        }
+        bench.Add("two_pass.read_log", params, numFrames, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start));
+      }
+    }
+
+    remove(logFile);
+  }
+
+  AL_MetaData_Destroy(reinterpret_cast<AL_TMetaData*>(meta));
+}
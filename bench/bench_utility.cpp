@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <thread>
+
+#include <utility/locked_queue.h>
+#include <utility/processor_fifo.h>
+#include <utility/semaphore.h>
+#include <utility/threadsafe_map.h>
+
+using namespace std;
+
+static int constexpr NUM_ROUND_TRIPS = 100000;
+
+static void BenchLockedQueue(Bench& bench)
+{
+  locked_queue<int> queue {};
+  bench.Run("locked_queue.push_pop", "single thread", NUM_ROUND_TRIPS, [&]() {
+    queue.push(1);
+    queue.pop();
+  });
+
+  if(!bench.IsSelected("locked_queue.ping_pong"))
+    return;
+
+  /* One round trip is a push to the other thread and the wait for its answer */
+  locked_queue<int> ping {};
+  locked_queue<int> pong {};
+  thread peer { [&]() {
+                  for(int i = 0; i <= NUM_ROUND_TRIPS; ++i)
+                    pong.push(ping.pop());
+                } };
+
+  bench.Run("locked_queue.ping_pong", "two threads", NUM_ROUND_TRIPS, [&]() {
+    ping.push(1);
+    pong.pop();
+  });
+  peer.join();
+}
+
+static void BenchThreadSafeMap(Bench& bench)
+{
+  for(auto numEntries : { 16, 256 })
+  {
+    ThreadSafeMap<void*, void*> map {};
+    vector<char> keys(numEntries);
+
+    for(int i = 0; i < numEntries - 1; ++i)
+      map.Add(&keys[i], nullptr);
+
+    /* Mimics a buffer going through the module: added, looked up and popped */
+    auto key = &keys[numEntries - 1];
+    bench.Run("threadsafe_map.add_get_pop", to_string(numEntries) + " entries", NUM_ROUND_TRIPS, [&]() {
+      map.Add(key, key);
+      map.Exist(key);
+      map.Get(key);
+      map.Pop(key);
+    });
+  }
+}
+
+static void BenchProcessorFifo(Bench& bench)
+{
+  semaphore done {};
+  ProcessorFifo<int> fifo { [&](int) {
+                              done.notify();
+                            }, [&](int) {
+                              done.notify();
+                            }, "Bench - Fifo" };
+
+  bench.Run("processor_fifo.round_trip", "queue then wait", NUM_ROUND_TRIPS, [&]() {
+    fifo.queue(1);
+    done.wait();
+  });
+
+  bench.Run("processor_fifo.burst", "64 tasks per wait", NUM_ROUND_TRIPS / 64, [&]() {
+    for(int i = 0; i < 64; ++i)
+      fifo.queue(i);
+
+    for(int i = 0; i < 64; ++i)
+      done.wait();
+  });
+}
+
+void BenchUtility(Bench& bench)
+{
+  BenchLockedQueue(bench);
+  BenchThreadSafeMap(bench);
+  BenchProcessorFifo(bench);
+}
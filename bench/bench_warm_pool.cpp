@@ -0,0 +1,146 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+#include "bench_component.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static char const* RISCV_ENCODER = "OMX.allegro.h264.riscv.encoder";
+static char const* MOCK_ENCODER = "OMX.allegro.h264.mock.encoder";
+static int constexpr WIDTH = 1920;
+static int constexpr HEIGHT = 1080;
+static int constexpr FRAMERATE = 60;
+static int constexpr POOL_SIZE = 2;
+static int constexpr NUM_STARTS = 100;
+static chrono::milliseconds constexpr REFILL_TIME {
+  20
+};
+
+/* From OMX_GetHandle to OMX_StateIdle, the buffers allocated by the component. The raw port is the
+ * one the core prepares its warm components with */
+static OMX_ERRORTYPE Start(BenchComponent& component, string const& name)
+{
+  auto ret = component.GetHandle(name);
+
+  if(ret == OMX_ErrorNone)
+    ret = component.SetRawPort(WIDTH, HEIGHT, FRAMERATE);
+
+  if(ret == OMX_ErrorNone)
+    ret = component.SetState(OMX_StateIdle);
+
+  return ret;
+}
+
+/* The starts are spread out, leaving the pool time to refill, or come in bursts of twice the pool
+ * size. The components are closed between the starts, out of the timings */
+static OMX_ERRORTYPE TimeStarts(string const& name, bool isBurst, vector<chrono::nanoseconds>& latencies)
+{
+  for(int i = 0; i < NUM_STARTS; ++i)
+  {
+    if(!isBurst || i % (2 * POOL_SIZE) == 0)
+      this_thread::sleep_for(REFILL_TIME);
+
+    BenchComponent component;
+    auto start = chrono::steady_clock::now();
+    auto ret = Start(component, name);
+    latencies.push_back(chrono::steady_clock::now() - start);
+
+    if(ret != OMX_ErrorNone)
+      return ret;
+  }
+
+  return OMX_ErrorNone;
+}
+
+static void AddPercentiles(Bench& bench, string const& name, string const& params, vector<chrono::nanoseconds>& latencies)
+{
+  sort(latencies.begin(), latencies.end());
+
+  for(auto percentile : { 50, 90, 99 })
+  {
+    auto index = min(latencies.size() - 1, latencies.size() * percentile / 100);
+    bench.Add(name, params + ", p" + to_string(percentile), 1, latencies[index]);
+  }
+}
+
+struct WarmPoolConfiguration
+{
+  char const* description;
+  string entry; // of OMX_ALLEGRO_WARM_POOL, without the component name
+};
+
+/* Latency of starting an encoder through the core: built on OMX_GetHandle, taken from a warm pool
+ * with its default settings, or taken from a warm pool prepared at the resolution of the
+ * application, with its channel and the buffers of its ports. The riscv encoder is only timed
+ * where its device is, the mock one prepares its buffers but has no channel to create */
+void BenchWarmPool(Bench& bench)
+{
+  if(!bench.IsSelected("warm_pool.start"))
+    return;
+
+  auto resolution = to_string(WIDTH) + "x" + to_string(HEIGHT) + "@" + to_string(FRAMERATE);
+  WarmPoolConfiguration const configurations[] = {
+    { "cold", "" },
+    { "warm pool", to_string(POOL_SIZE) },
+    { "prepared warm pool", to_string(POOL_SIZE) + ":" + resolution },
+  };
+  auto environment = getenv("OMX_ALLEGRO_WARM_POOL");
+  string previousPool = environment ? environment : "";
+
+  for(auto name : { RISCV_ENCODER, MOCK_ENCODER })
+  {
+    for(auto const& configuration : configurations)
+    {
+      if(configuration.entry.empty())
+        unsetenv("OMX_ALLEGRO_WARM_POOL");
+      else
+        setenv("OMX_ALLEGRO_WARM_POOL", (string { name } +"=" + configuration.entry).c_str(), 1);
+
+      if(OMX_Init() != OMX_ErrorNone)
+      {
+        bench.Fail("warm_pool.start", "no component library in OMX_ALLEGRO_PATH");
+        break;
+      }
+
+      auto error = OMX_ErrorNone;
+
+      for(auto isBurst : { false, true })
+      {
+        vector<chrono::nanoseconds> latencies;
+        error = TimeStarts(name, isBurst, latencies);
+        auto params = string { name } +", " + resolution + ", " + configuration.description + (isBurst ? ", burst" : ", spread");
+
+        if(error != OMX_ErrorNone)
+        {
+          // No riscv device here
+          if(name == RISCV_ENCODER && latencies.size() == 1)
+            break;
+
+          stringstream message;
+          message << params << ": error 0x" << hex << error << " at start " << dec << latencies.size();
+          bench.Fail("warm_pool.start", message.str());
+          continue;
+        }
+
+        AddPercentiles(bench, "warm_pool.start", params, latencies);
+      }
+
+      OMX_Deinit();
+
+      if(error != OMX_ErrorNone && name == RISCV_ENCODER)
+        break;
+    }
+  }
+
+  if(previousPool.empty())
+    unsetenv("OMX_ALLEGRO_WARM_POOL");
+  else
+    setenv("OMX_ALLEGRO_WARM_POOL", previousPool.c_str(), 1);
+}
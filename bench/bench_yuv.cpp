@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include <OMX_IVCommonAlg.h>
+#include <exe_omx/common/YuvReadWrite.h>
+#include <utility/round.h>
+
+using namespace std;
+
+static char const* YUV_FILE = "omx_bench_yuv.yuv";
+static int constexpr NUM_FRAMES = 30;
+static int constexpr WIDTH = 1920;
+static int constexpr HEIGHT = 1080;
+
+void BenchYuv(Bench& bench)
+{
+  struct
+  {
+    char const* name;
+    OMX_ALG_COLOR_FORMATTYPE format;
+  } const formats[] =
+  {
+    { "NV12", OMX_ALG_COLOR_FormatYUV420SemiPlanar },
+    { "P010", OMX_ALG_COLOR_FormatYUV420SemiPlanar10bit },
+    { "NV16", OMX_ALG_COLOR_FormatYUV422SemiPlanar },
+    { "T608", OMX_ALG_COLOR_FormatYUV420SemiPlanar8bitTiled64x4 },
+    { "XV15", OMX_ALG_COLOR_FormatYUV420SemiPlanar10bitPacked },
+  };
+
+  /* Large enough for every format above */
+  auto const stride = RoundUp(WIDTH, 64) * 6;
+  auto const strideHeight = HEIGHT;
+  vector<char> frame(stride * strideHeight * 3, 0x42);
+  auto params = string { "1080p, " } +to_string(NUM_FRAMES) + " frames";
+
+  for(auto const& format : formats)
+  {
+    auto color = static_cast<OMX_COLOR_FORMATTYPE>(format.format);
+
+    auto write = [&]() {
+                   ofstream file { YUV_FILE, ios::binary };
+
+                   for(int i = 0; i < NUM_FRAMES; ++i)
+                     writeOneYuvFrame(file, color, WIDTH, HEIGHT, frame.data(), stride, strideHeight);
+                 };
+    auto read = [&]() {
+                  ifstream file { YUV_FILE, ios::binary };
+
+                  while(readOneYuvFrame(file, color, WIDTH, HEIGHT, frame.data(), stride, strideHeight))
+                    ;
+                };
+
+    auto writeName = string { "yuv.write." } +format.name;
+    auto readName = string { "yuv.read." } +format.name;
+
+    if(!bench.IsSelected(writeName) && !bench.IsSelected(readName))
+      continue;
+
+    write();
+    bench.Run(writeName, params, 1, write);
+    bench.Run(readName, params, 1, read);
+  }
+
+  remove(YUV_FILE);
+}
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "bench.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static void Usage(char const* exe)
+{
+  cerr << "Usage: " << exe << " [-o results.json] [-f filter]" << endl;
+  cerr << "  -o  write the json results to a file instead of stdout" << endl;
+  cerr << "  -f  only run the benchmarks whose name contains filter" << endl;
+}
+
+int main(int argc, char** argv)
+{
+  string output {};
+  string filter {};
+
+  for(int i = 1; i < argc; ++i)
+  {
+    string arg { argv[i] };
+
+    if(arg == "-o" && i + 1 < argc)
+      output = argv[++i];
+    else if(arg == "-f" && i + 1 < argc)
+      filter = argv[++i];
+    else
+    {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  Bench bench { filter };
+
+  BenchUtility(bench);
+  BenchRoi(bench);
+  BenchTwoPass(bench);
+  BenchYuv(bench);
+  BenchStream(bench);
+  BenchSceneChange(bench);
+  BenchStaticFrame(bench);
+  BenchSharedDevice(bench);
+  BenchWarmPool(bench);
+  BenchLoad(bench);
+  BenchReconfigure(bench);
+  BenchDensity(bench);
+  BenchThreadScheduling(bench);
+
+  for(auto const& failure : bench.GetFailures())
+    cerr << "Check failed: " << failure << endl;
+
+  auto status = bench.GetFailures().empty() ? 0 : 1;
+
+  if(output.empty())
+  {
+    bench.Dump(cout);
+    return status;
+  }
+
+  ofstream file { output };
+
+  if(!file.is_open())
+  {
+    cerr << "Can't open " << output << endl;
+    return 1;
+  }
+
+  bench.Dump(file);
+  return status;
+}
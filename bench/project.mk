@@ -0,0 +1,68 @@
+THIS.bench:=$(call get-my-dir)
+
+EXE_NAME_BENCH:=omx_bench.exe
+SH_NAME_BENCH:=$(EXE_NAME_BENCH:%.exe=%.sh)
+
+BENCH_SRCS:=\
+	$(THIS.bench)/main.cpp\
+	$(THIS.bench)/bench_component.cpp\
+	$(THIS.bench)/bench_utility.cpp\
+	$(THIS.bench)/bench_roi.cpp\
+	$(THIS.bench)/bench_two_pass.cpp\
+	$(THIS.bench)/bench_yuv.cpp\
+	$(THIS.bench)/bench_stream.cpp\
+	$(THIS.bench)/bench_scene_change.cpp\
+	$(THIS.bench)/bench_static_frame.cpp\
+	$(THIS.bench)/bench_shared_device.cpp\
+	$(THIS.bench)/bench_warm_pool.cpp\
+	$(THIS.bench)/bench_load.cpp\
+	$(THIS.bench)/bench_reconfigure.cpp\
+	$(THIS.bench)/bench_density.cpp\
+	$(THIS.bench)/bench_thread_scheduling.cpp\
+	$(THIS)/module/ROIMngr.cpp\
+	$(THIS)/module/TwoPassMngr.cpp\
+	$(THIS)/module/two_pass_log.cpp\
+	$(THIS)/module/scene_change_analyzer.cpp\
+	$(THIS)/module/static_frame_detector.cpp\
+	$(THIS)/module/stream_sections.cpp\
+	$(THIS)/module/memory_interface.cpp\
+	$(THIS)/module/cpp_memory.cpp\
+	$(THIS)/module/module_interface.cpp\
+	$(THIS)/module/buffer_handle_interface.cpp\
+	$(THIS)/exe_omx/common/YuvReadWrite.cpp\
+
+BENCH_OBJ:=$(BENCH_SRCS:%=$(BIN)/%.o)
+BENCH_OBJ+=$(UTILITY_SRCS:%=$(BIN)/%.o)
+
+BENCH_CFLAGS:=$(DEFAULT_CFLAGS)
+BENCH_CFLAGS+=-pthread
+
+BENCH_LDFLAGS:=$(DEFAULT_LDFLAGS)
+BENCH_LDFLAGS+=-lpthread
+BENCH_LDFLAGS+=-L$(BIN)
+BENCH_LDFLAGS+=-l$(LIB_OMX_CORE_NAME:lib%.so=%)
+ifdef EXTERNAL_LIB
+BENCH_LDFLAGS+=-L$(EXTERNAL_LIB)
+endif
+BENCH_LDFLAGS+=-l$(EXTERNAL_ENCODE_LIB_NAME:lib%.so=%)
+
+# The components are timed through the core, which loads them from OMX_ALLEGRO_PATH
+$(BIN)/$(EXE_NAME_BENCH): $(LIB_OMX_CORE)
+$(BIN)/$(EXE_NAME_BENCH): $(LIB_OMX_ENC)
+$(BIN)/$(EXE_NAME_BENCH): $(LIBS_ENCODE)
+$(BIN)/$(EXE_NAME_BENCH): $(BENCH_OBJ)
+$(BIN)/$(EXE_NAME_BENCH): CFLAGS:=$(BENCH_CFLAGS)
+$(BIN)/$(EXE_NAME_BENCH): LDFLAGS:=$(BENCH_LDFLAGS)
+
+$(BIN)/$(SH_NAME_BENCH): $(BIN)/$(EXE_NAME_BENCH)
+	@echo "Generate script to launch $^"
+	$(shell echo 'BIN_PATH=$$(dirname $$(realpath "$$0"))' > $@)
+	$(shell echo 'export OMX_ALLEGRO_PATH="$$BIN_PATH"' >> $@)
+	$(shell echo 'export LD_LIBRARY_PATH="$$BIN_PATH:$(EXTERNAL_LIB)"' >> $@)
+	$(shell echo '"$$BIN_PATH/$(EXE_NAME_BENCH)" "$$@"' >> $@)
+	$(shell chmod a+x $@)
+
+# Not part of the default targets: make bench && $(BIN)/omx_bench.sh -o results.json
+bench: $(BIN)/$(EXE_NAME_BENCH) $(BIN)/$(SH_NAME_BENCH)
+
+.PHONY: bench
@@ -11,6 +11,9 @@
 #include <utility/omx_translate.h>
 
 #include "omx_core.h"
+#include "omx_core_statistics.h"
+#include "omx_core_load.h"
+#include "omx_core_pool.h"
 #include <OMX_Component.h>
 #include <stdexcept>
 
@@ -33,6 +36,60 @@ static omx_comp_type const* getComp(char* cComponentName)
   return nullptr;
 }
 
+static OMX_HANDLETYPE CreateComponent(const omx_comp_type* pComponent, char const* cFunctionName, OMX_PTR pAppData, OMX_CALLBACKTYPE* pCallBacks, OMX_ALG_COREINDEXTYPE nCoreParamIndex, OMX_PTR pSettings)
+{
+  dlerror();
+
+  using CreateComponentFuncPtr = add_pointer<OMX_ERRORTYPE(OMX_IN OMX_HANDLETYPE, OMX_IN OMX_STRING, OMX_IN OMX_STRING, OMX_IN OMX_PTR, OMX_IN OMX_CALLBACKTYPE*, OMX_IN OMX_ALG_COREINDEXTYPE, OMX_IN OMX_PTR)>::type;
+  auto createFunction = reinterpret_cast<CreateComponentFuncPtr>(reinterpret_cast<uintptr_t>(::dlsym(pComponent->pLibHandle, cFunctionName)));
+  auto pErr = dlerror();
+
+  if(pErr)
+  {
+    LOG_ERROR(pErr);
+    return nullptr;
+  }
+
+  auto pMyComponent = new OMX_COMPONENTTYPE;
+  auto eRet = createFunction(pMyComponent, (OMX_STRING)pComponent->name, (OMX_STRING)pComponent->role, pAppData, pCallBacks, nCoreParamIndex, pSettings);
+
+  if(eRet != OMX_ErrorNone)
+  {
+    delete pMyComponent;
+    return nullptr;
+  }
+
+  return pMyComponent;
+}
+
+static void DestroyComponent(OMX_HANDLETYPE handle)
+{
+  auto pMyComponent = static_cast<OMX_COMPONENTTYPE*>(handle);
+  pMyComponent->ComponentDeInit(handle);
+  delete pMyComponent;
+}
+
+/* The warm components have no application until they are taken */
+static OMX_CALLBACKTYPE WARM_CALLBACKS {};
+
+static OMX_HANDLETYPE CreateWarmComponent(string const& name)
+{
+  auto pComponent = getComp(const_cast<char*>(name.c_str()));
+
+  if(!pComponent || !pComponent->pLibHandle)
+    return nullptr;
+
+  try
+  {
+    return CreateComponent(pComponent, "CreateComponent", nullptr, &WARM_CALLBACKS, OMX_ALG_CoreIndexUnused, nullptr);
+  }
+  catch(runtime_error const& e)
+  {
+    LOG_ERROR(e.what());
+    return nullptr;
+  }
+}
+
 OMX_ERRORTYPE OMX_APIENTRY OMX_Init(void)
 {
   LOG_IMPORTANT();
@@ -66,12 +123,20 @@ OMX_ERRORTYPE OMX_APIENTRY OMX_Init(void)
     return OMX_ErrorUndefined;
   }
 
+  if(getenv("OMX_ALLEGRO_STATS_SOCKET"))
+    StartStatisticsServer(getenv("OMX_ALLEGRO_STATS_SOCKET"));
+
+  if(getenv("OMX_ALLEGRO_WARM_POOL"))
+    StartWarmPools(getenv("OMX_ALLEGRO_WARM_POOL"), CreateWarmComponent, DestroyComponent);
+
   return OMX_ErrorNone;
 }
 
 OMX_ERRORTYPE OMX_APIENTRY OMX_Deinit(void)
 {
   LOG_IMPORTANT();
+  StopStatisticsServer();
+  StopWarmPools();
 
   for(int i = 0; i < NB_OF_COMP; i++)
   {
@@ -100,30 +165,21 @@ OMX_ERRORTYPE OMX_APIENTRY OMX_ComponentNameEnum(OMX_OUT OMX_STRING cComponentNa
   return OMX_ErrorNone;
 }
 
-static OMX_HANDLETYPE CreateComponent(const omx_comp_type* pComponent, char const* cFunctionName, OMX_PTR pAppData, OMX_CALLBACKTYPE* pCallBacks, OMX_ALG_COREINDEXTYPE nCoreParamIndex, OMX_PTR pSettings)
+/* Same defaults as the wrappers, so a channel is accounted on the device it really uses */
+static string GetDeviceName(omx_comp_type const* pComponent, OMX_ALG_COREINDEXTYPE nCoreParamIndex, OMX_PTR pSettings)
 {
-  dlerror();
-
-  using CreateComponentFuncPtr = add_pointer<OMX_ERRORTYPE(OMX_IN OMX_HANDLETYPE, OMX_IN OMX_STRING, OMX_IN OMX_STRING, OMX_IN OMX_PTR, OMX_IN OMX_CALLBACKTYPE*, OMX_IN OMX_ALG_COREINDEXTYPE, OMX_IN OMX_PTR)>::type;
-  auto createFunction = reinterpret_cast<CreateComponentFuncPtr>(reinterpret_cast<uintptr_t>(::dlsym(pComponent->pLibHandle, cFunctionName)));
-  auto pErr = dlerror();
+  if(nCoreParamIndex == OMX_ALG_CoreIndexDevice && pSettings)
+    return static_cast<OMX_ALG_CORE_DEVICE*>(pSettings)->cDevice;
 
-  if(pErr)
-  {
-    LOG_ERROR(pErr);
-    return nullptr;
-  }
+  if(strstr(pComponent->name, ".mock."))
+    return "mock";
 
-  auto pMyComponent = new OMX_COMPONENTTYPE;
-  auto eRet = createFunction(pMyComponent, (OMX_STRING)pComponent->name, (OMX_STRING)pComponent->role, pAppData, pCallBacks, nCoreParamIndex, pSettings);
+  bool isEncoder = strstr(pComponent->role, "encoder");
+  char const* env = isEncoder ? "ALLEGRO_RISCV_ENC_DEVICE_PATH" : "ALLEGRO_RISCV_DEC_DEVICE_PATH";
 
-  if(eRet != OMX_ErrorNone)
-  {
-    delete pMyComponent;
-    return nullptr;
-  }
-
-  return pMyComponent;
+  if(getenv(env))
+    return getenv(env);
+  return isEncoder ? "/dev/al_e2xx" : "/dev/al_d3xx";
 }
 
 OMX_ERRORTYPE OMX_APIENTRY OMX_GetHandle(OMX_OUT OMX_HANDLETYPE* pHandle, OMX_IN OMX_STRING cComponentName, OMX_IN OMX_PTR pAppData, OMX_IN OMX_CALLBACKTYPE* pCallBacks)
@@ -149,9 +205,16 @@ OMX_ERRORTYPE OMX_APIENTRY OMX_ALG_GetHandle(OMX_OUT OMX_HANDLETYPE* pHandle, OM
   if(!pComponent)
     return OMX_ErrorComponentNotFound;
 
+  *pHandle = nullptr;
+
+  // The warm components are on the default device
+  if(nCoreParamIndex == OMX_ALG_CoreIndexUnused)
+    *pHandle = TakeWarmComponent(pComponent->name, pAppData, pCallBacks);
+
   try
   {
-    *pHandle = CreateComponent(pComponent, "CreateComponent", pAppData, pCallBacks, nCoreParamIndex, pSettings);
+    if(!*pHandle)
+      *pHandle = CreateComponent(pComponent, "CreateComponent", pAppData, pCallBacks, nCoreParamIndex, pSettings);
   }
   catch(runtime_error const& e)
   {
@@ -159,13 +222,20 @@ OMX_ERRORTYPE OMX_APIENTRY OMX_ALG_GetHandle(OMX_OUT OMX_HANDLETYPE* pHandle, OM
     return OMX_ErrorUndefined;
   }
 
-  return *pHandle ? OMX_ErrorNone : OMX_ErrorUndefined;
+  if(!*pHandle)
+    return OMX_ErrorUndefined;
+
+  RegisterComponent(*pHandle, pComponent->name);
+  EnableAdmissionControl(*pHandle, pComponent->name, GetDeviceName(pComponent, nCoreParamIndex, pSettings), pAppData, pCallBacks);
+  return OMX_ErrorNone;
 }
 
 OMX_ERRORTYPE OMX_APIENTRY OMX_FreeHandle(OMX_IN OMX_HANDLETYPE hComponent)
 {
   LOG_IMPORTANT(string { "hComponent: " } +ToStringAddr(hComponent));
   auto pMyComponent = static_cast<OMX_COMPONENTTYPE*>(hComponent);
+  UnregisterComponent(hComponent);
+  DisableAdmissionControl(hComponent);
   auto eRet = pMyComponent->ComponentDeInit(hComponent);
 
   delete pMyComponent;
@@ -173,6 +243,21 @@ OMX_ERRORTYPE OMX_APIENTRY OMX_FreeHandle(OMX_IN OMX_HANDLETYPE hComponent)
   return eRet;
 }
 
+OMX_ERRORTYPE OMX_APIENTRY OMX_ALG_GetDeviceLoad(OMX_INOUT OMX_ALG_CORE_DEVICE_LOAD* pLoad)
+{
+  LOG_IMPORTANT(string { "pLoad: " } +ToStringAddr(pLoad));
+
+  if(!pLoad || !pLoad->cDevice)
+    return OMX_ErrorBadParameter;
+
+  auto& tracker = GetDeviceLoadTracker();
+  pLoad->nCapacity = tracker.GetCapacity(pLoad->cDevice);
+  pLoad->nLoad = tracker.GetLoad(pLoad->cDevice);
+  pLoad->nRemaining = tracker.GetRemaining(pLoad->cDevice);
+  pLoad->nChannels = tracker.GetChannels(pLoad->cDevice);
+  return OMX_ErrorNone;
+}
+
 OMX_ERRORTYPE OMX_GetComponentsOfRole(OMX_IN OMX_STRING role, OMX_INOUT OMX_U32* pNumComps, OMX_INOUT OMX_U8** compNames)
 {
   LOG_IMPORTANT(string { "role: " } +role + string { ", pNumComps: " } +ToStringAddr(pNumComps) + string { ", compNames: " } +ToStringAddr(compNames));
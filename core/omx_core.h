@@ -28,6 +28,12 @@ static omx_comp_type AL_COMP_LIST[] =
     "libOMX.allegro.video_encoder.so",
     "video_encoder.hevc",
   },
+  {
+    "OMX.allegro.h265.mock.encoder",
+    nullptr,
+    "libOMX.allegro.video_encoder.so",
+    "video_encoder.hevc",
+  },
 
   {
     "OMX.allegro.h264.encoder",
@@ -41,6 +47,12 @@ static omx_comp_type AL_COMP_LIST[] =
     "libOMX.allegro.video_encoder.so",
     "video_encoder.avc",
   },
+  {
+    "OMX.allegro.h264.mock.encoder",
+    nullptr,
+    "libOMX.allegro.video_encoder.so",
+    "video_encoder.avc",
+  },
 
   {
     "OMX.allegro.h265.decoder",
@@ -54,6 +66,12 @@ static omx_comp_type AL_COMP_LIST[] =
     "libOMX.allegro.video_decoder.so",
     "video_decoder.hevc",
   },
+  {
+    "OMX.allegro.h265.mock.decoder",
+    nullptr,
+    "libOMX.allegro.video_decoder.so",
+    "video_decoder.hevc",
+  },
 
   {
     "OMX.allegro.h264.decoder",
@@ -67,6 +85,12 @@ static omx_comp_type AL_COMP_LIST[] =
     "libOMX.allegro.video_decoder.so",
     "video_decoder.avc",
   },
+  {
+    "OMX.allegro.h264.mock.decoder",
+    nullptr,
+    "libOMX.allegro.video_decoder.so",
+    "video_decoder.avc",
+  },
 
   {
     "OMX.allegro.mjpeg.decoder",
@@ -0,0 +1,415 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "omx_core_load.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+
+#include <OMX_Component.h>
+#include <OMX_CoreAlg.h>
+#include <OMX_VideoAlg.h>
+#include <utility/logger.h>
+
+using namespace std;
+
+DeviceLoadTracker::DeviceLoadTracker(uint64_t capacity) : defaultCapacity{capacity}
+{
+}
+
+void DeviceLoadTracker::SetCapacity(string const& device, uint64_t capacity)
+{
+  lock_guard<mutex> lock(reservationsMutex);
+  capacities[device] = capacity;
+}
+
+uint64_t DeviceLoadTracker::FindCapacity(string const& device) const
+{
+  auto capacity = capacities.find(device);
+  return capacity != capacities.end() ? capacity->second : defaultCapacity;
+}
+
+bool DeviceLoadTracker::Reserve(void const* channel, string const& device, uint64_t load)
+{
+  lock_guard<mutex> lock(reservationsMutex);
+  auto previous = reservations.find(channel);
+  auto deviceLoad = loads[device];
+  auto capacity = FindCapacity(device);
+
+  if(previous != reservations.end() && previous->second.device == device)
+    deviceLoad -= previous->second.load;
+
+  if(load > capacity - min(deviceLoad, capacity))
+    return false;
+
+  if(previous != reservations.end())
+    loads[previous->second.device] -= previous->second.load;
+
+  reservations[channel] = Reservation { device, load };
+  loads[device] += load;
+  return true;
+}
+
+void DeviceLoadTracker::Release(void const* channel)
+{
+  lock_guard<mutex> lock(reservationsMutex);
+  auto reservation = reservations.find(channel);
+
+  if(reservation == reservations.end())
+    return;
+
+  loads[reservation->second.device] -= reservation->second.load;
+  reservations.erase(reservation);
+}
+
+uint64_t DeviceLoadTracker::GetCapacity(string const& device) const
+{
+  lock_guard<mutex> lock(reservationsMutex);
+  return FindCapacity(device);
+}
+
+uint64_t DeviceLoadTracker::GetLoad(string const& device) const
+{
+  lock_guard<mutex> lock(reservationsMutex);
+  auto load = loads.find(device);
+  return load != loads.end() ? load->second : 0;
+}
+
+uint64_t DeviceLoadTracker::GetRemaining(string const& device) const
+{
+  auto capacity = GetCapacity(device);
+  return capacity - min(GetLoad(device), capacity);
+}
+
+int DeviceLoadTracker::GetChannels(string const& device) const
+{
+  lock_guard<mutex> lock(reservationsMutex);
+  return count_if(reservations.begin(), reservations.end(), [&](pair<void const* const, Reservation> const& reservation) {
+    return reservation.second.device == device;
+  });
+}
+
+uint64_t ComputeChannelLoad(int width, int height, double framerate, int weight)
+{
+  auto pixels = static_cast<uint64_t>(max(width, 0)) * static_cast<uint64_t>(max(height, 0));
+  return static_cast<uint64_t>(pixels * max(framerate, 0.0) * max(weight, 0) / 100);
+}
+
+static uint64_t ParseCapacity(string const& text)
+{
+  auto capacity = strtoull(text.c_str(), nullptr, 10);
+  return capacity ? capacity : DeviceLoadTracker::UNLIMITED;
+}
+
+/* "capacity" or "device=capacity,...,capacity" */
+static map<string, uint64_t> GetCapacitiesFromEnvironment()
+{
+  map<string, uint64_t> capacities;
+  char* envValue = getenv("OMX_ALLEGRO_DEVICE_CAPACITY");
+
+  if(envValue == nullptr)
+    return capacities;
+
+  stringstream ss { envValue };
+  string entry;
+
+  while(getline(ss, entry, ','))
+  {
+    auto separator = entry.rfind('=');
+
+    if(separator == string::npos)
+      capacities[""] = ParseCapacity(entry);
+    else
+      capacities[entry.substr(0, separator)] = ParseCapacity(entry.substr(separator + 1));
+  }
+
+  return capacities;
+}
+
+static DeviceLoadTracker* CreateDeviceLoadTracker()
+{
+  auto capacities = GetCapacitiesFromEnvironment();
+  auto defaultCapacity = capacities.find("");
+  auto tracker = new DeviceLoadTracker { defaultCapacity != capacities.end() ? defaultCapacity->second : DeviceLoadTracker::UNLIMITED };
+
+  for(auto const& capacity : capacities)
+  {
+    if(!capacity.first.empty())
+      tracker->SetCapacity(capacity.first, capacity.second);
+  }
+
+  return tracker;
+}
+
+DeviceLoadTracker& GetDeviceLoadTracker()
+{
+  static unique_ptr<DeviceLoadTracker> tracker { CreateDeviceLoadTracker() };
+  return *tracker;
+}
+
+// Decoders only know the framerate of the stream once it is parsed
+static double constexpr DEFAULT_FRAMERATE = 60.0;
+/* Relative cost of a pixel per codec and profile. The bit depth and the chroma format aren't in
+ * there as the buffer size of the raw port already accounts for them */
+// Jpeg has neither inter prediction nor loop filters
+static int constexpr JPEG_WEIGHT = 50;
+static int constexpr AVC_WEIGHT = 100;
+// Larger blocks to search and the sample adaptive offset filter on top of the deblocking
+static int constexpr HEVC_WEIGHT = 130;
+static int constexpr VIDEO_WEIGHT = 100;
+// In percent of the codec weight: no motion estimation nor compensation
+static int constexpr INTRA_PROFILE_WEIGHT = 70;
+// In percent of the codec weight: no B frames nor cabac
+static int constexpr BASELINE_PROFILE_WEIGHT = 90;
+
+static bool IsIntraProfile(OMX_U32 coding, OMX_U32 profile)
+{
+  // The intra only profiles follow each other in the extensions
+  if(coding == OMX_VIDEO_CodingAVC)
+    return profile >= OMX_ALG_VIDEO_AVCProfileHigh10_Intra && profile <= OMX_ALG_VIDEO_XAVCProfileHigh422_Intra_VBR;
+
+  if(coding == static_cast<OMX_U32>(OMX_ALG_VIDEO_CodingHEVC))
+    return profile == OMX_ALG_VIDEO_HEVCProfileMainStill || (profile >= OMX_ALG_VIDEO_HEVCProfileMain_Intra && profile <= OMX_ALG_VIDEO_HEVCProfileHighThroughPut444_16_Intra);
+
+  return false;
+}
+
+static bool IsBaselineProfile(OMX_U32 coding, OMX_U32 profile)
+{
+  return coding == OMX_VIDEO_CodingAVC && (profile == OMX_VIDEO_AVCProfileBaseline || profile == OMX_ALG_VIDEO_AVCProfileConstrainedBaseline);
+}
+
+static int GetCodecWeight(OMX_U32 coding, OMX_U32 profile)
+{
+  int weight = VIDEO_WEIGHT;
+
+  if(coding == OMX_VIDEO_CodingMJPEG)
+    return JPEG_WEIGHT;
+
+  if(coding == OMX_VIDEO_CodingAVC)
+    weight = AVC_WEIGHT;
+  else if(coding == static_cast<OMX_U32>(OMX_ALG_VIDEO_CodingHEVC))
+    weight = HEVC_WEIGHT;
+
+  if(IsIntraProfile(coding, profile))
+    return weight * INTRA_PROFILE_WEIGHT / 100;
+
+  if(IsBaselineProfile(coding, profile))
+    return weight * BASELINE_PROFILE_WEIGHT / 100;
+
+  return weight;
+}
+
+using SendCommandFuncPtr = OMX_ERRORTYPE (*)(OMX_HANDLETYPE, OMX_COMMANDTYPE, OMX_U32, OMX_PTR);
+
+using SetCallbacksFuncPtr = OMX_ERRORTYPE (*)(OMX_HANDLETYPE, OMX_CALLBACKTYPE*, OMX_PTR);
+
+struct Admission
+{
+  string name;
+  string device;
+  SendCommandFuncPtr sendCommand;
+  SetCallbacksFuncPtr setCallbacks;
+  OMX_CALLBACKTYPE callbacks; // of the application
+};
+
+static mutex admissionsMutex;
+static map<OMX_HANDLETYPE, Admission> admissions;
+
+template<typename T>
+static void InitHeader(T& header)
+{
+  memset(&header, 0, sizeof(T));
+  header.nSize = sizeof(header);
+  header.nVersion.s.nVersionMajor = OMX_VERSION_MAJOR;
+  header.nVersion.s.nVersionMinor = OMX_VERSION_MINOR;
+  header.nVersion.s.nRevision = OMX_VERSION_REVISION;
+  header.nVersion.s.nStep = OMX_VERSION_STEP;
+}
+
+/* The raw port gives the resolution, its buffer size the weight of the samples (bit depth, chroma),
+ * the compressed port the codec and its profile */
+static uint64_t ComputeLoad(OMX_HANDLETYPE handle)
+{
+  OMX_PORT_PARAM_TYPE ports;
+  InitHeader(ports);
+
+  if(OMX_GetParameter(handle, OMX_IndexParamVideoInit, &ports) != OMX_ErrorNone)
+    return 0;
+
+  int width = 0;
+  int height = 0;
+  double framerate = 0;
+  int sampleWeight = 100;
+  int codecWeight = VIDEO_WEIGHT;
+
+  for(auto port = ports.nStartPortNumber; port < ports.nStartPortNumber + ports.nPorts; ++port)
+  {
+    OMX_PARAM_PORTDEFINITIONTYPE definition;
+    InitHeader(definition);
+    definition.nPortIndex = port;
+
+    if(OMX_GetParameter(handle, OMX_IndexParamPortDefinition, &definition) != OMX_ErrorNone)
+      continue;
+
+    auto const& video = definition.format.video;
+
+    if(video.eCompressionFormat != OMX_VIDEO_CodingUnused)
+    {
+      if(framerate == 0)
+        framerate = video.xFramerate / 65536.0;
+
+      OMX_VIDEO_PARAM_PROFILELEVELTYPE profileLevel;
+      InitHeader(profileLevel);
+      profileLevel.nPortIndex = port;
+      auto profile = OMX_GetParameter(handle, OMX_IndexParamVideoProfileLevelCurrent, &profileLevel) == OMX_ErrorNone ? profileLevel.eProfile : 0;
+      codecWeight = GetCodecWeight(video.eCompressionFormat, profile);
+      continue;
+    }
+
+    width = video.nFrameWidth;
+    height = video.nFrameHeight;
+
+    if(video.xFramerate)
+      framerate = video.xFramerate / 65536.0;
+
+    auto pixels = static_cast<uint64_t>(width) * height;
+
+    if(pixels)
+      sampleWeight = max(100, static_cast<int>(definition.nBufferSize * 100ULL / (pixels * 3 / 2)));
+  }
+
+  if(framerate <= 0)
+    framerate = DEFAULT_FRAMERATE;
+
+  return ComputeChannelLoad(width, height, framerate, codecWeight * sampleWeight / 100);
+}
+
+static OMX_ERRORTYPE SendCommandWithAdmission(OMX_HANDLETYPE hComponent, OMX_COMMANDTYPE eCmd, OMX_U32 nParam, OMX_PTR pCmdData)
+{
+  Admission admission;
+  {
+    lock_guard<mutex> lock(admissionsMutex);
+    auto found = admissions.find(hComponent);
+
+    if(found == admissions.end())
+      return OMX_ErrorInvalidComponent;
+    admission = found->second;
+  }
+
+  if(eCmd != OMX_CommandStateSet)
+    return admission.sendCommand(hComponent, eCmd, nParam, pCmdData);
+
+  auto& tracker = GetDeviceLoadTracker();
+
+  OMX_STATETYPE state;
+
+  if(nParam != OMX_StateIdle || OMX_GetState(hComponent, &state) != OMX_ErrorNone || state != OMX_StateLoaded)
+    return admission.sendCommand(hComponent, eCmd, nParam, pCmdData);
+
+  auto load = ComputeLoad(hComponent);
+
+  if(!tracker.Reserve(hComponent, admission.device, load))
+  {
+    LOG_ERROR(admission.name + ": a load of " + to_string(load) + " doesn't fit on " + admission.device + ", " + to_string(tracker.GetRemaining(admission.device)) + " remaining");
+    return static_cast<OMX_ERRORTYPE>(OMX_ALG_ErrorChannelHardwareCapacityExceeded);
+  }
+
+  auto ret = admission.sendCommand(hComponent, eCmd, nParam, pCmdData);
+
+  if(ret != OMX_ErrorNone)
+    tracker.Release(hComponent);
+  return ret;
+}
+
+static bool FindApplicationCallbacks(OMX_HANDLETYPE hComponent, OMX_CALLBACKTYPE& callbacks)
+{
+  lock_guard<mutex> lock(admissionsMutex);
+  auto found = admissions.find(hComponent);
+
+  if(found == admissions.end())
+    return false;
+
+  callbacks = found->second.callbacks;
+  return true;
+}
+
+/* The channel is destroyed once the component reports it is back in loaded */
+static OMX_ERRORTYPE EventHandlerWithAdmission(OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2, OMX_PTR pEventData)
+{
+  if(eEvent == OMX_EventCmdComplete && nData1 == OMX_CommandStateSet && nData2 == OMX_StateLoaded)
+    GetDeviceLoadTracker().Release(hComponent);
+
+  OMX_CALLBACKTYPE callbacks;
+
+  if(!FindApplicationCallbacks(hComponent, callbacks) || !callbacks.EventHandler)
+    return OMX_ErrorNone;
+
+  return callbacks.EventHandler(hComponent, pAppData, eEvent, nData1, nData2, pEventData);
+}
+
+static OMX_ERRORTYPE SetCallbacksWithAdmission(OMX_HANDLETYPE hComponent, OMX_CALLBACKTYPE* pCallbacks, OMX_PTR pAppData)
+{
+  SetCallbacksFuncPtr setCallbacks;
+  {
+    lock_guard<mutex> lock(admissionsMutex);
+    auto found = admissions.find(hComponent);
+
+    if(found == admissions.end())
+      return OMX_ErrorInvalidComponent;
+    setCallbacks = found->second.setCallbacks;
+  }
+
+  if(!pCallbacks)
+    return setCallbacks(hComponent, pCallbacks, pAppData);
+
+  OMX_CALLBACKTYPE callbacks = *pCallbacks;
+  callbacks.EventHandler = EventHandlerWithAdmission;
+  auto ret = setCallbacks(hComponent, &callbacks, pAppData);
+
+  if(ret != OMX_ErrorNone)
+    return ret;
+
+  lock_guard<mutex> lock(admissionsMutex);
+  auto found = admissions.find(hComponent);
+
+  if(found != admissions.end())
+    found->second.callbacks = *pCallbacks;
+  return ret;
+}
+
+void EnableAdmissionControl(OMX_HANDLETYPE handle, char const* name, string const& device, OMX_PTR app, OMX_CALLBACKTYPE const* callbacks)
+{
+  auto component = static_cast<OMX_COMPONENTTYPE*>(handle);
+  OMX_CALLBACKTYPE application {};
+
+  if(callbacks)
+    application = *callbacks;
+  {
+    lock_guard<mutex> lock(admissionsMutex);
+    admissions[handle] = Admission { name, device, component->SendCommand, component->SetCallbacks, application };
+  }
+  component->SendCommand = SendCommandWithAdmission;
+  component->SetCallbacks = SetCallbacksWithAdmission;
+
+  if(SetCallbacksWithAdmission(handle, &application, app) != OMX_ErrorNone)
+    LOG_ERROR(string { name } +": the load will only be released when the component is freed");
+}
+
+void DisableAdmissionControl(OMX_HANDLETYPE handle)
+{
+  GetDeviceLoadTracker().Release(handle);
+  lock_guard<mutex> lock(admissionsMutex);
+  auto admission = admissions.find(handle);
+
+  if(admission == admissions.end())
+    return;
+
+  auto component = static_cast<OMX_COMPONENTTYPE*>(handle);
+  component->SendCommand = admission->second.sendCommand;
+  component->SetCallbacks = admission->second.setCallbacks;
+  admissions.erase(admission);
+}
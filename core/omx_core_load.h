@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <OMX_Core.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+/* Load of the channels on each device. A channel reserves its load before allocating anything
+ * and is refused when its device couldn't take it. The capacities are given by the caller so the
+ * accounting doesn't depend on the hardware */
+struct DeviceLoadTracker
+{
+  static uint64_t constexpr UNLIMITED = UINT64_MAX;
+
+  /* capacity is the one of the devices without their own */
+  explicit DeviceLoadTracker(uint64_t capacity);
+
+  void SetCapacity(std::string const& device, uint64_t capacity);
+
+  /* Replaces the reservation of the channel. Returns false, keeping the previous reservation,
+   * when the device would be overloaded */
+  bool Reserve(void const* channel, std::string const& device, uint64_t load);
+  void Release(void const* channel);
+
+  uint64_t GetCapacity(std::string const& device) const;
+  uint64_t GetLoad(std::string const& device) const;
+  uint64_t GetRemaining(std::string const& device) const;
+  int GetChannels(std::string const& device) const;
+
+private:
+  struct Reservation
+  {
+    std::string device;
+    uint64_t load;
+  };
+
+  uint64_t const defaultCapacity;
+  mutable std::mutex reservationsMutex;
+  std::map<std::string, uint64_t> capacities;
+  std::map<void const*, Reservation> reservations;
+  std::map<std::string, uint64_t> loads;
+
+  uint64_t FindCapacity(std::string const& device) const;
+};
+
+/* Pixel rate of the channel weighted by the cost of its codec and of its samples, in percent */
+uint64_t ComputeChannelLoad(int width, int height, double framerate, int weight);
+
+/* The tracker of the core. Its capacities come from OMX_ALLEGRO_DEVICE_CAPACITY, in weighted pixels
+ * per second: either a single capacity for all the devices or a list such as
+ * "/dev/al_e2xx=500000000,/dev/al_d3xx=1000000000" where an entry without a device applies to the
+ * devices not listed. A device without capacity is unlimited */
+DeviceLoadTracker& GetDeviceLoadTracker();
+
+/* Intercepts the state changes of the handle: OMX_SendCommand(OMX_StateIdle) from loaded fails with
+ * OMX_ALG_ErrorChannelHardwareCapacityExceeded when the channel doesn't fit on its device. The load
+ * is released once the component reports it is back in loaded, so the callbacks of the application
+ * are given here and go through the tracker */
+void EnableAdmissionControl(OMX_HANDLETYPE handle, char const* name, std::string const& device, OMX_PTR app, OMX_CALLBACKTYPE const* callbacks);
+void DisableAdmissionControl(OMX_HANDLETYPE handle);
@@ -0,0 +1,164 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "omx_core_pool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#include <OMX_Component.h>
+#include <OMX_ComponentAlg.h>
+#include <OMX_IndexAlg.h>
+#include <base/omx_checker/omx_checker.h>
+#include <utility/logger.h>
+#include <utility/warm_pool.h>
+
+using namespace std;
+
+static mutex poolsMutex;
+static map<string, unique_ptr<WarmPool<OMX_HANDLETYPE>>> pools;
+static function<void(OMX_HANDLETYPE)> destroyComponent;
+
+/* Settings of the raw port a pooled component is prepared with, none when width is 0 */
+struct WarmConfiguration
+{
+  int width;
+  int height;
+  int framerate;
+};
+
+/* "count" or "count:widthxheight@framerate", the framerate defaults to 60 */
+static bool ParseWarmEntry(string const& text, int& size, WarmConfiguration& configuration)
+{
+  configuration = WarmConfiguration { 0, 0, 60 };
+  auto separator = text.find(':');
+  size = text.empty() ? 1 : atoi(text.substr(0, separator).c_str());
+
+  if(separator == string::npos)
+    return size > 0;
+
+  char end;
+  auto parsed = sscanf(text.substr(separator + 1).c_str(), "%dx%d@%d%c", &configuration.width, &configuration.height, &configuration.framerate, &end);
+  return size > 0 && (parsed == 2 || parsed == 3) && configuration.width > 0 && configuration.height > 0 && configuration.framerate > 0;
+}
+
+/* The raw port takes the declared resolution and framerate, then the component creates its channel
+ * and the buffers of its ports. A component which can't prepare a channel keeps the settings only */
+static bool PrepareWarmComponent(OMX_HANDLETYPE handle, string const& name, WarmConfiguration const& configuration)
+{
+  OMX_PORT_PARAM_TYPE ports;
+  OMXChecker::SetHeaderVersion(ports);
+
+  if(OMX_GetParameter(handle, OMX_IndexParamVideoInit, &ports) != OMX_ErrorNone)
+    return false;
+
+  for(auto port = ports.nStartPortNumber; port < ports.nStartPortNumber + ports.nPorts; ++port)
+  {
+    OMX_PARAM_PORTDEFINITIONTYPE definition;
+    OMXChecker::SetHeaderVersion(definition);
+    definition.nPortIndex = port;
+
+    if(OMX_GetParameter(handle, OMX_IndexParamPortDefinition, &definition) != OMX_ErrorNone)
+      return false;
+
+    auto& video = definition.format.video;
+
+    if(video.eCompressionFormat != OMX_VIDEO_CodingUnused)
+      continue;
+
+    video.nFrameWidth = configuration.width;
+    video.nFrameHeight = configuration.height;
+    // The smallest ones for the resolution
+    video.nStride = 0;
+    video.nSliceHeight = 0;
+    video.xFramerate = configuration.framerate << 16;
+
+    if(OMX_SetParameter(handle, OMX_IndexParamPortDefinition, &definition) != OMX_ErrorNone)
+      return false;
+  }
+
+  OMX_ALG_PARAM_PREPARE_CHANNEL prepare;
+  OMXChecker::SetHeaderVersion(prepare);
+  prepare.bPrepare = OMX_TRUE;
+  auto ret = OMX_SetParameter(handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamPrepareChannel), &prepare);
+
+  if(ret == OMX_ErrorUnsupportedIndex)
+    LOG_WARNING(name + ": no channel prepared ahead, only the settings are");
+
+  return ret == OMX_ErrorNone || ret == OMX_ErrorUnsupportedIndex;
+}
+
+void StartWarmPools(string const& config, function<OMX_HANDLETYPE(string const& name)> create, function<void(OMX_HANDLETYPE)> destroy)
+{
+  lock_guard<mutex> lock(poolsMutex);
+  destroyComponent = destroy;
+  stringstream entries { config };
+  string entry;
+
+  while(getline(entries, entry, ','))
+  {
+    auto separator = entry.find('=');
+    auto name = entry.substr(0, separator);
+    int size;
+    WarmConfiguration configuration;
+
+    if(name.empty() || !ParseWarmEntry(separator != string::npos ? entry.substr(separator + 1) : "", size, configuration) || pools.count(name))
+    {
+      LOG_ERROR(string { "Ignored warm pool entry: " } +entry);
+      continue;
+    }
+
+    auto createHandle = [=](OMX_HANDLETYPE& handle) {
+      handle = create(name);
+
+      if(!handle || !configuration.width || PrepareWarmComponent(handle, name, configuration))
+        return handle != nullptr;
+
+      LOG_ERROR(name + ": couldn't prepare a warm component for " + to_string(configuration.width) + "x" + to_string(configuration.height));
+      destroy(handle);
+      handle = nullptr;
+      return false;
+    };
+    pools[name].reset(new WarmPool<OMX_HANDLETYPE> { size, createHandle, destroy });
+    LOG_IMPORTANT(name + ": " + to_string(size) + " component(s) kept warm");
+  }
+}
+
+void StopWarmPools()
+{
+  map<string, unique_ptr<WarmPool<OMX_HANDLETYPE>>> stopped;
+  {
+    lock_guard<mutex> lock(poolsMutex);
+    stopped.swap(pools);
+  }
+  // The fillers finish their creation outside of the lock, the takes meanwhile find no pool
+}
+
+OMX_HANDLETYPE TakeWarmComponent(char const* name, OMX_PTR pAppData, OMX_CALLBACKTYPE* pCallBacks)
+{
+  OMX_HANDLETYPE handle;
+  function<void(OMX_HANDLETYPE)> destroy;
+  {
+    lock_guard<mutex> lock(poolsMutex);
+    auto pool = pools.find(name);
+
+    if(pool == pools.end() || !pool->second->Take(handle))
+      return nullptr;
+    destroy = destroyComponent;
+  }
+
+  auto component = static_cast<OMX_COMPONENTTYPE*>(handle);
+  component->pApplicationPrivate = pAppData;
+
+  if(component->SetCallbacks(handle, pCallBacks, pAppData) != OMX_ErrorNone)
+  {
+    destroy(handle);
+    return nullptr;
+  }
+
+  return handle;
+}
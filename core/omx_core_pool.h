@@ -0,0 +1,22 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <OMX_Core.h>
+#include <functional>
+#include <string>
+
+/* Components created ahead of OMX_GetHandle, configured with a comma separated list of
+ * name=count[:widthxheight[@framerate]] such as "OMX.allegro.h264.riscv.encoder=2:1920x1080@60".
+ * A pooled component is in OMX_StateLoaded, taking it only binds the callbacks of the application.
+ * Without a declared resolution it has its default settings. With one, its raw port has that
+ * resolution and framerate and the encoders prepare their channel and the buffers of their ports
+ * (OMX_ALG_IndexParamPrepareChannel): the channel is kept when the application doesn't change the
+ * settings, the buffers are handed out by OMX_AllocateBuffer. The prepared channels aren't counted
+ * in the load of the devices until their transition to OMX_StateIdle */
+void StartWarmPools(std::string const& config, std::function<OMX_HANDLETYPE(std::string const& name)> create, std::function<void(OMX_HANDLETYPE)> destroy);
+void StopWarmPools();
+
+/* Returns nullptr when the component isn't pooled or none is ready */
+OMX_HANDLETYPE TakeWarmComponent(char const* name, OMX_PTR pAppData, OMX_CALLBACKTYPE* pCallBacks);
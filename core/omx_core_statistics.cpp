@@ -0,0 +1,218 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "omx_core_statistics.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <iomanip>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <OMX_Component.h>
+#include <OMX_ComponentAlg.h>
+#include <OMX_IndexAlg.h>
+#include <utility/logger.h>
+#include <utility/processor_fifo.h>
+
+using namespace std;
+
+struct LiveComponent
+{
+  string name;
+  chrono::steady_clock::time_point lastDump;
+  uint64_t lastOutputFrames;
+};
+
+static mutex registryMutex;
+static map<OMX_HANDLETYPE, LiveComponent> registry;
+
+void RegisterComponent(OMX_HANDLETYPE handle, char const* name)
+{
+  lock_guard<mutex> lock(registryMutex);
+  registry[handle] = LiveComponent { name, chrono::steady_clock::now(), 0 };
+}
+
+void UnregisterComponent(OMX_HANDLETYPE handle)
+{
+  lock_guard<mutex> lock(registryMutex);
+  registry.erase(handle);
+}
+
+template<typename T>
+static void InitHeader(T& header)
+{
+  memset(&header, 0, sizeof(T));
+  header.nSize = sizeof(header);
+  header.nVersion.s.nVersionMajor = OMX_VERSION_MAJOR;
+  header.nVersion.s.nVersionMinor = OMX_VERSION_MINOR;
+  header.nVersion.s.nRevision = OMX_VERSION_REVISION;
+  header.nVersion.s.nStep = OMX_VERSION_STEP;
+}
+
+static void DumpQueue(ostream& out, char const* name, OMX_ALG_QUEUE_STATISTICS const& queue)
+{
+  out << "  queue " << name << ": depth " << queue.nDepth << ", max depth " << queue.nMaxDepth
+      << ", enqueued " << queue.nEnqueued << ", processed " << queue.nProcessed
+      << ", average wait " << (queue.nProcessed ? queue.nWaitTime / queue.nProcessed : 0) << "us\n";
+}
+
+static void DumpComponent(ostream& out, OMX_HANDLETYPE handle, LiveComponent& live)
+{
+  out << live.name << " (" << handle << ")\n";
+
+  OMX_ALG_CONFIG_STATISTICS statistics;
+  InitHeader(statistics);
+
+  if(OMX_GetConfig(handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigStatistics), &statistics) != OMX_ErrorNone)
+  {
+    out << "  statistics unavailable\n";
+    return;
+  }
+
+  auto now = chrono::steady_clock::now();
+  auto elapsed = chrono::duration<double>(now - live.lastDump).count();
+  auto fps = elapsed > 0 ? (statistics.nOutputFrames - live.lastOutputFrames) / elapsed : 0;
+  live.lastDump = now;
+  live.lastOutputFrames = statistics.nOutputFrames;
+
+  out << "  frames in " << statistics.nInputFrames << ", frames out " << statistics.nOutputFrames
+      << ", fps " << fixed << setprecision(2) << fps
+      << ", average latency " << (statistics.nLatencyFrames ? statistics.nLatency / statistics.nLatencyFrames : 0) << "us"
+      << ", buffer memory " << statistics.nBufferMemory << " bytes\n";
+  DumpQueue(out, "commands", statistics.tCommands);
+  DumpQueue(out, "empty", statistics.tEmptyQueue);
+  DumpQueue(out, "fill", statistics.tFillQueue);
+
+  if(statistics.tLookAhead.nEnqueued)
+  {
+    DumpQueue(out, "lookahead", statistics.tLookAhead);
+    out << "  lookahead full " << statistics.nLookAheadBlocked << " times, " << statistics.nLookAheadBlockedTime << "us\n";
+  }
+
+  if(statistics.nLookAheadAllocations)
+    out << "  lookahead metadata allocated " << statistics.nLookAheadAllocations << " times\n";
+
+  if(statistics.nReconfigurations)
+    out << "  reconfigured " << statistics.nReconfigurations << " times, " << statistics.nReconfigInPlace << " in place, downtime "
+        << statistics.nReconfigDowntime << "us, " << statistics.nReconfigLostFrames << " frames\n";
+}
+
+string DumpComponentsStatistics()
+{
+  stringstream out;
+  lock_guard<mutex> lock(registryMutex);
+
+  out << registry.size() << " live component(s)\n";
+
+  for(auto& component : registry)
+    DumpComponent(out, component.first, component.second);
+
+  return out.str();
+}
+
+static int serverSocket = -1;
+static int stopPipe[2] = { -1, -1 };
+static thread server;
+static string serverPath;
+
+static void Serve()
+{
+  SetCurrentThreadName("OMX - Stats");
+
+  while(true)
+  {
+    pollfd fds[2] = {
+      { serverSocket, POLLIN, 0 }, { stopPipe[0], POLLIN, 0 }
+    };
+
+    if(poll(fds, 2, -1) < 0)
+      continue;
+
+    if(fds[1].revents)
+      return;
+
+    auto client = accept(serverSocket, nullptr, nullptr);
+
+    if(client < 0)
+      continue;
+
+    auto dump = DumpComponentsStatistics();
+    size_t written = 0;
+
+    while(written < dump.size())
+    {
+      auto ret = write(client, dump.data() + written, dump.size() - written);
+
+      if(ret <= 0)
+        break;
+      written += ret;
+    }
+
+    close(client);
+  }
+}
+
+void StartStatisticsServer(string const& path)
+{
+  if(path.empty() || serverSocket >= 0)
+    return;
+
+  sockaddr_un address {};
+
+  if(path.size() >= sizeof(address.sun_path))
+  {
+    LOG_ERROR(string { "Statistics socket path is too long: " } +path);
+    return;
+  }
+
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  unlink(path.c_str());
+
+  serverSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+  if(serverSocket < 0 || bind(serverSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(serverSocket, 4) < 0 || pipe(stopPipe) < 0)
+  {
+    LOG_ERROR(string { "Couldn't serve the statistics on " } +path + ": " + strerror(errno));
+
+    if(serverSocket >= 0)
+      close(serverSocket);
+    serverSocket = -1;
+    return;
+  }
+
+  serverPath = path;
+  server = thread { Serve };
+  LOG_IMPORTANT(string { "Statistics served on " } +path);
+}
+
+void StopStatisticsServer()
+{
+  if(serverSocket < 0)
+    return;
+
+  char stop = 0;
+
+  if(write(stopPipe[1], &stop, 1) == 1)
+    server.join();
+  else
+  {
+    LOG_ERROR("Couldn't stop the statistics server");
+    server.detach();
+  }
+
+  close(stopPipe[0]);
+  close(stopPipe[1]);
+  close(serverSocket);
+  unlink(serverPath.c_str());
+  serverSocket = -1;
+}
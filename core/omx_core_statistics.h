@@ -0,0 +1,18 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <OMX_Core.h>
+#include <string>
+
+/* Keeps track of the live handles so their statistics can be dumped on request */
+void RegisterComponent(OMX_HANDLETYPE handle, char const* name);
+void UnregisterComponent(OMX_HANDLETYPE handle);
+
+/* Plain text dump of the statistics of every live handle */
+std::string DumpComponentsStatistics();
+
+/* Serves the dump on a unix socket. Nothing runs when path is empty */
+void StartStatisticsServer(std::string const& path);
+void StopStatisticsServer();
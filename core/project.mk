@@ -6,6 +6,9 @@ LIB_OMX_CORE:=$(BIN)/$(LIB_OMX_CORE_NAME)
 
 OMX_CORE_SRCS:=\
                $(THIS.core)/omx_core.cpp\
+               $(THIS.core)/omx_core_statistics.cpp\
+               $(THIS.core)/omx_core_load.cpp\
+               $(THIS.core)/omx_core_pool.cpp\
 
 OMX_CORE_OBJ:=$(OMX_CORE_SRCS:%=$(BIN)/%.o)
 OMX_CORE_OBJ+=$(UTILITY_SRCS:%=$(BIN)/%.o)
@@ -315,6 +315,21 @@ static bool calcPlaneSize(struct plane* planes, OMX_COLOR_FORMATTYPE eColor, int
   return true;
 }
 
+int getYuvFrameSize(OMX_COLOR_FORMATTYPE eColor, int iWidth, int iHeight)
+{
+  struct plane planes[MAX_PLANES];
+
+  if(!calcPlaneSize(planes, eColor, iWidth, iHeight))
+    return 0;
+
+  int sz = 0;
+
+  for(int p = 0; p < MAX_PLANES; ++p)
+    sz += planes[p].line_count * planes[p].line_size;
+
+  return sz;
+}
+
 int writeOneYuvFrame(std::ofstream& ofstream, OMX_COLOR_FORMATTYPE eColor, int iWidth, int iHeight, char* pBuffer, int iBufferPlaneStride, int iBufferPlaneStrideHeight)
 {
   struct plane planes[MAX_PLANES];
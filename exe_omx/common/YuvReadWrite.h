@@ -8,4 +8,6 @@
 #include <omx_header/OMX_IVCommon.h>
 
 int readOneYuvFrame(std::ifstream& ifstream, OMX_COLOR_FORMATTYPE eColor, int width, int height, char* pBuffer, int iBufferPlaneStride, int iBufferPlaneStrideHeight);
+/* Size of a frame in a yuv file, 0 when the format is not supported */
+int getYuvFrameSize(OMX_COLOR_FORMATTYPE eColor, int width, int height);
 int writeOneYuvFrame(std::ofstream& ifstream, OMX_COLOR_FORMATTYPE eColor, int width, int height, char* pBuffer, int iBufferPlaneStride, int iBufferPlaneStrideHeight);
@@ -270,3 +270,26 @@ void CommandsSender::setHDRIndex(int iHDRIdx)
   assert(0 && "setHDRIndex is not supported");
 }
 
+int CommandsSender::getQPTableSize()
+{
+  OMX_ALG_VIDEO_CONFIG_DATA data;
+  InitHeader(data);
+  data.nPortIndex = 1;
+  auto const error = OMX_GetConfig(hEnc, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoQuantizationParameterTable), &data);
+  assert(error == OMX_ErrorNone);
+  return data.nAllocLen;
+}
+
+void CommandsSender::setQPTable(OMX_U8* table, int size)
+{
+  OMX_ALG_VIDEO_CONFIG_DATA data;
+  InitHeader(data);
+  data.nPortIndex = 1;
+  data.pBuffer = table;
+  data.nAllocLen = size;
+  data.nFilledLen = size;
+  data.nOffset = 0;
+  auto const error = OMX_SetConfig(hEnc, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoQuantizationParameterTable), &data);
+  assert(error == OMX_ErrorNone);
+}
+
@@ -48,6 +48,8 @@ struct CommandsSender final : public ICommandsSender
   void setAutoQP(bool bUseAutoQP) override;
   void setAutoQPThresholdQPAndDeltaQP(bool bEnableUserAutoQPValues, std::vector<int> thresholdQP, std::vector<int> deltaQP) override;
   void setHDRIndex(int iHDRIdx) override;
+  int getQPTableSize();
+  void setQPTable(OMX_U8* table, int size);
 
 private:
   OMX_HANDLETYPE hEnc;
@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "QPTableFile.h"
+
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+QPTableFile::QPTableFile(string const& path, size_t tableSize) :
+  data{nullptr},
+  size{0},
+  tableSize{tableSize}
+{
+  if(tableSize == 0)
+    throw runtime_error("QP table size must not be 0");
+
+  auto fd = open(path.c_str(), O_RDONLY);
+
+  if(fd < 0)
+    throw runtime_error("Couldn't open QP table file: " + path);
+
+  struct stat st;
+
+  if(fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < tableSize)
+  {
+    close(fd);
+    throw runtime_error("QP table file " + path + " doesn't contain a whole table of " + to_string(tableSize) + " bytes");
+  }
+
+  size = st.st_size;
+  auto addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if(addr == MAP_FAILED)
+    throw runtime_error("Couldn't map QP table file: " + path);
+
+  /* Tables are read once each, in order */
+  madvise(addr, size, MADV_SEQUENTIAL);
+  data = static_cast<uint8_t*>(addr);
+}
+
+QPTableFile::~QPTableFile()
+{
+  munmap(data, size);
+}
+
+uint8_t* QPTableFile::GetTable(int frame) const
+{
+  return data + (frame % GetNumTables()) * tableSize;
+}
+
+int QPTableFile::GetTableSize() const
+{
+  return static_cast<int>(tableSize);
+}
+
+int QPTableFile::GetNumTables() const
+{
+  return static_cast<int>(size / tableSize);
+}
@@ -0,0 +1,27 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* A file of consecutive per-frame QP tables, mapped once in memory.
+ * Frames past the last table loop back to the first one */
+struct QPTableFile
+{
+  QPTableFile(std::string const& path, size_t tableSize);
+  ~QPTableFile();
+  QPTableFile(QPTableFile const &) = delete;
+  QPTableFile & operator = (QPTableFile const &) = delete;
+
+  uint8_t* GetTable(int frame) const;
+  int GetTableSize() const;
+  int GetNumTables() const;
+
+private:
+  uint8_t* data;
+  size_t size;
+  size_t tableSize;
+};
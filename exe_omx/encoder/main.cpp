@@ -1,6 +1,7 @@
 // SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
 // SPDX-License-Identifier: MIT
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
@@ -11,6 +12,7 @@
 #include <iostream>
 #include <fstream>
 #include <atomic>
+#include <memory>
 #include <unistd.h>
 
 #if defined(ANDROID) || defined(__ANDROID_API__)
@@ -31,6 +33,7 @@
 
 #include "CommandsSender.h"
 #include "EncCmdMngr.h"
+#include "QPTableFile.h"
 
 #include <utility/logger.h>
 #include <utility/locked_queue.h>
@@ -44,6 +47,8 @@
 #include "../common/codec.h"
 #include "../common/YuvReadWrite.h"
 
+#include <module/two_pass_log.h>
+
 extern "C"
 {
 #include <lib_fpga/DmaAlloc.h>
@@ -82,6 +87,8 @@ struct Settings
   int lookahead;
   int pass;
   string twoPassLogFile;
+  int twoPassChunks;
+  int twoPassChunk;
   bool isDummySeiEnabled;
   string deviceName = string("/dev/allegroIP");
 
@@ -89,6 +96,8 @@ struct Settings
   int targetBitrate;
   bool isVideoFullRangeEnabled;
   int maxFrames = DEFAULT_MAX_FRAMES;
+  string qpTableFile;
+  bool isQPTableAbsolute;
 };
 
 struct Application
@@ -112,6 +121,7 @@ struct Application
 
   CEncCmdMngr* encCmd;
   CommandsSender* cmdSender;
+  QPTableFile* qpTables;
 };
 
 static inline void SetDefaultSettings(Settings& settings)
@@ -124,10 +134,13 @@ static inline void SetDefaultSettings(Settings& settings)
   settings.lookahead = 0;
   settings.pass = 0;
   settings.twoPassLogFile = "";
+  settings.twoPassChunks = 0;
+  settings.twoPassChunk = 0;
   settings.isDummySeiEnabled = false;
   settings.targetBitrate = 64000;
   settings.eControlRate = OMX_Video_ControlRateConstant;
   settings.isVideoFullRangeEnabled = false;
+  settings.isQPTableAbsolute = false;
 }
 
 static inline void SetDefaultApplication(Application& app)
@@ -143,6 +156,7 @@ static inline void SetDefaultApplication(Application& app)
   app.output.isFlushing = false;
   app.output.isEOS = false;
   app.read = false;
+  app.qpTables = nullptr;
 }
 
 static string input_file;
@@ -321,6 +335,15 @@ static OMX_ERRORTYPE setPortParameters(Application& app)
 
   setEnableLongTerm(app);
 
+  if(!app.settings.qpTableFile.empty())
+  {
+    OMX_ALG_VIDEO_PARAM_QUANTIZATION_TABLE table;
+    InitHeader(table);
+    table.nPortIndex = 1;
+    table.eQpTableMode = app.settings.isQPTableAbsolute ? OMX_ALG_QP_TABLE_ABSOLUTE : OMX_ALG_QP_TABLE_RELATIVE;
+    OMX_CALL(OMX_SetParameter(app.hEncoder, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamVideoQuantizationTable), &table));
+  }
+
   OMX_PARAM_PORTDEFINITIONTYPE paramPortForActual;
   InitHeader(paramPortForActual);
   paramPortForActual.nPortIndex = 0;
@@ -337,6 +360,52 @@ static OMX_ERRORTYPE setPortParameters(Application& app)
   return OMX_ErrorNone;
 }
 
+/* The runs of the first pass encode a chunk each into its own logfile, in parallel on as many channels.
+ * The second pass, given the same input and settings, finds the same chunks and merges their logfiles.
+ * The first frames of a chunk are not predicted from the same references as in a single first pass run,
+ * their records are close to but not the same as the ones of that run */
+static OMX_ERRORTYPE setTwoPassChunk(Application& app)
+{
+  auto& settings = app.settings;
+
+  OMX_ALG_VIDEO_CONFIG_GROUP_OF_PICTURES gop;
+  InitHeader(gop);
+  gop.nPortIndex = 1;
+  OMX_CALL(OMX_GetConfig(app.hEncoder, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoGroupOfPictures), &gop));
+  int gopLength = gop.nPFrames + gop.nBFrames + 1;
+
+  auto frameSize = getYuvFrameSize(settings.format, settings.width, settings.height);
+
+  if(frameSize == 0)
+    return OMX_ErrorUnsupportedSetting;
+
+  infile.seekg(0, ios::end);
+  auto numFrames = static_cast<int>(static_cast<int64_t>(infile.tellg()) / frameSize);
+  infile.seekg(0);
+
+  if(settings.maxFrames)
+    numFrames = min(numFrames, settings.maxFrames);
+
+  auto chunks = SplitTwoPassIntoChunks(numFrames, settings.twoPassChunks, gopLength);
+
+  if(settings.pass == 2)
+  {
+    MergeTwoPassChunkLogs(settings.twoPassLogFile, chunks);
+    LOG_IMPORTANT(string { "Merged " } +to_string(chunks.size()) + string { " chunk logfiles into " } +settings.twoPassLogFile);
+    return OMX_ErrorNone;
+  }
+
+  if(settings.twoPassChunk >= static_cast<int>(chunks.size()))
+    throw runtime_error("The input only has " + to_string(chunks.size()) + " chunks");
+
+  auto const& chunk = chunks[settings.twoPassChunk];
+  infile.seekg(static_cast<int64_t>(chunk.iFirstFrame - chunk.iNumWarmUpFrames) * frameSize);
+  settings.maxFrames = chunk.iNumWarmUpFrames + chunk.iNumFrames;
+  settings.twoPassLogFile = GetTwoPassChunkLogName(settings.twoPassLogFile, settings.twoPassChunk);
+  LOG_IMPORTANT(string { "Chunk " } +to_string(settings.twoPassChunk) + string { ": frames " } +to_string(chunk.iFirstFrame) + string { " to " } +to_string(chunk.iFirstFrame + chunk.iNumFrames - 1) + string { " into " } +settings.twoPassLogFile);
+  return OMX_ErrorNone;
+}
+
 static void Usage(CommandLineParser& opt, char* ExeName)
 {
   cerr << "Usage: " << ExeName << " <InputFile> [options]" << endl;
@@ -399,11 +468,15 @@ static void parseCommandLine(int argc, char** argv, Application& app)
   opt.addInt("--lookahead", &settings.lookahead, "<0 || above 2>: activate lookahead mode '(0)'");
   opt.addInt("--pass", &settings.pass, "<0 || 1 || 2>: specify which pass we encode'(0)'");
   opt.addString("--pass-logfile", &settings.twoPassLogFile, "LogFile to transmit dualpass statistics");
+  opt.addInt("--pass-chunks", &settings.twoPassChunks, "Split the first pass in gop aligned chunks, each encoded by its own run. The second pass merges their logfiles ('0')");
+  opt.addInt("--pass-chunk", &settings.twoPassChunk, "Chunk encoded by this first pass run, in [0, pass-chunks[ ('0')");
   opt.addFlag("--dummy-sei", &settings.isDummySeiEnabled, "Enable dummy seis on firsts frames");
   opt.addString("--rate-control-type", &controlRate, "Available rate control mode: CONST_QP, CBR, VBR and PLUGIN");
   opt.addInt("--target-bitrate", &settings.targetBitrate, "Targeted bitrate (Not applicable in CONST_QP)");
   opt.addFlag("--video-full-range", &settings.isVideoFullRangeEnabled, "Enable Video Full Range");
   opt.addUint("--max-frames", &settings.maxFrames, "Specify number or frames to encode (default: 0 -> continue until EOF)");
+  opt.addString("--qp-table-file", &settings.qpTableFile, "File of consecutive per-frame QP tables, looped over if shorter than the input");
+  opt.addFlag("--qp-table-absolute", &settings.isQPTableAbsolute, "QP tables hold absolute QPs instead of QP offsets");
 
   opt.parse(argc, argv);
 
@@ -430,6 +503,13 @@ static void parseCommandLine(int argc, char** argv, Application& app)
     exit(1);
   }
 
+  if(settings.twoPassChunks > 1 && (settings.pass == 0 || settings.twoPassLogFile.empty() || settings.twoPassChunk < 0 || settings.twoPassChunk >= settings.twoPassChunks))
+  {
+    Usage(opt, argv[0]);
+    cerr << "[Error] pass chunks need a pass, a logfile and a chunk below their number" << endl;
+    exit(1);
+  }
+
   if(input_file == "")
   {
     Usage(opt, argv[0]);
@@ -554,6 +634,10 @@ static void Read(OMX_BUFFERHEADERTYPE* pBuffer, Application& app)
     pBuffer->nFilledLen = pBuffer->nAllocLen;
     pBuffer->nFlags |= OMX_BUFFERFLAG_ENDOFFRAME;
     app.encCmd->Process(app.cmdSender, frameCount);
+
+    /* The table is read straight from the file mapping */
+    if(app.qpTables)
+      app.cmdSender->setQPTable(app.qpTables->GetTable(frameCount), app.qpTables->GetTableSize());
     ++frameCount;
   }
 
@@ -805,6 +889,9 @@ static OMX_ERRORTYPE safeMain(int argc, char** argv)
       AL_Riscv_Encode_DestroyCtx(app.pRiscvContext);
   });
 
+  if(app.settings.twoPassChunks > 1)
+    OMX_CALL(setTwoPassChunk(app));
+
   auto ret = setPortParameters(app);
 
   if(ret != OMX_ErrorNone)
@@ -843,6 +930,15 @@ static OMX_ERRORTYPE safeMain(int argc, char** argv)
   auto cmdSender = CommandsSender(app.hEncoder);
   app.cmdSender = &cmdSender;
 
+  unique_ptr<QPTableFile> qpTables;
+
+  if(!app.settings.qpTableFile.empty())
+  {
+    qpTables.reset(new QPTableFile(app.settings.qpTableFile, cmdSender.getQPTableSize()));
+    LOG_IMPORTANT(string { "qp table file = " } +app.settings.qpTableFile + string { " (" } +to_string(qpTables->GetNumTables()) + string { " tables)" });
+    app.qpTables = qpTables.get();
+  }
+
   OMX_ALG_VIDEO_CONFIG_SEI seiPrefix;
   OMX_ALG_VIDEO_CONFIG_SEI seiSuffix;
   InitHeader(seiPrefix);
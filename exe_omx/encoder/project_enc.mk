@@ -4,3 +4,5 @@ EXE_OMX_ENCODER_SRCS:=\
 	$(THIS.exe_omx_encoder)/main.cpp\
 	$(THIS.exe_omx_encoder)/CommandsSender.cpp\
 	$(THIS.exe_omx_encoder)/EncCmdMngr.cpp\
+	$(THIS.exe_omx_encoder)/QPTableFile.cpp\
+	$(THIS)/module/two_pass_log.cpp\
@@ -3,6 +3,7 @@
 
 #include "ROIMngr.h"
 
+#include <cstring>
 #include <stdexcept>
 
 extern "C"
@@ -24,6 +25,16 @@ struct AL_TRoiNode
   int iHeight;
 
   int16_t iDeltaQP;
+
+  /* Keyframed motion, in pixels. The ROI is static when iNumFrames is 0 */
+  int iStartX;
+  int iStartY;
+  int iEndX;
+  int iEndY;
+  int iPixWidth;
+  int iPixHeight;
+  int iNumFrames;
+  int iFrame;
 };
 
 /***************************************************************************/
@@ -225,41 +236,8 @@ static inline void SetLCUQuality(T* pLCUQP, uint16_t uROIQP)
 }
 
 /****************************************************************************/
-static void ComputeROI(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pQPs, int iLcuQpOffset, AL_TRoiNode* pNode)
+static void ComputeROITransitions(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pQPs, int iLcuQpOffset, AL_TRoiNode* pNode)
 {
-  auto* pLCU = pQPs + GetNodePosInBuf(pCtx, pNode->iPosX, pNode->iPosY, iNumBytesPerLCU);
-  uint16_t uDeltaQPOrSegId = pNode->iDeltaQP;
-
-  if(pCtx->bIsAOM && !(pNode->iDeltaQP & MASK_FORCE))
-    uDeltaQPOrSegId = GetSegmentId(pCtx->pDeltaQpSegments, pNode->iDeltaQP);
-
-  /* Fill ROI */
-  for(int h = 0; h < pNode->iHeight; ++h)
-  {
-    for(int w = 0; w < pNode->iWidth; ++w)
-    {
-      if(iLcuQpOffset)
-      {
-        uint16_t uQPOrSegIdAndFlags = pNode->iDeltaQP;
-
-        if(pCtx->bIsAOM)
-          uQPOrSegIdAndFlags = pNode->iDeltaQP & MASK_FORCE;
-        SetLCUQuality<uint16_t>((uint16_t*)(pLCU + w * iNumBytesPerLCU), uQPOrSegIdAndFlags);
-      }
-
-      if(!iLcuQpOffset || pCtx->bIsAOM)
-      {
-        for(int i = 0; i < iNumQPPerLCU - iLcuQpOffset; ++i)
-        {
-          uDeltaQPOrSegId = ((MASK_FORCE & pNode->iDeltaQP) >> (MASK_QP_NUMBITS - 6)) | uDeltaQPOrSegId;
-          SetLCUQuality<uint8_t>(pLCU + w * iNumBytesPerLCU + iLcuQpOffset + i, uDeltaQPOrSegId);
-        }
-      }
-    }
-
-    pLCU += iNumBytesPerLCU * pCtx->iLcuPicWidth;
-  }
-
   if(!(pNode->iDeltaQP & MASK_FORCE))
   {
     /* Update above transition. */
@@ -312,6 +290,129 @@ static void ComputeROI(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerL
   }
 }
 
+/****************************************************************************/
+static bool HasFlag(uint8_t const* pSpan, int iSize, uint16_t uFlag)
+{
+  uint8_t uAccu = 0;
+
+  for(int i = 0; i < iSize; ++i)
+    uAccu |= pSpan[i];
+
+  return uAccu & uFlag;
+}
+
+/****************************************************************************/
+static void FillSpan(uint8_t* pSpan, int iSize, uint16_t uROIQP)
+{
+  /* Most of the time, no LCU of the span keeps a flag: it is a plain run */
+  bool bIsRun = !(uROIQP & MASK_FORCE_INTRA) && ((uROIQP & MASK_FORCE_MV0) || !HasFlag(pSpan, iSize, MASK_FORCE_INTRA));
+
+  if(bIsRun)
+  {
+    memset(pSpan, (uint8_t)uROIQP, iSize);
+    return;
+  }
+
+  for(int i = 0; i < iSize; ++i)
+    SetLCUQuality<uint8_t>(pSpan + i, uROIQP);
+}
+
+/****************************************************************************/
+static inline bool IsPacked(int iNumQPPerLCU, int iNumBytesPerLCU, int iLcuQpOffset)
+{
+  return !iLcuQpOffset && iNumQPPerLCU == iNumBytesPerLCU;
+}
+
+/****************************************************************************/
+static void ComputeROI(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pQPs, int iLcuQpOffset, AL_TRoiNode* pNode)
+{
+  auto* pLCU = pQPs + GetNodePosInBuf(pCtx, pNode->iPosX, pNode->iPosY, iNumBytesPerLCU);
+  uint16_t uDeltaQPOrSegId = pNode->iDeltaQP;
+
+  if(pCtx->bIsAOM && !(pNode->iDeltaQP & MASK_FORCE))
+    uDeltaQPOrSegId = GetSegmentId(pCtx->pDeltaQpSegments, pNode->iDeltaQP);
+
+  /* The QPs of a row of the ROI are contiguous, so the ROI is rasterized as spans */
+  if(IsPacked(iNumQPPerLCU, iNumBytesPerLCU, iLcuQpOffset))
+  {
+    uDeltaQPOrSegId = ((MASK_FORCE & pNode->iDeltaQP) >> (MASK_QP_NUMBITS - 6)) | uDeltaQPOrSegId;
+
+    for(int h = 0; h < pNode->iHeight; ++h)
+    {
+      FillSpan(pLCU, pNode->iWidth * iNumBytesPerLCU, uDeltaQPOrSegId);
+      pLCU += iNumBytesPerLCU * pCtx->iLcuPicWidth;
+    }
+
+    ComputeROITransitions(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pQPs, iLcuQpOffset, pNode);
+    return;
+  }
+
+  /* Fill ROI */
+  for(int h = 0; h < pNode->iHeight; ++h)
+  {
+    for(int w = 0; w < pNode->iWidth; ++w)
+    {
+      if(iLcuQpOffset)
+      {
+        uint16_t uQPOrSegIdAndFlags = pNode->iDeltaQP;
+
+        if(pCtx->bIsAOM)
+          uQPOrSegIdAndFlags = pNode->iDeltaQP & MASK_FORCE;
+        SetLCUQuality<uint16_t>((uint16_t*)(pLCU + w * iNumBytesPerLCU), uQPOrSegIdAndFlags);
+      }
+
+      if(!iLcuQpOffset || pCtx->bIsAOM)
+      {
+        for(int i = 0; i < iNumQPPerLCU - iLcuQpOffset; ++i)
+        {
+          uDeltaQPOrSegId = ((MASK_FORCE & pNode->iDeltaQP) >> (MASK_QP_NUMBITS - 6)) | uDeltaQPOrSegId;
+          SetLCUQuality<uint8_t>(pLCU + w * iNumBytesPerLCU + iLcuQpOffset + i, uDeltaQPOrSegId);
+        }
+      }
+    }
+
+    pLCU += iNumBytesPerLCU * pCtx->iLcuPicWidth;
+  }
+
+  ComputeROITransitions(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pQPs, iLcuQpOffset, pNode);
+}
+
+/****************************************************************************/
+static void FillBackground(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pQPs, int iLcuQpOffset, uint16_t uDeltaQP, uint16_t uBkgQPOrSegId)
+{
+  uint8_t uBkgQP = ((MASK_FORCE & uDeltaQP) >> (MASK_QP_NUMBITS - 6)) | uBkgQPOrSegId;
+
+  if(IsPacked(iNumQPPerLCU, iNumBytesPerLCU, iLcuQpOffset))
+  {
+    memset(pQPs, uBkgQP, pCtx->iNumLCUs * iNumBytesPerLCU);
+    return;
+  }
+
+  for(int iLCU = 0; iLCU < pCtx->iNumLCUs; iLCU++)
+  {
+    int iFirst = iLCU * iNumBytesPerLCU;
+
+    /* iLcuQpOffset is used to make the distinction between QP Table:
+     * V1 (iLcuQpOffset = 0)
+     * V2 (iLcuQpOffset = 4)
+     */
+    if(iLcuQpOffset)
+    {
+      /* For HEVC & AVC, fill only the info of the macro-block, as it will be reused for all its sub-blocks. */
+      if(!pCtx->bIsAOM)
+        pQPs[iFirst] = uBkgQPOrSegId & MASK_QP;
+      pQPs[iFirst + 1] = (uDeltaQP & MASK_FORCE) >> 8;
+      pQPs[iFirst + 3] = DEFAULT_LAMBDA_FACT;
+    }
+
+    if(!iLcuQpOffset || pCtx->bIsAOM)
+    {
+      for(int iQP = iLcuQpOffset; iQP < iNumQPPerLCU; ++iQP)
+        pQPs[iFirst + iQP] = uBkgQP;
+    }
+  }
+}
+
 /****************************************************************************/
 AL_TRoiMngrCtx* AL_RoiMngr_Create(int iPicWidth, int iPicHeight, AL_EProfile eProf, uint8_t uLog2MaxCuSize, AL_ERoiQuality eBkgQuality, AL_ERoiOrder eOrder)
 {
@@ -329,6 +430,7 @@ AL_TRoiMngrCtx* AL_RoiMngr_Create(int iPicWidth, int iPicHeight, AL_EProfile ePr
   pCtx->eOrder = eOrder;
   pCtx->pFirstNode = nullptr;
   pCtx->pLastNode = nullptr;
+  pCtx->uGeneration = 0;
 
   pCtx->iLcuPicWidth = AL_RoundUp(pCtx->iPicWidth, 1 << pCtx->uLog2MaxCuSize) >> pCtx->uLog2MaxCuSize;
   pCtx->iLcuPicHeight = AL_RoundUp(pCtx->iPicHeight, 1 << pCtx->uLog2MaxCuSize) >> pCtx->uLog2MaxCuSize;
@@ -358,28 +460,76 @@ void AL_RoiMngr_Clear(AL_TRoiMngrCtx* pCtx)
 
   pCtx->pFirstNode = nullptr;
   pCtx->pLastNode = nullptr;
+  ++pCtx->uGeneration;
 }
 
 /****************************************************************************/
-bool AL_RoiMngr_AddROI(AL_TRoiMngrCtx* pCtx, int iPosX, int iPosY, int iWidth, int iHeight, AL_ERoiQuality eQuality)
+static void SetPosition(AL_TRoiMngrCtx* pCtx, AL_TRoiNode* pNode, int iPosX, int iPosY, int iWidth, int iHeight)
 {
-  if(iPosX >= pCtx->iPicWidth || iPosY >= pCtx->iPicHeight)
-    return false;
-
   iPosX = iPosX >> pCtx->uLog2MaxCuSize;
   iPosY = iPosY >> pCtx->uLog2MaxCuSize;
   iWidth = AL_RoundUp(iWidth, 1 << pCtx->uLog2MaxCuSize) >> pCtx->uLog2MaxCuSize;
   iHeight = AL_RoundUp(iHeight, 1 << pCtx->uLog2MaxCuSize) >> pCtx->uLog2MaxCuSize;
 
+  pNode->iPosX = iPosX;
+  pNode->iPosY = iPosY;
+  pNode->iWidth = ((iPosX + iWidth) > pCtx->iLcuPicWidth) ? (pCtx->iLcuPicWidth - iPosX) : iWidth;
+  pNode->iHeight = ((iPosY + iHeight) > pCtx->iLcuPicHeight) ? (pCtx->iLcuPicHeight - iPosY) : iHeight;
+}
+
+/****************************************************************************/
+static int Interpolate(int iStart, int iEnd, int iFrame, int iNumFrames)
+{
+  return iStart + (int)((int64_t)(iEnd - iStart) * iFrame / iNumFrames);
+}
+
+/****************************************************************************/
+static bool UpdateMotion(AL_TRoiMngrCtx* pCtx, AL_TRoiNode* pNode)
+{
+  int iPosX = pNode->iPosX;
+  int iPosY = pNode->iPosY;
+  int iWidth = pNode->iWidth;
+  int iHeight = pNode->iHeight;
+
+  SetPosition(pCtx, pNode, Interpolate(pNode->iStartX, pNode->iEndX, pNode->iFrame, pNode->iNumFrames), Interpolate(pNode->iStartY, pNode->iEndY, pNode->iFrame, pNode->iNumFrames), pNode->iPixWidth, pNode->iPixHeight);
+
+  return iPosX != pNode->iPosX || iPosY != pNode->iPosY || iWidth != pNode->iWidth || iHeight != pNode->iHeight;
+}
+
+/****************************************************************************/
+bool AL_RoiMngr_AddROI(AL_TRoiMngrCtx* pCtx, int iPosX, int iPosY, int iWidth, int iHeight, AL_ERoiQuality eQuality)
+{
+  return AL_RoiMngr_AddMovingROI(pCtx, iPosX, iPosY, iPosX, iPosY, iWidth, iHeight, 0, eQuality);
+}
+
+/****************************************************************************/
+bool AL_RoiMngr_AddMovingROI(AL_TRoiMngrCtx* pCtx, int iPosX, int iPosY, int iEndPosX, int iEndPosY, int iWidth, int iHeight, int iNumFrames, AL_ERoiQuality eQuality)
+{
+  if(iPosX >= pCtx->iPicWidth || iPosY >= pCtx->iPicHeight)
+    return false;
+
+  if(iNumFrames < 0)
+    return false;
+
+  /* The interpolated positions stay between the start and the end ones: both must be in the picture */
+  if(iNumFrames > 0 && (iPosX < 0 || iPosY < 0 || iEndPosX < 0 || iEndPosY < 0 || iEndPosX >= pCtx->iPicWidth || iEndPosY >= pCtx->iPicHeight))
+    return false;
+
   AL_TRoiNode* pNode = (AL_TRoiNode*)Rtos_Malloc(sizeof(AL_TRoiNode));
 
   if(!pNode)
     return false;
 
-  pNode->iPosX = iPosX;
-  pNode->iPosY = iPosY;
-  pNode->iWidth = ((iPosX + iWidth) > pCtx->iLcuPicWidth) ? (pCtx->iLcuPicWidth - iPosX) : iWidth;
-  pNode->iHeight = ((iPosY + iHeight) > pCtx->iLcuPicHeight) ? (pCtx->iLcuPicHeight - iPosY) : iHeight;
+  SetPosition(pCtx, pNode, iPosX, iPosY, iWidth, iHeight);
+
+  pNode->iStartX = iPosX;
+  pNode->iStartY = iPosY;
+  pNode->iEndX = iEndPosX;
+  pNode->iEndY = iEndPosY;
+  pNode->iPixWidth = iWidth;
+  pNode->iPixHeight = iHeight;
+  pNode->iNumFrames = iNumFrames;
+  pNode->iFrame = 0;
 
   pNode->iDeltaQP = GetNewDeltaQP(eQuality);
   pNode->pNext = nullptr;
@@ -390,9 +540,32 @@ bool AL_RoiMngr_AddROI(AL_TRoiMngrCtx* pCtx, int iPosX, int iPosY, int iWidth, i
   else
     PushBack(pCtx, pNode);
 
+  ++pCtx->uGeneration;
+
   return true;
 }
 
+/****************************************************************************/
+void AL_RoiMngr_NextFrame(AL_TRoiMngrCtx* pCtx)
+{
+  bool bMoved = false;
+
+  for(AL_TRoiNode* pCur = pCtx->pFirstNode; pCur; pCur = pCur->pNext)
+  {
+    if(pCur->iFrame >= pCur->iNumFrames)
+      continue;
+
+    ++pCur->iFrame;
+
+    if(UpdateMotion(pCtx, pCur))
+      bMoved = true;
+  }
+
+  /* Motion within a LCU doesn't change the QP table */
+  if(bMoved)
+    ++pCtx->uGeneration;
+}
+
 /****************************************************************************/
 void AL_RoiMngr_FillBuff(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPerLCU, uint8_t* pQPs, int iLcuQpOffset)
 {
@@ -417,31 +590,7 @@ void AL_RoiMngr_FillBuff(AL_TRoiMngrCtx* pCtx, int iNumQPPerLCU, int iNumBytesPe
   }
 
   /* Fill background */
-  for(int iLCU = 0; iLCU < pCtx->iNumLCUs; iLCU++)
-  {
-    int iFirst = iLCU * iNumBytesPerLCU;
-
-    /* iLcuQpOffset is used to make the distinction between QP Table:
-     * V1 (iLcuQpOffset = 0)
-     * V2 (iLcuQpOffset = 4)
-     */
-    if(iLcuQpOffset)
-    {
-      /* For HEVC & AVC, fill only the info of the macro-block, as it will be reused for all its sub-blocks. */
-      if(!pCtx->bIsAOM)
-        pQPs[iFirst] = uBkgQPOrSegId & MASK_QP;
-      pQPs[iFirst + 1] = (uDeltaQP & MASK_FORCE) >> 8;
-      pQPs[iFirst + 3] = DEFAULT_LAMBDA_FACT;
-    }
-
-    if(!iLcuQpOffset || pCtx->bIsAOM)
-    {
-      for(int iQP = iLcuQpOffset; iQP < iNumQPPerLCU; ++iQP)
-      {
-        pQPs[iFirst + iQP] = ((MASK_FORCE & uDeltaQP) >> (MASK_QP_NUMBITS - 6)) | uBkgQPOrSegId;
-      }
-    }
-  }
+  FillBackground(pCtx, iNumQPPerLCU, iNumBytesPerLCU, pQPs, iLcuQpOffset, uDeltaQP, uBkgQPOrSegId);
 
   /* Fill ROIs */
   AL_TRoiNode* pCur = pCtx->pFirstNode;
@@ -61,6 +61,8 @@ struct AL_TRoiMngrCtx
   AL_TRoiNode* pFirstNode;
   AL_TRoiNode* pLastNode;
   int16_t* pDeltaQpSegments;
+
+  uint32_t uGeneration; /*!< Incremented each time the ROIs change, a QP table filled at the same generation can be reused */
 };
 
 /*****************************************************************************
@@ -99,6 +101,29 @@ void AL_RoiMngr_Clear(AL_TRoiMngrCtx* pCtx);
 *****************************************************************************/
 bool AL_RoiMngr_AddROI(AL_TRoiMngrCtx* pCtx, int iPosX, int iPosY, int iWidth, int iHeight, AL_ERoiQuality eQuality);
 
+/*****************************************************************************
+   \brief Add a ROI moving linearly from one position to another
+   \param[in] pCtx Pointer to the ROI Manager context
+   \param[in] iPosX Left position of the ROI on the current frame
+   \param[in] iPosY Top position of the ROI on the current frame
+   \param[in] iEndPosX Left position of the ROI after iNumFrames frames
+   \param[in] iEndPosY Top position of the ROI after iNumFrames frames
+   \param[in] iWidth Width of the ROI
+   \param[in] iHeight Height of the ROI
+   \param[in] iNumFrames Number of frames of the motion. The ROI stays at its
+   end position afterwards. 0 adds a static ROI
+   \param[in] eQuality Quality of the ROI
+   \return True if the ROI was successfully added. A moving ROI is refused when
+   its start or end position is outside of the picture
+*****************************************************************************/
+bool AL_RoiMngr_AddMovingROI(AL_TRoiMngrCtx* pCtx, int iPosX, int iPosY, int iEndPosX, int iEndPosY, int iWidth, int iHeight, int iNumFrames, AL_ERoiQuality eQuality);
+
+/*****************************************************************************
+   \brief Move the moving ROIs of a ROI Manager to their position on the next frame
+   \param[in] pCtx Pointer to the ROI Manager context
+*****************************************************************************/
+void AL_RoiMngr_NextFrame(AL_TRoiMngrCtx* pCtx);
+
 /*****************************************************************************
    \brief Fill a QP table buffer according to the configuration of a ROI Manager
    \param[in] pCtx Pointer to the ROI Manager context
@@ -2,13 +2,24 @@
 // SPDX-License-Identifier: MIT
 
 #include "TwoPassMngr.h"
+#include "two_pass_log.h"
 #include <stdexcept>
 #include <string>
 #include <algorithm>
 #include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define SEQUENCE_SIZE_MAX 1000
 
+/* The second pass looks at the frames up to half a window before and after the current one */
+static int constexpr HALF_WINDOW_SIZE = SEQUENCE_SIZE_MAX / 2;
+
+/* The lookahead complexity compares the size of the first frames of the fifo to the whole fifo */
+static int constexpr COMPLEXITY_HEAD_SIZE = 5;
+
 using namespace std;
 
 /***************************************************************************/
@@ -55,22 +66,99 @@ static int32_t GetIPRatio(AL_TLookAheadMetaData* pCurrentMeta, AL_TLookAheadMeta
   return max(static_cast<int64_t>(100), 1000 * static_cast<int64_t>(pCurrentMeta->iPictureSize) / pNextMeta->iPictureSize);
 }
 
+/* The metadata keeps its pool alive while it is attached to a src buffer */
+struct LookAheadMetaDataPool::PooledMetaData
+{
+  AL_TLookAheadMetaData tMeta;
+  shared_ptr<LookAheadMetaDataPool> pPool;
+};
+
+/***************************************************************************/
+LookAheadMetaDataPool::LookAheadMetaDataPool(int p_iSize)
+{
+  for(int i = 0; i < p_iSize; i++)
+    tFreeMetaData.push_back(Allocate());
+}
+
+/***************************************************************************/
+LookAheadMetaDataPool::~LookAheadMetaDataPool(void)
+{
+  for(auto pPooled : tFreeMetaData)
+    delete pPooled;
+}
+
+/***************************************************************************/
+LookAheadMetaDataPool::PooledMetaData* LookAheadMetaDataPool::Allocate(void)
+{
+  auto pPooled = new PooledMetaData {};
+  pPooled->tMeta.tMeta.eType = AL_META_TYPE_LOOKAHEAD;
+  pPooled->tMeta.tMeta.MetaDestroy = &LookAheadMetaDataPool::DestroyMetaData;
+  pPooled->tMeta.tMeta.MetaClone = &LookAheadMetaDataPool::CloneMetaData;
+  uNumAllocations++;
+  return pPooled;
+}
+
+/***************************************************************************/
+bool LookAheadMetaDataPool::DestroyMetaData(AL_TMetaData* pMeta)
+{
+  auto pPooled = reinterpret_cast<PooledMetaData*>(pMeta);
+  auto pPool = move(pPooled->pPool);
+  lock_guard<mutex> lock(pPool->tMutex);
+  pPool->tFreeMetaData.push_back(pPooled);
+  return true;
+}
+
+/***************************************************************************/
+AL_TMetaData* LookAheadMetaDataPool::CloneMetaData(AL_TMetaData* pMeta)
+{
+  auto pClone = AL_LookAheadMetaData_Create();
+
+  if(pClone)
+    AL_LookAheadMetaData_Copy(reinterpret_cast<AL_TLookAheadMetaData*>(pMeta), pClone);
+
+  return reinterpret_cast<AL_TMetaData*>(pClone);
+}
+
 /***************************************************************************/
-AL_TLookAheadMetaData* AL_TwoPassMngr_CreateAndAttachTwoPassMetaData(AL_TBuffer* Src)
+AL_TLookAheadMetaData* LookAheadMetaDataPool::CreateAndAttach(AL_TBuffer* Src)
 {
   auto pPictureMetaTP = reinterpret_cast<AL_TLookAheadMetaData*>(AL_Buffer_GetMetaData(Src, AL_META_TYPE_LOOKAHEAD));
 
   if(!pPictureMetaTP)
   {
-    pPictureMetaTP = AL_LookAheadMetaData_Create();
+    PooledMetaData* pPooled = nullptr;
+    {
+      lock_guard<mutex> lock(tMutex);
+
+      if(!tFreeMetaData.empty())
+      {
+        pPooled = tFreeMetaData.back();
+        tFreeMetaData.pop_back();
+      }
+    }
+
+    if(!pPooled)
+      pPooled = Allocate();
+
+    pPooled->pPool = shared_from_this();
+    pPictureMetaTP = &pPooled->tMeta;
 
     if(AL_Buffer_AddMetaData(Src, reinterpret_cast<AL_TMetaData*>(pPictureMetaTP)) == false)
+    {
+      DestroyMetaData(reinterpret_cast<AL_TMetaData*>(pPictureMetaTP));
       throw runtime_error("Add meta shouldn't fail!");
+    }
   }
   AL_LookAheadMetaData_Reset(pPictureMetaTP);
   return pPictureMetaTP;
 }
 
+/***************************************************************************/
+uint64_t LookAheadMetaDataPool::GetNumAllocations(void) const
+{
+  return uNumAllocations;
+}
+
 /***************************************************************************/
 bool AL_TwoPassMngr_HasLookAhead(AL_TEncSettings const& settings)
 {
@@ -134,6 +222,18 @@ static bool DetectPatternTwoFrames(vector<int> v)
   return ecart_max == 1 && nb_zero >= ((int)v.size() - 1) / 2;
 }
 
+/***************************************************************************/
+static AL_TLookAheadMetaData CreateLogMetaData(int iPictureSize, int iPercentIntra)
+{
+  AL_TLookAheadMetaData tParams {};
+  tParams.iPictureSize = iPictureSize;
+  tParams.iPercentIntra[0] = iPercentIntra;
+  tParams.iComplexity = 0;
+  tParams.eSceneChange = AL_SC_NONE;
+  tParams.iIPRatio = 1000;
+  return tParams;
+}
+
 /***************************************************************************/
 /*Offline TwoPass methods*/
 /***************************************************************************/
@@ -142,6 +242,8 @@ TwoPassMngr::TwoPassMngr(std::string p_FileName, int p_iPass, bool p_bEnabledFir
   iCpbLevel(p_iCpbLevel), iInitialLevel(p_iInitialLevel), iFrameRate(p_iFrameRate)
 {
   FileName = { p_FileName };
+  bBinaryLog = !IsTwoPassTextLogName(FileName);
+  iLevel = iInitialLevel;
   tFrames.clear();
 }
 
@@ -157,14 +259,51 @@ void TwoPassMngr::OpenLog(void)
 {
   if(iPass == 1)
   {
-    outputFile.open(FileName);
+    outputFile.open(FileName, bBinaryLog ? ios::binary : ios::out);
 
     if(!outputFile.is_open())
       throw runtime_error("Can't open TwoPass LogFile");
+
+    if(bBinaryLog)
+      WriteTwoPassLogHeader(outputFile);
   }
 
   if(iPass == 2)
   {
+    if(iCpbLevel < iInitialLevel)
+      throw runtime_error("iCpbLevel(" + to_string(iCpbLevel) + ") should be higher or equal than iInitialLevel(" + to_string(iInitialLevel) + ")");
+
+    auto fd = open(FileName.c_str(), O_RDONLY);
+
+    if(fd < 0)
+      throw runtime_error("Can't open TwoPass LogFile");
+
+    struct stat tStat;
+    TwoPassLogHeader tHeader {};
+    bBinaryLog = fstat(fd, &tStat) == 0 && static_cast<size_t>(tStat.st_size) >= sizeof(tHeader) && read(fd, &tHeader, sizeof(tHeader)) == sizeof(tHeader) && memcmp(tHeader.cMagic, TWOPASS_LOG_MAGIC, sizeof(tHeader.cMagic)) == 0;
+
+    if(bBinaryLog)
+    {
+      if(tHeader.uVersion != TWOPASS_LOG_VERSION || tHeader.uRecordSize != sizeof(TwoPassLogRecord))
+      {
+        close(fd);
+        throw runtime_error("Unsupported TwoPass LogFile version");
+      }
+
+      auto pAddr = mmap(nullptr, tStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+
+      if(pAddr == MAP_FAILED)
+        throw runtime_error("Can't map TwoPass LogFile");
+
+      madvise(pAddr, tStat.st_size, MADV_SEQUENTIAL);
+      pMappedLog = static_cast<uint8_t*>(pAddr);
+      zMappedLogSize = tStat.st_size;
+      zMappedLogOffset = sizeof(tHeader);
+      return;
+    }
+
+    close(fd);
     inputFile.open(FileName);
 
     if(!inputFile.is_open())
@@ -177,37 +316,51 @@ void TwoPassMngr::CloseLog(void)
 {
   inputFile.close();
   outputFile.close();
+
+  if(pMappedLog)
+    munmap(pMappedLog, zMappedLogSize);
+  pMappedLog = nullptr;
 }
 
 /***************************************************************************/
-void TwoPassMngr::EmptyLog(void)
+bool TwoPassMngr::ReadRecord(int& iPictureSize, int& iPercentIntra)
 {
-  if(!inputFile.is_open())
-    OpenLog();
-
-  tFrames.clear();
+  if(pMappedLog)
+    return ReadBinaryRecord(iPictureSize, iPercentIntra);
+  return ReadTextRecord(iPictureSize, iPercentIntra);
+}
 
+/***************************************************************************/
+bool TwoPassMngr::ReadTextRecord(int& iPictureSize, int& iPercentIntra)
+{
   char sLine[256];
-  bool bFind = true;
-  int i = 0;
 
-  while(bFind && !inputFile.eof() && i < SEQUENCE_SIZE_MAX)
-  {
-    inputFile.getline(sLine, 256);
+  if(inputFile.eof())
+    return false;
 
-    auto str_PicSize = strtok(sLine, " ");
-    auto str_PercentIntra = strtok(nullptr, " ");
+  inputFile.getline(sLine, 256);
 
-    bFind = ((str_PicSize != nullptr) && (str_PercentIntra != nullptr));
+  TwoPassLogRecord tRecord;
 
-    if(!bFind)
-      break;
+  if(!ParseTwoPassTextRecord(sLine, tRecord))
+    return false;
 
-    AddNewFrame(atoi(str_PicSize), atoi(str_PercentIntra));
-    i++;
-  }
+  iPictureSize = tRecord.iPictureSize;
+  iPercentIntra = tRecord.iPercentIntra;
+  return true;
+}
+
+/***************************************************************************/
+bool TwoPassMngr::ReadBinaryRecord(int& iPictureSize, int& iPercentIntra)
+{
+  if(zMappedLogSize - zMappedLogOffset < sizeof(TwoPassLogRecord))
+    return false;
 
-  ComputeTwoPass();
+  auto pRecord = reinterpret_cast<TwoPassLogRecord const*>(pMappedLog + zMappedLogOffset);
+  iPictureSize = pRecord->iPictureSize;
+  iPercentIntra = pRecord->iPercentIntra;
+  zMappedLogOffset += sizeof(TwoPassLogRecord);
+  return true;
 }
 
 /***************************************************************************/
@@ -216,22 +369,14 @@ void TwoPassMngr::FillLog(void)
   if(!outputFile.is_open())
     OpenLog();
 
-  for(auto frame: tFrames)
-    outputFile << frame.iPictureSize << " " << static_cast<int>(frame.iPercentIntra[0]) << endl;
+  vector<TwoPassLogRecord> tRecords;
+  tRecords.reserve(tFrames.size());
 
-  tFrames.clear();
-}
+  for(auto const& frame: tFrames)
+    tRecords.push_back({ static_cast<int32_t>(frame.iPictureSize), static_cast<int32_t>(frame.iPercentIntra[0]) });
 
-/***************************************************************************/
-void TwoPassMngr::AddNewFrame(int iPictureSize, int iPercentIntra)
-{
-  AL_TLookAheadMetaData tParams;
-  tParams.iPictureSize = iPictureSize;
-  tParams.iPercentIntra[0] = iPercentIntra;
-  tParams.iComplexity = 0;
-  tParams.eSceneChange = AL_SC_NONE;
-  tParams.iIPRatio = 1000;
-  tFrames.push_back(tParams);
+  WriteTwoPassLogRecords(outputFile, bBinaryLog, tRecords);
+  tFrames.clear();
 }
 
 /***************************************************************************/
@@ -250,153 +395,312 @@ void TwoPassMngr::AddFrame(AL_TLookAheadMetaData* pMetaData)
 void TwoPassMngr::Flush(void)
 {
   FillLog();
+  outputFile.flush();
 }
 
 /***************************************************************************/
 void TwoPassMngr::GetFrame(AL_TLookAheadMetaData* pMetaData)
 {
-  if(iCurrentFrame >= static_cast<int>(tFrames.size()))
+  if(!bEndOfLog && !inputFile.is_open() && !pMappedLog)
+    OpenLog();
+
+  while(!bEndOfLog && !IsFrameReady(iCurrentFrame))
   {
-    EmptyLog();
-    iCurrentFrame = 0;
+    int iPictureSize, iPercentIntra;
 
-    if(static_cast<int>(tFrames.size()) == 0)
-      throw runtime_error("[Pass 2] : Not enough frames from pass 1 Logfile");
+    if(ReadRecord(iPictureSize, iPercentIntra))
+      PushFrame(iPictureSize, iPercentIntra);
+    else
+    {
+      bEndOfLog = true;
+      bWholeSequence = iNumFrames <= SEQUENCE_SIZE_MAX;
+    }
+
+    UpdateWindow();
   }
-  AL_LookAheadMetaData_Copy(&tFrames[iCurrentFrame], pMetaData);
+
+  if(iCurrentFrame >= iNumFrames)
+    throw runtime_error("[Pass 2] : Not enough frames from pass 1 Logfile");
+
+  auto& tFrame = Frame(iCurrentFrame);
+
+  if(HasPatternTwoFrames(iCurrentFrame))
+  {
+    auto bLastFrame = iCurrentFrame == iNumFrames - 1;
+    auto tMeta = CreateLogMetaData(bLastFrame ? tFrame.tMeta.iPictureSize : 0, tFrame.tMeta.iPercentIntra[0]);
+    AL_LookAheadMetaData_Copy(&tMeta, pMetaData);
+  }
+  else
+    AL_LookAheadMetaData_Copy(&tFrame.tMeta, pMetaData);
+
   iCurrentFrame++;
+  TrimWindow();
 }
 
 /***************************************************************************/
-void TwoPassMngr::ComputeTwoPass(void)
+TwoPassMngr::WindowFrame& TwoPassMngr::Frame(int iFrame)
 {
-  auto iSequenceSize = static_cast<int>(tFrames.size());
+  return tWindow[iFrame - iWindowBase];
+}
 
-  if(HasPatternTwoFrames())
-  {
-    for(int i = 0; i < iSequenceSize - 1; i++)
-      tFrames[i].iPictureSize = 0;
+/***************************************************************************/
+TwoPassMngr::WindowGop& TwoPassMngr::Gop(int iGop)
+{
+  return tGops[iGop - iGopBase];
+}
 
-    return;
+/***************************************************************************/
+/* Nothing is computed before knowing whether the whole logfile holds in a window */
+bool TwoPassMngr::IsWindowSizeKnown(void)
+{
+  return bEndOfLog || iNumFrames > SEQUENCE_SIZE_MAX;
+}
+
+/***************************************************************************/
+int TwoPassMngr::GetHalfWindowSize(void)
+{
+  return bWholeSequence ? SEQUENCE_SIZE_MAX : HALF_WINDOW_SIZE;
+}
+
+/***************************************************************************/
+void TwoPassMngr::PushFrame(int iPictureSize, int iPercentIntra)
+{
+  WindowFrame tFrame {};
+  tFrame.tMeta = CreateLogMetaData(iPictureSize, iPercentIntra);
+
+  if(iNumFrames > 0)
+  {
+    auto const& tPrev = Frame(iNumFrames - 1);
+    tFrame.iNumZeros = tPrev.iNumZeros;
+    tFrame.iNumRunEnds = tPrev.iNumRunEnds;
+    tFrame.iNumLongRunEnds = tPrev.iNumLongRunEnds;
   }
 
-  for(int i = 0; i < iSequenceSize - 1; i++)
-    tFrames[i].eSceneChange = SceneChangeDetected(&tFrames[i], &tFrames[i + 1]) ? AL_SC_NEXT : AL_SC_NONE;
+  /* A run end is a zero right after a non zero value, a long run end is right after two of them */
+  auto bZero = tFrame.tMeta.iPercentIntra[0] == 0;
+  auto bRunEnd = bZero && iNumFrames >= 1 && Frame(iNumFrames - 1).tMeta.iPercentIntra[0] != 0;
+  auto bLongRunEnd = bRunEnd && iNumFrames >= 2 && Frame(iNumFrames - 2).tMeta.iPercentIntra[0] != 0;
+  tFrame.iNumZeros += bZero ? 1 : 0;
+  tFrame.iNumRunEnds += bRunEnd ? 1 : 0;
+  tFrame.iNumLongRunEnds += bLongRunEnd ? 1 : 0;
+
+  tWindow.push_back(tFrame);
+  iNumFrames++;
+}
 
-  for(int i = 0; i < iSequenceSize - 1; i++)
+/***************************************************************************/
+void TwoPassMngr::TrimWindow(void)
+{
+  while(iWindowBase < iCurrentFrame - GetHalfWindowSize())
   {
-    tFrames[i].iIPRatio = GetIPRatio(&tFrames[i], &tFrames[i + 1]);
+    tWindow.pop_front();
+    iWindowBase++;
+  }
 
-    for(int k = i + 2; k < min(iSequenceSize, i + 4) && !SceneChangeDetected(&tFrames[k - 1], &tFrames[k]); k++)
-      tFrames[i].iIPRatio = min(tFrames[i].iIPRatio, GetIPRatio(&tFrames[i], &tFrames[k]));
+  while(iGopBase < iCoeffLo - 1)
+  {
+    tGops.pop_front();
+    iGopBase++;
   }
+}
+
+/***************************************************************************/
+bool TwoPassMngr::IsFrameReady(int iFrame)
+{
+  if(iFrame >= iNextIPRatio)
+    return false;
+
+  if(iGopSize > 0 && iFrame >= iNumComputedFrames)
+    return false;
+
+  if(!IsWindowSizeKnown())
+    return false;
 
-  ComputeComplexity();
+  return bEndOfLog || iFrame + HALF_WINDOW_SIZE <= iNumFrames;
 }
 
 /***************************************************************************/
-void TwoPassMngr::ComputeComplexity(void)
+void TwoPassMngr::UpdateWindow(void)
 {
-  auto iSequenceSize = static_cast<int>(tFrames.size());
+  for(; iNextSceneChange + 1 < iNumFrames; iNextSceneChange++)
+    Frame(iNextSceneChange).tMeta.eSceneChange = SceneChangeDetected(&Frame(iNextSceneChange).tMeta, &Frame(iNextSceneChange + 1).tMeta) ? AL_SC_NEXT : AL_SC_NONE;
 
-  if(iSequenceSize <= 0)
-    throw runtime_error("iSequenceSize(" + to_string(iSequenceSize) + ") must be higher than 0");
+  if(bEndOfLog)
+    iNextSceneChange = iNumFrames;
 
-  if(iSequenceSize > SEQUENCE_SIZE_MAX)
-    throw runtime_error("iSequenceSize(" + to_string(iSequenceSize) + ") must be lower than SEQUENCE_SIZE_MAX(" + to_string(SEQUENCE_SIZE_MAX) + ")");
+  for(; iNextIPRatio + 3 < iNumFrames || (bEndOfLog && iNextIPRatio < iNumFrames); iNextIPRatio++)
+    UpdateIPRatio(iNextIPRatio);
 
-  if(iCpbLevel < iInitialLevel)
-    throw runtime_error("iCpbLevel(" + to_string(iCpbLevel) + ") should be higher or equal than iInitialLevel(" + to_string(iInitialLevel) + ")");
+  if(iGopSize <= 0)
+    return;
 
-  if(iGopSize == 0 || iSequenceSize == 0)
+  UpdateGops();
+
+  if(!IsWindowSizeKnown())
     return;
 
-  size_t uSumCompGops = 0;
-  int iIndex = 0, iNbGop = 0;
+  ComputeGopDeviations();
+  ComputeGopTargets();
+}
 
-  while(iIndex < iSequenceSize)
-  {
-    int iLength = 0;
-    size_t uSumComp = 0;
+/***************************************************************************/
+void TwoPassMngr::UpdateIPRatio(int iFrame)
+{
+  if(iFrame + 1 >= iNumFrames)
+    return;
 
-    while(iLength < iGopSize && iIndex + iLength < iSequenceSize)
-    {
-      uSumComp += tFrames[iIndex + iLength].iPictureSize;
-      iLength++;
+  auto& tCurrent = Frame(iFrame).tMeta;
+  tCurrent.iIPRatio = GetIPRatio(&tCurrent, &Frame(iFrame + 1).tMeta);
 
-      if(tFrames[iIndex + iLength - 1].eSceneChange == AL_SC_NEXT)
-        break;
-    }
+  for(int k = iFrame + 2; k < min(iNumFrames, iFrame + 4) && !SceneChangeDetected(&Frame(k - 1).tMeta, &Frame(k).tMeta); k++)
+    tCurrent.iIPRatio = min(tCurrent.iIPRatio, GetIPRatio(&tCurrent, &Frame(k).tMeta));
+}
 
-    int iComp = iLength ? uSumComp / iLength : uSumComp;
+/***************************************************************************/
+void TwoPassMngr::UpdateGops(void)
+{
+  auto iMaxLength = min(iGopSize, SEQUENCE_SIZE_MAX);
 
-    for(int k = 0; k < iLength; k++)
-      tFrames[iIndex + k].iComplexity = iComp;
+  for(; iNextGopFrame < iNextSceneChange; iNextGopFrame++)
+  {
+    auto const& tMeta = Frame(iNextGopFrame).tMeta;
+    tOpenGop.uSumComp += tMeta.iPictureSize;
+    tOpenGop.iLength++;
 
-    uSumCompGops += iComp;
-    iNbGop++;
-    iIndex += iLength;
+    if(tOpenGop.iLength >= iMaxLength || tMeta.eSceneChange == AL_SC_NEXT)
+      CloseGop();
   }
 
-  int iMeanComp = uSumCompGops / iNbGop;
+  if(bEndOfLog && tOpenGop.iLength > 0)
+    CloseGop();
+}
 
-  int iLevel = 0, iLevelMax = 0, iLevelMin = 0;
-  int iLimitMin = -iInitialLevel;
-  int iLimitMax = (iCpbLevel - iInitialLevel);
+/***************************************************************************/
+void TwoPassMngr::CloseGop(void)
+{
+  tOpenGop.iComplexity = tOpenGop.uSumComp / tOpenGop.iLength;
+  tGops.push_back(tOpenGop);
+  iNumGops++;
 
-  for(int i = 0; i < iSequenceSize; i++)
+  WindowGop tNextGop {};
+  tNextGop.iStart = tOpenGop.iStart + tOpenGop.iLength;
+  tOpenGop = tNextGop;
+}
+
+/***************************************************************************/
+bool TwoPassMngr::IsGopWindowComplete(int iWindowEnd, int iNumDoneGops)
+{
+  if(iNumDoneGops < iNumGops)
+    return Gop(iNumDoneGops).iStart >= iWindowEnd;
+
+  return (bEndOfLog && iNextGopFrame == iNumFrames) || tOpenGop.iStart >= iWindowEnd;
+}
+
+/***************************************************************************/
+void TwoPassMngr::ComputeGopDeviations(void)
+{
+  auto iHalfWindowSize = GetHalfWindowSize();
+
+  for(; iNextMeanGop < iNumGops && IsGopWindowComplete(Gop(iNextMeanGop).iStart + iHalfWindowSize, iNumGops); iNextMeanGop++)
   {
-    tFrames[i].iComplexity = (tFrames[i].iComplexity * 1000 / iMeanComp) - 1000;
-    iLevel -= tFrames[i].iComplexity / iFrameRate;
-    iLevelMax = max(iLevelMax, iLevel);
-    iLevelMin = min(iLevelMin, iLevel);
-  }
+    auto& tGop = Gop(iNextMeanGop);
 
-  int iCoeff = 1000;
+    for(; iMeanHi < iNumGops && Gop(iMeanHi).iStart < tGop.iStart + iHalfWindowSize; iMeanHi++)
+      uMeanSumComp += Gop(iMeanHi).iComplexity;
 
-  if(iLevelMax > 0)
-    iCoeff = min(iCoeff, iLimitMax * 1000 / iLevelMax);
+    for(; Gop(iMeanLo).iStart < tGop.iStart - iHalfWindowSize; iMeanLo++)
+      uMeanSumComp -= Gop(iMeanLo).iComplexity;
 
-  if(iLevelMin < 0)
-    iCoeff = min(iCoeff, iLimitMin * 900 / iLevelMin);
+    int iMeanComp = uMeanSumComp / (iMeanHi - iMeanLo);
+    tGop.iDeviation = iMeanComp ? (tGop.iComplexity * 1000 / iMeanComp) - 1000 : 0;
 
-  for(int i = 0; i < iSequenceSize; i++)
-    tFrames[i].iComplexity = (tFrames[i].iComplexity * iCoeff / 1000) + 1000;
+    auto iPrevLevel = iNextMeanGop > 0 ? Gop(iNextMeanGop - 1).iLevel : 0;
+    tGop.iLevel = iPrevLevel - static_cast<int64_t>(tGop.iLength) * (tGop.iDeviation / iFrameRate);
+  }
+}
 
-  iIndex = 0;
-  iLevel = iInitialLevel;
+/***************************************************************************/
+void TwoPassMngr::ComputeGopTargets(void)
+{
+  int iLimitMin = -iInitialLevel;
+  int iLimitMax = (iCpbLevel - iInitialLevel);
+  auto iHalfWindowSize = GetHalfWindowSize();
 
-  while(iIndex < iSequenceSize)
+  for(; iNextCoeffGop < iNextMeanGop && IsGopWindowComplete(Gop(iNextCoeffGop).iStart + iHalfWindowSize, iNextMeanGop); iNextCoeffGop++)
   {
-    int iLength = 0;
+    auto const& tGop = Gop(iNextCoeffGop);
 
-    while(iLength < iGopSize && iIndex + iLength < iSequenceSize)
+    for(; iCoeffHi < iNextMeanGop && Gop(iCoeffHi).iStart < tGop.iStart + iHalfWindowSize; iCoeffHi++)
     {
-      iLength++;
+      auto iGopLevel = Gop(iCoeffHi).iLevel;
+
+      while(!tLevelMaxGops.empty() && Gop(tLevelMaxGops.back()).iLevel <= iGopLevel)
+        tLevelMaxGops.pop_back();
+
+      while(!tLevelMinGops.empty() && Gop(tLevelMinGops.back()).iLevel >= iGopLevel)
+        tLevelMinGops.pop_back();
 
-      if(tFrames[iIndex + iLength - 1].eSceneChange == AL_SC_NEXT)
-        break;
+      tLevelMaxGops.push_back(iCoeffHi);
+      tLevelMinGops.push_back(iCoeffHi);
     }
 
-    int iTarget = iLevel - iGopSize * (tFrames[iIndex].iComplexity - 1000) / iFrameRate;
-    iLevel -= iLength * (tFrames[iIndex].iComplexity - 1000) / iFrameRate;
+    for(; Gop(iCoeffLo).iStart < tGop.iStart - iHalfWindowSize; iCoeffLo++)
+      ;
+
+    while(tLevelMaxGops.front() < iCoeffLo)
+      tLevelMaxGops.pop_front();
+
+    while(tLevelMinGops.front() < iCoeffLo)
+      tLevelMinGops.pop_front();
+
+    /* The level simulated over the window, as if the window was a whole sequence */
+    auto iWindowLevel = iCoeffLo > 0 ? Gop(iCoeffLo - 1).iLevel : 0;
+    auto iLevelMax = max<int64_t>(0, Gop(tLevelMaxGops.front()).iLevel - iWindowLevel);
+    auto iLevelMin = min<int64_t>(0, Gop(tLevelMinGops.front()).iLevel - iWindowLevel);
+
+    int64_t iCoeff = 1000;
+
+    if(iLevelMax > 0)
+      iCoeff = min<int64_t>(iCoeff, iLimitMax * 1000 / iLevelMax);
+
+    if(iLevelMin < 0)
+      iCoeff = min<int64_t>(iCoeff, iLimitMin * 900 / iLevelMin);
+
+    auto iComplexity = static_cast<int>(tGop.iDeviation * iCoeff / 1000) + 1000;
+    int iTarget = iLevel - iGopSize * (iComplexity - 1000) / iFrameRate;
+    iLevel -= tGop.iLength * (iComplexity - 1000) / iFrameRate;
 
-    for(int k = 0; k < iLength; k++)
-      tFrames[iIndex + k].iTargetLevel = iTarget;
+    /* Nothing resets the level between windows, it is pulled back to the initial level instead.
+     * A sequence holding in one window keeps its own level, as any chunk of it would */
+    if(!bWholeSequence)
+      iLevel += (iInitialLevel - iLevel) * tGop.iLength / SEQUENCE_SIZE_MAX;
 
-    iIndex += iLength;
+    for(int i = tGop.iStart; i < tGop.iStart + tGop.iLength; i++)
+    {
+      Frame(i).tMeta.iComplexity = iComplexity;
+      Frame(i).tMeta.iTargetLevel = iTarget;
+    }
+
+    iNumComputedFrames = tGop.iStart + tGop.iLength;
   }
 }
 
 /***************************************************************************/
-bool TwoPassMngr::HasPatternTwoFrames(void)
+bool TwoPassMngr::HasPatternTwoFrames(int iFrame)
 {
-  vector<int> v {};
+  /* Same decision as DetectPatternTwoFrames on the frames of the window, from the cumulative counts */
+  auto iFirst = max(0, iFrame - GetHalfWindowSize());
+  auto iLast = min(iNumFrames, iFrame + GetHalfWindowSize()) - 1;
+  auto iSize = iLast - iFirst + 1;
 
-  for(auto i = tFrames.begin(); i < tFrames.end(); i++)
-    v.push_back(i->iPercentIntra[0]);
+  if(iSize < 5)
+    return false;
 
-  return DetectPatternTwoFrames(v);
+  auto iNumZeros = Frame(iLast).iNumZeros - Frame(iFirst).iNumZeros;
+  auto iNumRunEnds = Frame(iLast).iNumRunEnds - Frame(iFirst + 1).iNumRunEnds;
+  auto iNumLongRunEnds = Frame(iLast).iNumLongRunEnds - Frame(iFirst + 2).iNumLongRunEnds;
+
+  return iNumRunEnds > 0 && iNumLongRunEnds == 0 && iNumZeros >= (iSize - 1) / 2;
 }
 
 /***************************************************************************/
@@ -423,13 +727,52 @@ LookAheadMngr::~LookAheadMngr(void)
 }
 
 /***************************************************************************/
-bool LookAheadMngr::ComputeSceneChange(AL_TBuffer* pPrevSrc, AL_TBuffer* pCurrentSrc)
+void LookAheadMngr::Push(AL_TBuffer* pSrc)
 {
-  if(!pPrevSrc || !pCurrentSrc)
-    return false;
+  FifoFrame tFrame;
+  tFrame.pMeta = reinterpret_cast<AL_TLookAheadMetaData*>(AL_Buffer_GetMetaData(pSrc, AL_META_TYPE_LOOKAHEAD));
+  tFrame.iPictureSize = tFrame.pMeta ? tFrame.pMeta->iPictureSize : 0;
+
+  if(!tFrames.empty() && ComputeSceneChange(tFrames.back().pMeta, tFrame.pMeta))
+    tSceneChanges.push_back(iNumPushed - 1);
 
-  auto pPreviousMeta = reinterpret_cast<AL_TLookAheadMetaData*>(AL_Buffer_GetMetaData(pPrevSrc, AL_META_TYPE_LOOKAHEAD));
-  auto pCurrentMeta = reinterpret_cast<AL_TLookAheadMetaData*>(AL_Buffer_GetMetaData(pCurrentSrc, AL_META_TYPE_LOOKAHEAD));
+  m_fifo.push_back(pSrc);
+  tFrames.push_back(tFrame);
+  iNumPushed++;
+
+  iSumSize += tFrame.iPictureSize;
+
+  if(static_cast<int>(tFrames.size()) <= COMPLEXITY_HEAD_SIZE)
+    iSumHeadSize += tFrame.iPictureSize;
+}
+
+/***************************************************************************/
+AL_TBuffer* LookAheadMngr::Pop(void)
+{
+  auto pSrc = m_fifo.front();
+  auto iPictureSize = tFrames.front().iPictureSize;
+
+  m_fifo.pop_front();
+  tFrames.pop_front();
+  iNumPopped++;
+
+  if(!tSceneChanges.empty() && tSceneChanges.front() < iNumPopped)
+    tSceneChanges.pop_front();
+
+  iSumSize -= iPictureSize;
+  iSumHeadSize -= iPictureSize;
+
+  if(static_cast<int>(tFrames.size()) >= COMPLEXITY_HEAD_SIZE)
+    iSumHeadSize += tFrames[COMPLEXITY_HEAD_SIZE - 1].iPictureSize;
+
+  return pSrc;
+}
+
+/***************************************************************************/
+bool LookAheadMngr::ComputeSceneChange(AL_TLookAheadMetaData* pPreviousMeta, AL_TLookAheadMetaData* pCurrentMeta)
+{
+  if(!pPreviousMeta || !pCurrentMeta)
+    return false;
 
   if(bEnableFirstPassSceneChangeDetection)
     return SceneChangeDetected_Crop(pPreviousMeta, pCurrentMeta);
@@ -438,12 +781,8 @@ bool LookAheadMngr::ComputeSceneChange(AL_TBuffer* pPrevSrc, AL_TBuffer* pCurren
 }
 
 /***************************************************************************/
-bool LookAheadMngr::ComputeSceneChange_LA1(AL_TBuffer* pCurrentSrc)
+bool LookAheadMngr::ComputeSceneChange_LA1(AL_TLookAheadMetaData* pCurrentMeta)
 {
-  if(!pCurrentSrc)
-    return false;
-
-  auto pCurrentMeta = reinterpret_cast<AL_TLookAheadMetaData*>(AL_Buffer_GetMetaData(pCurrentSrc, AL_META_TYPE_LOOKAHEAD));
   bool bDetected = false;
 
   if(bEnableFirstPassSceneChangeDetection)
@@ -455,27 +794,14 @@ bool LookAheadMngr::ComputeSceneChange_LA1(AL_TBuffer* pCurrentSrc)
   return bDetected;
 }
 
-/***************************************************************************/
-int32_t LookAheadMngr::ComputeIPRatio(AL_TBuffer* pCurrentSrc, AL_TBuffer* pNextSrc)
-{
-  auto pCurrentMeta = reinterpret_cast<AL_TLookAheadMetaData*>(AL_Buffer_GetMetaData(pCurrentSrc, AL_META_TYPE_LOOKAHEAD));
-  auto pNextMeta = reinterpret_cast<AL_TLookAheadMetaData*>(AL_Buffer_GetMetaData(pNextSrc, AL_META_TYPE_LOOKAHEAD));
-
-  return GetIPRatio(pCurrentMeta, pNextMeta);
-}
-
 /***************************************************************************/
 int LookAheadMngr::GetNextSceneChange(void)
 {
   int iFifoSize = static_cast<int>(m_fifo.size());
-  int iIndex = 0;
 
-  while((iIndex + 1 < iFifoSize) && !ComputeSceneChange(m_fifo[iIndex], m_fifo[iIndex + 1]))
-    iIndex++;
-
-  if(iFifoSize < 2 || iIndex + 1 == iFifoSize)
+  if(iFifoSize < 2 || tSceneChanges.empty())
     return iFifoSize;
-  return iIndex + 1;
+  return tSceneChanges.front() - iNumPopped + 1;
 }
 
 /***************************************************************************/
@@ -486,14 +812,14 @@ void LookAheadMngr::ProcessLookAheadParams(void)
   if(iFifoSize <= 0)
     throw runtime_error("iFifoSize(" + to_string(iFifoSize) + ") must be higher than 0");
 
-  auto pPictureMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(m_fifo[0], AL_META_TYPE_LOOKAHEAD);
+  auto pPictureMetaLA = tFrames[0].pMeta;
 
   if(!pPictureMetaLA)
     return;
 
   if(uLookAheadSize == 1)
   {
-    pPictureMetaLA->eSceneChange = ComputeSceneChange_LA1(m_fifo[0]) ? AL_SC_CURRENT : AL_SC_NONE;
+    pPictureMetaLA->eSceneChange = ComputeSceneChange_LA1(pPictureMetaLA) ? AL_SC_CURRENT : AL_SC_NONE;
     pPictureMetaLA->iPictureSize = 0;
     return;
   }
@@ -507,7 +833,8 @@ void LookAheadMngr::ProcessLookAheadParams(void)
   if(iFifoSize < 2)
     return;
 
-  pPictureMetaLA->eSceneChange = ComputeSceneChange(m_fifo[0], m_fifo[1]) ? AL_SC_NEXT : AL_SC_NONE;
+  int iNextSceneChange = GetNextSceneChange();
+  pPictureMetaLA->eSceneChange = iNextSceneChange == 1 ? AL_SC_NEXT : AL_SC_NONE;
 
   if(bEnableFirstPassSceneChangeDetection)
   {
@@ -515,11 +842,10 @@ void LookAheadMngr::ProcessLookAheadParams(void)
     return;
   }
 
-  pPictureMetaLA->iIPRatio = ComputeIPRatio(m_fifo[0], m_fifo[1]);
-  int iNextSceneChange = GetNextSceneChange();
+  pPictureMetaLA->iIPRatio = GetIPRatio(pPictureMetaLA, tFrames[1].pMeta);
 
   for(int i = 2; i < min(iNextSceneChange, 4); i++)
-    pPictureMetaLA->iIPRatio = min(pPictureMetaLA->iIPRatio, ComputeIPRatio(m_fifo[0], m_fifo[i]));
+    pPictureMetaLA->iIPRatio = min(pPictureMetaLA->iIPRatio, GetIPRatio(pPictureMetaLA, tFrames[i].pMeta));
 }
 
 /***************************************************************************/
@@ -532,17 +858,9 @@ void LookAheadMngr::ComputeComplexity(void)
     iFrameCount = 0;
     iComplexity = 1000;
 
-    if(iFifoSize >= 5 && AL_Buffer_GetMetaData(m_fifo.front(), AL_META_TYPE_LOOKAHEAD))
+    if(iFifoSize >= COMPLEXITY_HEAD_SIZE && tFrames.front().pMeta)
     {
-      intmax_t iComp[2] = { 0, 0 };
-
-      for(int i = 0; i < iFifoSize; i++)
-      {
-        auto pPictureMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(m_fifo[i], AL_META_TYPE_LOOKAHEAD);
-        iComp[(i < 5) ? 0 : 1] += pPictureMetaLA->iPictureSize;
-      }
-
-      iComplexity = ((1000 * iFifoSize / 5) + iComplexityDiff) * iComp[0] / (iComp[0] + iComp[1]);
+      iComplexity = ((1000 * iFifoSize / COMPLEXITY_HEAD_SIZE) + iComplexityDiff) * iSumHeadSize / iSumSize;
       iComplexity = min(3000, max(100, iComplexity));
       iComplexityDiff += (1000 - iComplexity);
     }
@@ -550,7 +868,7 @@ void LookAheadMngr::ComputeComplexity(void)
 
   iFrameCount++;
 
-  if(iFifoSize >= 2 && ComputeSceneChange(m_fifo[0], m_fifo[1]))
+  if(iFifoSize >= 2 && GetNextSceneChange() == 1)
     iFrameCount = 0;
 }
 
@@ -559,11 +877,8 @@ bool LookAheadMngr::HasPatternTwoFrames(void)
 {
   vector<int> v {};
 
-  for(auto i = m_fifo.begin(); i < m_fifo.end(); i++)
-  {
-    auto pPictureMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(*i, AL_META_TYPE_LOOKAHEAD);
-    v.push_back(pPictureMetaLA->iPercentIntra[0]);
-  }
+  for(auto const& tFrame : tFrames)
+    v.push_back(tFrame.pMeta->iPercentIntra[0]);
 
   return DetectPatternTwoFrames(v);
 }
@@ -4,10 +4,13 @@
 #pragma once
 
 #include <fstream>
+#include <string>
 #include <vector>
 #include <cstring>
+#include <atomic>
 #include <deque>
 #include <memory>
+#include <mutex>
 
 extern "C"
 {
@@ -19,7 +22,31 @@ extern "C"
 bool AL_TwoPassMngr_HasLookAhead(AL_TEncSettings const& settings);
 void AL_TwoPassMngr_SetPass1Settings(AL_TEncSettings& settings);
 void AL_TwoPassMngr_SetGlobalSettings(AL_TEncSettings& settings);
-AL_TLookAheadMetaData* AL_TwoPassMngr_CreateAndAttachTwoPassMetaData(AL_TBuffer* Src);
+
+/*
+** Pool of the TwoPass / LookAhead metadata of the src buffers
+** The metadata goes back to the pool when its src buffer is destroyed,
+** so the frames do not allocate metadata once the pool covers the frames in flight
+*/
+struct LookAheadMetaDataPool : std::enable_shared_from_this<LookAheadMetaDataPool>
+{
+  LookAheadMetaDataPool(int p_iSize);
+  ~LookAheadMetaDataPool();
+
+  AL_TLookAheadMetaData* CreateAndAttach(AL_TBuffer* Src);
+  uint64_t GetNumAllocations() const;
+
+private:
+  struct PooledMetaData;
+
+  PooledMetaData* Allocate();
+  static bool DestroyMetaData(AL_TMetaData* pMeta);
+  static AL_TMetaData* CloneMetaData(AL_TMetaData* pMeta);
+
+  std::mutex tMutex;
+  std::vector<PooledMetaData*> tFreeMetaData;
+  std::atomic<uint64_t> uNumAllocations {};
+};
 
 /***************************************************************************/
 /*Offline TwoPass structures and methods*/
@@ -29,6 +56,11 @@ AL_TLookAheadMetaData* AL_TwoPassMngr_CreateAndAttachTwoPassMetaData(AL_TBuffer*
 ** Struct for TwoPass management
 ** Writes First Pass information on the logfile
 ** Reads and computes the logfile for the Second Pass
+** The logfile is written as fixed size binary records, or as text when its
+** name ends with ".txt", see two_pass_log.h. The format is detected when reading it back
+** The Second Pass streams the logfile through a sliding window of frames,
+** so the complexity stays continuous over sequences of any length. A logfile
+** of at most one window is computed as a single sequence
 */
 struct TwoPassMngr
 {
@@ -43,21 +75,82 @@ struct TwoPassMngr
   bool bEnableFirstPassSceneChangeDetection;
 
 private:
+  /* A frame of the window, with the counts of the two frames pattern detection since the first frame */
+  struct WindowFrame
+  {
+    AL_TLookAheadMetaData tMeta;
+    int iNumZeros;
+    int iNumRunEnds;
+    int iNumLongRunEnds;
+  };
+
+  /* A gop of the window, the level is the one simulated from the first frame */
+  struct WindowGop
+  {
+    int iStart;
+    int iLength;
+    size_t uSumComp;
+    int iComplexity;
+    int iDeviation;
+    int64_t iLevel;
+  };
+
   void OpenLog();
   void CloseLog();
-  void EmptyLog();
+  bool ReadRecord(int& iPictureSize, int& iPercentIntra);
+  bool ReadTextRecord(int& iPictureSize, int& iPercentIntra);
+  bool ReadBinaryRecord(int& iPictureSize, int& iPercentIntra);
   void FillLog();
-  void AddNewFrame(int iPictureSize, int iPercentIntra);
-  void ComputeTwoPass();
-  void ComputeComplexity();
-  bool HasPatternTwoFrames();
+  WindowFrame& Frame(int iFrame);
+  WindowGop& Gop(int iGop);
+  bool IsWindowSizeKnown();
+  int GetHalfWindowSize();
+  void PushFrame(int iPictureSize, int iPercentIntra);
+  void TrimWindow();
+  bool IsFrameReady(int iFrame);
+  void UpdateWindow();
+  void UpdateIPRatio(int iFrame);
+  void UpdateGops();
+  void CloseGop();
+  bool IsGopWindowComplete(int iWindowEnd, int iNumDoneGops);
+  void ComputeGopDeviations();
+  void ComputeGopTargets();
+  bool HasPatternTwoFrames(int iFrame);
 
   std::string FileName;
   std::vector<AL_TLookAheadMetaData> tFrames;
   std::ofstream outputFile;
   std::ifstream inputFile;
+  bool bBinaryLog;
+  uint8_t* pMappedLog = nullptr;
+  size_t zMappedLogSize = 0;
+  size_t zMappedLogOffset = 0;
   int iCurrentFrame = 0;
 
+  std::deque<WindowFrame> tWindow;
+  std::deque<WindowGop> tGops;
+  std::deque<int> tLevelMaxGops;
+  std::deque<int> tLevelMinGops;
+  WindowGop tOpenGop {};
+  bool bEndOfLog = false;
+  bool bWholeSequence = false; // the logfile fits in a window, its frames all see each other
+  int iNumFrames = 0;
+  int iWindowBase = 0;
+  int iNextSceneChange = 0;
+  int iNextIPRatio = 0;
+  int iNextGopFrame = 0;
+  int iNumGops = 0;
+  int iGopBase = 0;
+  int iNextMeanGop = 0;
+  int iMeanLo = 0;
+  int iMeanHi = 0;
+  size_t uMeanSumComp = 0;
+  int iNextCoeffGop = 0;
+  int iCoeffLo = 0;
+  int iCoeffHi = 0;
+  int iNumComputedFrames = 0;
+  int iLevel;
+
   int iGopSize;
   int iCpbLevel;
   int iInitialLevel;
@@ -72,6 +165,8 @@ private:
 ** Struct for LookAhead management
 ** Keeps the src buffers between the two pass
 ** Compute lookahead metadata to improve second pass quality
+** The scene changes and the picture sizes of the src buffers are kept
+** when they enter the fifo, so processing a frame does not rescan the fifo
 */
 struct LookAheadMngr
 {
@@ -81,19 +176,34 @@ struct LookAheadMngr
   uint16_t uLookAheadSize;
   bool bUseComplexity;
   bool bEnableFirstPassSceneChangeDetection;
-  std::deque<AL_TBuffer*> m_fifo;
+  std::deque<AL_TBuffer*> m_fifo; // only modified through Push and Pop
 
+  void Push(AL_TBuffer* pSrc);
+  AL_TBuffer* Pop();
   void ProcessLookAheadParams();
   void ComputeComplexity();
   bool HasPatternTwoFrames();
-  bool ComputeSceneChange(AL_TBuffer* pPrevSrc, AL_TBuffer* pCurrentSrc);
-  bool ComputeSceneChange_LA1(AL_TBuffer* pCurrentSrc);
-  int32_t ComputeIPRatio(AL_TBuffer* pCurrentSrc, AL_TBuffer* pNextSrc);
+  bool ComputeSceneChange(AL_TLookAheadMetaData* pPreviousMeta, AL_TLookAheadMetaData* pCurrentMeta);
+  bool ComputeSceneChange_LA1(AL_TLookAheadMetaData* pCurrentMeta);
   int GetNextSceneChange();
 
 private:
+  /* A src buffer of the fifo, as it was when it entered it */
+  struct FifoFrame
+  {
+    AL_TLookAheadMetaData* pMeta;
+    int32_t iPictureSize;
+  };
+
   int iComplexity;
   int iFrameCount;
   int iComplexityDiff;
   AL_TLookAheadMetaData tPrevMetaData;
+
+  std::deque<FifoFrame> tFrames;
+  std::deque<int> tSceneChanges; // frames followed by a scene change, counted from the first pushed frame
+  int iNumPushed = 0;
+  int iNumPopped = 0;
+  intmax_t iSumHeadSize = 0; // of the first COMPLEXITY_HEAD_SIZE frames
+  intmax_t iSumSize = 0;
 };
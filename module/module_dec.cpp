@@ -915,5 +915,13 @@ ModuleInterface::ErrorType DecModule::GetDynamic(std::string index, void* param)
     return SUCCESS;
   }
 
+  if(index == "DYNAMIC_INDEX_CPU_TIME")
+  {
+    auto cpuTime = static_cast<ModuleCpuTime*>(param);
+    cpuTime->threads = 0;
+    cpuTime->callbacks = callbacksCpuTime;
+    return SUCCESS;
+  }
+
   return BAD_INDEX;
 }
@@ -7,11 +7,13 @@
 #include "module_enums.h"
 #include "settings_dec_interface.h"
 
+#include <atomic>
 #include <vector>
 #include <queue>
 #include <memory>
 
 #include <utility/threadsafe_map.h>
+#include <utility/thread_cpu_time.h>
 
 extern "C"
 {
@@ -56,6 +58,7 @@ private:
   ColourMatrixType currentColourMatrix;
   ColorPrimariesType currentColorPrimaries;
   HighDynamicRangeSeis currentHDRSEIs;
+  std::atomic<uint64_t> callbacksCpuTime {};
 
   Callbacks callbacks;
   ThreadSafeMap<AL_TBuffer*, BufferHandleInterface*> handles;
@@ -83,6 +86,7 @@ private:
   static void RedirectionEndParsing(AL_TBuffer* parsedFrame, void* userParam, int parsingID)
   {
     auto pThis = static_cast<DecModule*>(userParam);
+    ThreadCpuTimeScope scope { pThis->callbacksCpuTime };
     pThis->EndParsing(parsedFrame, parsingID);
   };
   void EndParsing(AL_TBuffer* parsedFrame, int parsingID);
@@ -90,6 +94,7 @@ private:
   static void RedirectionEndDecoding(AL_TBuffer* decodedFrame, void* userParam)
   {
     auto pThis = static_cast<DecModule*>(userParam);
+    ThreadCpuTimeScope scope { pThis->callbacksCpuTime };
     pThis->EndDecoding(decodedFrame);
   };
   void EndDecoding(AL_TBuffer* decodedFrame);
@@ -97,6 +102,7 @@ private:
   static void RedirectionDisplay(AL_TBuffer* frameToDisplay, AL_TInfoDecode* info, void* userParam)
   {
     auto pThis = static_cast<DecModule*>(userParam);
+    ThreadCpuTimeScope scope { pThis->callbacksCpuTime };
     pThis->Display(frameToDisplay, info);
   };
   void Display(AL_TBuffer* frameToDisplay, AL_TInfoDecode* info);
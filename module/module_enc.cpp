@@ -6,12 +6,15 @@
 #include "convert_module_soft_enc.h"
 #include "convert_module_soft.h"
 #include "ROIMngr.h"
+#include "stream_sections.h"
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 #include <future>
 #include <utility/logger.h>
 #include <utility/round.h>
+#include <utility/thread_pool.h>
 #include <string>
 
 extern "C"
@@ -32,6 +35,9 @@ extern "C"
 
 using namespace std;
 
+/* Frames the first pass can encode ahead of a full lookahead window */
+static int constexpr LOOKAHEAD_FIRST_PASS_DEPTH = 2;
+
 static ModuleInterface::ErrorType ToModuleError(int errorCode)
 {
   switch(errorCode)
@@ -69,6 +75,7 @@ EncModule::EncModule(shared_ptr<EncSettingsInterface> media, shared_ptr<EncDevic
   currentDimension = { -1, -1 };
   currentPictureType = AL_SLICE_MAX_ENUM;
   currentPictureIsSkipped = false;
+  roiCachedGeneration = 0;
 }
 
 EncModule::~EncModule()
@@ -104,6 +111,11 @@ static string ToStringEncodeError(AL_ERR error)
 
 void EncModule::InitEncoders(int numPass)
 {
+  {
+    unique_lock<std::mutex> lock(threadSchedulingMutex);
+    engines.clear();
+  }
+
   encoders.clear();
 
   for(int pass = 0; pass < numPass; pass++)
@@ -127,7 +139,15 @@ void EncModule::InitEncoders(int numPass)
       }
 
       auto p = bind(&EncModule::_ProcessEmptyFifo, this, placeholders::_1);
-      encoderPass.threadFifo.reset(new ProcessorFifo<EmptyFifoParam> { p, nullptr, "Engine - Enc" });
+      auto d = [this](EmptyFifoParam param) {
+                 if(param.source)
+                 {
+                   AL_Buffer_Unref(param.source);
+                   ++lookAheadProcessed;
+                 }
+               };
+      encoderPass.threadFifo.reset(new ProcessorFifo<EmptyFifoParam> { p, d, "Engine - Enc" });
+      AddEngine(*encoderPass.threadFifo);
     }
 
     encoders.push_back(encoderPass);
@@ -186,6 +206,7 @@ ModuleInterface::ErrorType EncModule::CreateEncoder()
     LOG_ERROR("Failed to create ROI manager");
     return BAD_PARAMETER;
   }
+  roiCachedQPs.clear();
 
   auto scheduler = device->Init();
   auto numPass = 1;
@@ -239,9 +260,23 @@ ModuleInterface::ErrorType EncModule::CreateEncoder()
     }
   }
 
+  memcpy(&channelSettings, &media->settings, sizeof(channelSettings));
   encoders.front().nextQPBuffer = nextQPBuffer;
   nextQPBuffer = nullptr;
 
+  if(encoders.front().lookAheadMngr)
+    atomic_store(&lookAheadSlots, make_shared<semaphore>(static_cast<unsigned long long>(encoders.front().lookAheadMngr->uLookAheadSize + LOOKAHEAD_FIRST_PASS_DEPTH)));
+
+  // Sized for the frames between the passes, it grows if the encoder keeps more sources
+  if(encoders.front().lookAheadMngr)
+    lookAheadMetaDataPool.reset(new LookAheadMetaDataPool { encoders.front().lookAheadMngr->uLookAheadSize + LOOKAHEAD_FIRST_PASS_DEPTH });
+  else if(twoPassMngr->iPass)
+    lookAheadMetaDataPool.reset(new LookAheadMetaDataPool { LOOKAHEAD_FIRST_PASS_DEPTH });
+
+  // The first input of the new stream is always encoded
+  staticFrameDetector.Reset();
+  consecutiveSkips = 0;
+
   return SUCCESS;
 }
 
@@ -272,6 +307,19 @@ bool EncModule::DestroyEncoder()
     sem.reset();
   }
 
+  {
+    unique_lock<std::mutex> lock(threadSchedulingMutex);
+    engines.clear();
+    appliedThreadScheduling = ThreadScheduling {};
+  }
+
+  // The input may wait for a slot that the destroyed lookahead would never return
+  auto slots = atomic_exchange(&lookAheadSlots, shared_ptr<semaphore> {});
+
+  if(slots)
+    slots->notify();
+
+  isChannelPrepared = false;
   initialDimension = { -1, -1 };
   currentDimension = { -1, -1 };
   currentPictureType = AL_SLICE_MAX_ENUM;
@@ -279,10 +327,13 @@ bool EncModule::DestroyEncoder()
 
   for(int pass = 0; pass < (int)encoders.size(); pass++)
   {
-    GenericEncoder encoder = encoders[pass];
+    GenericEncoder& encoder = encoders[pass];
 
     AL_Encoder_Destroy(encoder.enc);
 
+    // The engine thread feeds the next pass, it is stopped before the next pass is destroyed
+    encoder.threadFifo.reset();
+
     if(encoder.nextQPBuffer != nullptr)
     {
       AL_Buffer_Unref(encoder.nextQPBuffer);
@@ -291,11 +342,13 @@ bool EncModule::DestroyEncoder()
 
     while(encoder.lookAheadMngr && !encoder.lookAheadMngr->m_fifo.empty())
     {
-      auto src = encoder.lookAheadMngr->m_fifo.front();
-      encoder.lookAheadMngr->m_fifo.pop_front();
+      auto src = encoder.lookAheadMngr->Pop();
       AL_Buffer_Unref(src);
+      ++lookAheadProcessed;
     }
 
+    encoder.lookAheadArrivals.clear();
+
     for(int i = 0; i < (int)encoder.streamBuffers.size(); i++)
     {
       if(encoder.streamBuffers[i])
@@ -304,6 +357,7 @@ bool EncModule::DestroyEncoder()
   }
 
   encoders.clear();
+  lookAheadMetaDataPool.reset();
 
   device->Deinit();
 
@@ -317,8 +371,26 @@ bool EncModule::DestroyEncoder()
   return true;
 }
 
+/* Byte compare: a false difference in the padding only costs a new channel */
+static bool IsSameSettings(AL_TEncSettings const& settings, AL_TEncSettings const& other)
+{
+  return memcmp(&settings, &other, sizeof(settings)) == 0;
+}
+
 ModuleInterface::ErrorType EncModule::Start(bool)
 {
+  if(isChannelPrepared)
+  {
+    if(IsSameSettings(channelSettings, media->settings))
+    {
+      isChannelPrepared = false;
+      return SUCCESS;
+    }
+
+    LOG_IMPORTANT("The settings changed since the channel was prepared");
+    DestroyEncoder();
+  }
+
   if(encoders.size())
   {
     LOG_ERROR("You can't call Start twice");
@@ -359,6 +431,73 @@ ModuleInterface::ErrorType EncModule::Restart()
   return CreateEncoder();
 }
 
+/* The running channel absorbs a resolution up to the one it was created with, the gop length and
+ * number of b frames, the framerate and the bitrate. Any other change of the settings, or an
+ * encoder with a lookahead or two passes sized at its creation, needs a new channel */
+ModuleInterface::ErrorType EncModule::Reconfigure()
+{
+  if(encoders.size() != 1 || twoPassMngr->iPass)
+    return NOT_IMPLEMENTED;
+
+  auto const& next = media->settings.tChParam[0];
+
+  if(next.uEncWidth > initialDimension.horizontal || next.uEncHeight > initialDimension.vertical)
+    return NOT_IMPLEMENTED;
+
+  AL_TEncSettings absorbed;
+  memcpy(&absorbed, &channelSettings, sizeof(absorbed));
+  auto& channel = absorbed.tChParam[0];
+  channel.uEncWidth = next.uEncWidth;
+  channel.uEncHeight = next.uEncHeight;
+  channel.uSrcWidth = next.uSrcWidth;
+  channel.uSrcHeight = next.uSrcHeight;
+  channel.tGopParam.uGopLength = next.tGopParam.uGopLength;
+  channel.tGopParam.uNumB = next.tGopParam.uNumB;
+  channel.tRCParam.uFrameRate = next.tRCParam.uFrameRate;
+  channel.tRCParam.uClkRatio = next.tRCParam.uClkRatio;
+  channel.tRCParam.uTargetBitRate = next.tRCParam.uTargetBitRate;
+
+  // Only the variable bitrate has a maximum of its own
+  if(next.tRCParam.eRCMode != AL_RC_VBR)
+    channel.tRCParam.uMaxBitRate = next.tRCParam.uMaxBitRate;
+
+  if(!IsSameSettings(absorbed, media->settings))
+    return NOT_IMPLEMENTED;
+
+  auto encoder = encoders.front().enc;
+  auto& current = channelSettings.tChParam[0];
+
+  // The resolution goes first: the channel is left as is when it is refused
+  if(next.uEncWidth != current.uEncWidth || next.uEncHeight != current.uEncHeight)
+  {
+    AL_TDimension dimension {
+      next.uEncWidth, next.uEncHeight
+    };
+
+    if(!AL_Encoder_SetInputResolution(encoder, dimension))
+      return NOT_IMPLEMENTED;
+  }
+
+  // A refused value leaves the channel half reconfigured: the caller creates a new one
+  if(next.tRCParam.uFrameRate != current.tRCParam.uFrameRate || next.tRCParam.uClkRatio != current.tRCParam.uClkRatio)
+  {
+    if(!AL_Encoder_SetFrameRate(encoder, next.tRCParam.uFrameRate, next.tRCParam.uClkRatio))
+      return NOT_IMPLEMENTED;
+  }
+
+  if(next.tRCParam.uTargetBitRate != current.tRCParam.uTargetBitRate && !AL_Encoder_SetBitRate(encoder, next.tRCParam.uTargetBitRate))
+    return NOT_IMPLEMENTED;
+
+  if(next.tGopParam.uNumB != current.tGopParam.uNumB && !AL_Encoder_SetGopNumB(encoder, next.tGopParam.uNumB))
+    return NOT_IMPLEMENTED;
+
+  if(next.tGopParam.uGopLength != current.tGopParam.uGopLength && !AL_Encoder_SetGopLength(encoder, next.tGopParam.uGopLength))
+    return NOT_IMPLEMENTED;
+
+  memcpy(&channelSettings, &media->settings, sizeof(channelSettings));
+  return SUCCESS;
+}
+
 static void StubCallbackEvent(Callbacks::Event, void*)
 {
 }
@@ -622,12 +761,39 @@ bool EncModule::Empty(BufferHandleInterface* handle)
   else
     UpdatePixMapMetaResolution(media, (AL_TPixMapMetaData*)meta);
 
+  if(shouldBeCopied.Exist(input))
+  {
+    auto buffer = shouldBeCopied.Get(input);
+    copy(buffer, buffer + input->zSizes[0], AL_Buffer_GetData(input));
+  }
+
+  if(IsStaticFrame(input, handle->payload))
+  {
+    // The qp table given with the input goes with it
+    if(currentEnc.nextQPBuffer)
+    {
+      AL_Buffer_Unref(currentEnc.nextQPBuffer);
+      currentEnc.nextQPBuffer = nullptr;
+    }
+
+    if(isFd(bufferHandles.input))
+      UnuseDMA(handle);
+
+    if(isCharPtr(bufferHandles.input))
+      Unuse(handle);
+
+    handle->offset = 0;
+    handle->payload = 0;
+    callbacks.emptied(handle);
+    return true;
+  }
+
   if(encoders.size() > 1)
-    AL_TwoPassMngr_CreateAndAttachTwoPassMetaData(input);
+    lookAheadMetaDataPool->CreateAndAttach(input);
 
   if(twoPassMngr->iPass)
   {
-    auto pPictureMetaTP = AL_TwoPassMngr_CreateAndAttachTwoPassMetaData(input);
+    auto pPictureMetaTP = lookAheadMetaDataPool->CreateAndAttach(input);
 
     if(twoPassMngr->iPass == 2)
       twoPassMngr->GetFrame(pPictureMetaTP);
@@ -635,17 +801,40 @@ bool EncModule::Empty(BufferHandleInterface* handle)
 
   handles.Add(input, handle);
 
-  if(shouldBeCopied.Exist(input))
+  // The lookahead already detects the scene changes with its first pass
+  if(isSceneChangeAnalysisEnabled && encoders.size() == 1)
+    AnalyzeSceneChange(input, encoder);
+  else
+    sceneChangeAnalyzer.Reset();
+
+  // Back-pressure: the input waits while the lookahead is full
+  auto slots = atomic_load(&lookAheadSlots);
+
+  if(slots && !WaitLookAheadSlot(slots))
   {
-    auto buffer = shouldBeCopied.Get(input);
-    copy(buffer, buffer + input->zSizes[0], AL_Buffer_GetData(input));
-  }
+    // The encoder was destroyed meanwhile, the input goes back unencoded
+    handles.Remove(input);
 
-  if(currentEnc.nextQPBuffer == nullptr)
-    return AL_Encoder_Process(encoder, input, nullptr);
+    if(isFd(bufferHandles.input))
+      UnuseDMA(handle);
+
+    if(isCharPtr(bufferHandles.input))
+      Unuse(handle);
+
+    handle->offset = 0;
+    handle->payload = 0;
+    callbacks.emptied(handle);
+    return true;
+  }
 
   auto success = AL_Encoder_Process(encoder, input, currentEnc.nextQPBuffer);
 
+  if(!success && slots)
+    slots->notify();
+
+  if(currentEnc.nextQPBuffer == nullptr)
+    return success;
+
   if(currentEnc.index != encoders.back().index)
     encoders[currentEnc.index + 1].nextQPBuffer = currentEnc.nextQPBuffer;
   else
@@ -753,91 +942,6 @@ bool EncModule::Fill(BufferHandleInterface* handle)
   return true;
 }
 
-static int WriteFillerDataSection(shared_ptr<MemoryInterface> memory, AL_TBuffer* source, AL_TBuffer* destination, int offset, int numSection)
-{
-  auto meta = reinterpret_cast<AL_TStreamMetaData*>(AL_Buffer_GetMetaData(source, AL_META_TYPE_STREAM));
-  auto& section = meta->pSections[numSection];
-
-  auto src = AL_Buffer_GetData(source);
-  auto dst = AL_Buffer_GetData(destination);
-  auto srcOffset = section.uOffset;
-  auto dstOffset = offset;
-  auto length = section.uLength;
-
-  while(--length && (src[srcOffset] != 0xFF))
-  {
-    dst[dstOffset++] = src[srcOffset++];
-  }
-
-  if(length > 0)
-    memory->set(destination, dstOffset, 0xFF, length);
-
-  assert(src[srcOffset + length] == 0x80);
-  dst[dstOffset + length] = src[srcOffset + length];
-
-  return section.uLength;
-}
-
-static int WriteOneSection(shared_ptr<MemoryInterface> memory, AL_TBuffer* source, AL_TBuffer* destination, int offset, int numSection)
-{
-  auto meta = reinterpret_cast<AL_TStreamMetaData*>(AL_Buffer_GetMetaData(source, AL_META_TYPE_STREAM));
-  auto& section = meta->pSections[numSection];
-
-  if(!section.uLength)
-    return 0;
-
-  auto size = source->zSizes[0] - section.uOffset;
-
-  if(size < section.uLength)
-  {
-    memory->move(destination, offset, source, section.uOffset, size);
-    memory->move(destination, offset, source, 0, section.uLength - size);
-  }
-  else
-    memory->move(destination, offset, source, section.uOffset, section.uLength);
-
-  return section.uLength;
-}
-
-static int ConstructConfigStream(shared_ptr<MemoryInterface> memory, AL_TBuffer* config, AL_TBuffer* stream, int& firstSection)
-{
-  auto size = 0;
-  auto meta = (AL_TStreamMetaData*)(AL_Buffer_GetMetaData(stream, AL_META_TYPE_STREAM));
-  assert(meta);
-
-  assert(firstSection <= meta->uNumSection);
-
-  while(((meta->pSections[firstSection].eFlags & AL_SECTION_CONFIG_FLAG) != 0) && (firstSection < meta->uNumSection))
-  {
-    if(meta->pSections[firstSection].eFlags & AL_SECTION_APP_FILLER_FLAG)
-      size += WriteFillerDataSection(memory, stream, config, size, firstSection);
-    else
-      size += WriteOneSection(memory, stream, config, size, firstSection);
-    firstSection++;
-  }
-
-  return size;
-}
-
-static int ReconstructStream(shared_ptr<MemoryInterface> memory, AL_TBuffer* stream, int firstSection)
-{
-  auto size = 0;
-  auto meta = (AL_TStreamMetaData*)(AL_Buffer_GetMetaData(stream, AL_META_TYPE_STREAM));
-  assert(meta);
-
-  assert(firstSection <= meta->uNumSection);
-
-  for(int i = firstSection; i < meta->uNumSection; i++)
-  {
-    if(meta->pSections[i].eFlags & AL_SECTION_APP_FILLER_FLAG)
-      size += WriteFillerDataSection(memory, stream, stream, size, i);
-    else
-      size += WriteOneSection(memory, stream, stream, size, i);
-  }
-
-  return size;
-}
-
 void EncModule::ReleaseBuf(AL_TBuffer const* buf, bool isDma, bool isSrc)
 {
   auto rhandle = handles.Pop(buf);
@@ -1120,32 +1224,46 @@ void EncModule::AddFifo(GenericEncoder& encoder, AL_TBuffer* src)
   if(!isEOS)
   {
     AL_Buffer_Ref(src);
-    encoder.lookAheadMngr->m_fifo.push_back(src);
+    auto depth = ++lookAheadQueued - lookAheadProcessed;
+    auto maxDepth = lookAheadMaxDepth.load();
+
+    while(depth > maxDepth && !lookAheadMaxDepth.compare_exchange_weak(maxDepth, depth))
+      ;
   }
   EmptyFifoParam param;
   param.encoder = &encoder;
+  param.source = src;
   param.isEOS = isEOS;
+  param.queuedAt = chrono::steady_clock::now();
   encoder.threadFifo->queue(param);
 }
 
-void EncModule::EmptyFifo(GenericEncoder& encoder, bool isEOS)
+/* Only the engine thread of the encoder touches its lookahead window */
+void EncModule::EmptyFifo(GenericEncoder& encoder, AL_TBuffer* src, bool isEOS, chrono::steady_clock::time_point queuedAt)
 {
   assert(encoder.index < (int)encoders.size() - 1);
 
-  GenericEncoder nextEnc = encoders[encoder.index + 1];
-
-  if(isEOS && encoder.lookAheadMngr->m_fifo.size() == 0)
+  if(!isEOS)
   {
-    AL_Encoder_Process(nextEnc.enc, nullptr, nullptr);
-    return;
+    encoder.lookAheadMngr->Push(src);
+    encoder.lookAheadArrivals.push_back(queuedAt);
   }
 
-  if(!(isEOS || (int)encoder.lookAheadMngr->m_fifo.size() == encoder.lookAheadMngr->uLookAheadSize))
-    return;
+  while(!encoder.lookAheadMngr->m_fifo.empty() && (isEOS || (int)encoder.lookAheadMngr->m_fifo.size() >= encoder.lookAheadMngr->uLookAheadSize))
+    ProcessLookAhead(encoder);
+
+  if(isEOS)
+    AL_Encoder_Process(encoders[encoder.index + 1].enc, nullptr, nullptr);
+}
+
+void EncModule::ProcessLookAhead(GenericEncoder& encoder)
+{
+  GenericEncoder& nextEnc = encoders[encoder.index + 1];
 
   encoder.lookAheadMngr->ProcessLookAheadParams();
-  auto src = encoder.lookAheadMngr->m_fifo.front();
-  encoder.lookAheadMngr->m_fifo.pop_front();
+  auto src = encoder.lookAheadMngr->Pop();
+  auto queuedAt = encoder.lookAheadArrivals.front();
+  encoder.lookAheadArrivals.pop_front();
 
   AL_TBuffer* qpBuffer = nextEnc.nextQPBuffer;
 
@@ -1164,24 +1282,125 @@ void EncModule::EmptyFifo(GenericEncoder& encoder, bool isEOS)
 
   AL_Buffer_Unref(src);
 
-  if(isEOS)
-    EmptyFifo(encoder, isEOS);
+  lookAheadWaitTime += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - queuedAt).count();
+  ++lookAheadProcessed;
+
+  auto slots = atomic_load(&lookAheadSlots);
+
+  if(encoder.index == 0 && slots)
+    slots->notify();
+}
+
+/* Returns false when the encoder was destroyed while waiting */
+bool EncModule::WaitLookAheadSlot(shared_ptr<semaphore> const& slots)
+{
+  if(!slots->try_wait())
+  {
+    auto start = chrono::steady_clock::now();
+    {
+      // The slot is freed by the other processors of the pool
+      ThreadPool::BlockingScope blocking {};
+      slots->wait();
+    }
+    ++lookAheadBlocked;
+    lookAheadBlockedTime += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+  }
+
+  return slots == atomic_load(&lookAheadSlots);
+}
+
+/* Notifies the scene change before the input is given to the encoder, so it applies to this input */
+void EncModule::AnalyzeSceneChange(AL_TBuffer* input, AL_HEncoder encoder)
+{
+  Format format;
+  media->Get(SETTINGS_INDEX_FORMAT, &format);
+  Resolution resolution;
+  media->Get(SETTINGS_INDEX_RESOLUTION, &resolution);
+
+  auto isTiled = format.storage != StorageType::STORAGE_RASTER;
+
+  // The samples of the tiled 10 bits storages are packed
+  if(isTiled && format.bitdepth > 8)
+    return;
+
+  // The luma plane is first, a line of tiles holds 4 lines of the picture
+  LumaPlane plane {};
+  plane.data = AL_Buffer_GetData(input);
+  plane.bytesPerSample = format.bitdepth > 8 ? 2 : 1;
+  plane.shift = format.bitdepth - 8;
+  plane.rowSize = resolution.dimension.horizontal * plane.bytesPerSample * (isTiled ? 4 : 1);
+  plane.rows = isTiled ? resolution.dimension.vertical / 4 : resolution.dimension.vertical;
+  plane.pitch = resolution.stride.horizontal;
+
+  if(!sceneChangeAnalyzer.Analyze(plane))
+    return;
+
+  AL_Encoder_NotifySceneChange(encoder, 0);
+  ++detectedSceneChanges;
+}
+
+/* The previous picture stays displayed in place of an input identical to it */
+bool EncModule::IsStaticFrame(AL_TBuffer* input, int size)
+{
+  // The second pass reads the first pass statistics of every input
+  if(!isStaticFrameSkipEnabled || twoPassMngr->iPass)
+  {
+    staticFrameDetector.Reset();
+    consecutiveSkips = 0;
+    return false;
+  }
+
+  if(!staticFrameDetector.IsUnchanged(AL_Buffer_GetData(input), size) || (maxConsecutiveSkips && consecutiveSkips >= maxConsecutiveSkips))
+  {
+    consecutiveSkips = 0;
+    return false;
+  }
+
+  ++consecutiveSkips;
+  ++skippedStaticFrames;
+  return true;
+}
+
+int EncModule::GetQPTableSize()
+{
+  Resolution resolution {};
+  auto ret = media->Get(SETTINGS_INDEX_RESOLUTION, &resolution);
+  assert(ret == SettingsInterface::SUCCESS);
+  AL_TDimension tDim {
+    resolution.dimension.horizontal, resolution.dimension.vertical
+  };
+  MinMax<int> log2CodingUnit {};
+  ret = media->Get(SETTINGS_INDEX_LOG2_CODING_UNIT, &log2CodingUnit);
+  assert(ret == SettingsInterface::SUCCESS);
+  return AL_GetAllocSizeEP2(tDim, static_cast<AL_ECodec>(AL_GET_CODEC(media->settings.tChParam[0].eProfile)), log2CodingUnit.max);
+}
+
+/* ROIs are rarely updated compared to the framerate: while the ROI manager
+ * stays at the same generation, the last computed table is copied as is.
+ * The table is computed in host memory as the ROI buffer can be device memory,
+ * which is slow to read back */
+void EncModule::FillROIQPTable(uint8_t* qpTable)
+{
+  auto size = GetQPTableSize();
+  unique_lock<std::mutex> lock(roiMutex);
+
+  if(roiCachedQPs.empty() || roiCachedGeneration != roiCtx->uGeneration || (int)roiCachedQPs.size() != size)
+  {
+    auto const iLcuQpOffset = 0;
+    roiCachedQPs.assign(size, 0);
+    AL_RoiMngr_FillBuff(roiCtx, 1, 1, roiCachedQPs.data() + EP2_BUF_QP_BY_MB.Offset, iLcuQpOffset);
+    roiCachedGeneration = roiCtx->uGeneration;
+  }
+
+  copy(roiCachedQPs.begin(), roiCachedQPs.end(), qpTable);
+  AL_RoiMngr_NextFrame(roiCtx);
 }
 
 ModuleInterface::ErrorType EncModule::SetDynamic(std::string index, void const* param)
 {
   auto createQPTable = [&](unsigned char const* bufferToCopy) -> AL_TBuffer*
                        {
-                         Resolution resolution;
-                         auto ret = media->Get(SETTINGS_INDEX_RESOLUTION, &resolution);
-                         assert(ret == SettingsInterface::SUCCESS);
-                         AL_TDimension tDim {
-                           resolution.dimension.horizontal, resolution.dimension.vertical
-                         };
-                         MinMax<int> log2CodingUnit {};
-                         ret = media->Get(SETTINGS_INDEX_LOG2_CODING_UNIT, &log2CodingUnit);
-                         assert(ret == SettingsInterface::SUCCESS);
-                         auto size = AL_GetAllocSizeEP2(tDim, static_cast<AL_ECodec>(AL_GET_CODEC(media->settings.tChParam[0].eProfile)), log2CodingUnit.max);
+                         auto size = GetQPTableSize();
                          auto qpTable = AL_Buffer_Create_And_Allocate(allocator.get(), size, AL_Buffer_Destroy);
                          copy(bufferToCopy, bufferToCopy + size, AL_Buffer_GetData(qpTable));
                          return qpTable;
@@ -1189,7 +1408,10 @@ ModuleInterface::ErrorType EncModule::SetDynamic(std::string index, void const*
 
   if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_EMPTY")
   {
-    auto roiBuffer = createQPTable(static_cast<unsigned char const*>(param));
+    /* ROI buffers allocated by the module are attached as is: the component
+     * only recycles them once the source they go with is released */
+    auto buffer = const_cast<void*>(param);
+    auto roiBuffer = allocated.Exist(buffer) ? AL_Buffer_Create(allocator.get(), allocated.Get(buffer), GetQPTableSize(), FreeWithoutDestroyingMemory) : createQPTable(static_cast<unsigned char const*>(param));
     AL_Buffer_Ref(roiBuffer);
 
     if(encoders.empty())
@@ -1208,7 +1430,9 @@ ModuleInterface::ErrorType EncModule::SetDynamic(std::string index, void const*
 
   if(index == "DYNAMIC_INDEX_INSERT_QUANTIZATION_PARAMETER_BUFFER")
   {
-    auto qpTable = createQPTable(static_cast<unsigned char const*>(param));
+    /* A table allocated by the module is handed over, it is freed with the AL_TBuffer */
+    auto buffer = const_cast<void*>(param);
+    auto qpTable = allocated.Exist(buffer) ? AL_Buffer_Create(allocator.get(), allocated.Pop(buffer), GetQPTableSize(), AL_Buffer_Destroy) : createQPTable(static_cast<unsigned char const*>(param));
     AL_Buffer_Ref(qpTable);
 
     if(encoders.empty())
@@ -1225,11 +1449,74 @@ ModuleInterface::ErrorType EncModule::SetDynamic(std::string index, void const*
     return SUCCESS;
   }
 
+  if(index == "DYNAMIC_INDEX_SCENE_CHANGE_ANALYSIS")
+  {
+    auto analysis = static_cast<SceneChangeAnalysis const*>(param);
+
+    if(analysis->isEnabled && !isSceneChangeAnalysisEnabled)
+      detectedSceneChanges = 0;
+    isSceneChangeAnalysisEnabled = analysis->isEnabled;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_STATIC_FRAME_SKIP")
+  {
+    auto skip = static_cast<StaticFrameSkip const*>(param);
+
+    if(skip->maxConsecutiveSkips < 0)
+      return BAD_PARAMETER;
+
+    if(skip->isEnabled && !isStaticFrameSkipEnabled)
+      skippedStaticFrames = 0;
+    maxConsecutiveSkips = skip->maxConsecutiveSkips;
+    isStaticFrameSkipEnabled = skip->isEnabled;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_PREPARE_CHANNEL")
+  {
+    auto shouldPrepare = *static_cast<bool const*>(param);
+
+    if(encoders.size() && !isChannelPrepared)
+      return UNDEFINED;
+
+    if(isChannelPrepared)
+      DestroyEncoder();
+
+    if(!shouldPrepare)
+      return SUCCESS;
+
+    auto error = CreateEncoder();
+
+    if(error != SUCCESS)
+      return error;
+
+    isChannelPrepared = true;
+    return SUCCESS;
+  }
+
+  /* Safe from any thread. Kept for the engines started later when there is none yet */
+  if(index == "DYNAMIC_INDEX_THREAD_SCHEDULING")
+  {
+    unique_lock<std::mutex> lock(threadSchedulingMutex);
+    hasThreadScheduling = true;
+    threadScheduling = *static_cast<ThreadScheduling const*>(param);
+    auto isApplied = true;
+
+    for(auto engine : engines)
+      isApplied = ApplyThreadScheduling(*engine) && isApplied;
+
+    return isApplied ? SUCCESS : BAD_PARAMETER;
+  }
+
   if(!encoders.size())
     return UNDEFINED;
 
   AL_HEncoder encoder = encoders.back().enc;
 
+  if(index == "DYNAMIC_INDEX_RECONFIGURE")
+    return Reconfigure();
+
   if(index == "DYNAMIC_INDEX_CLOCK")
   {
     auto clock = static_cast<Clock const*>(param);
@@ -1278,6 +1565,7 @@ ModuleInterface::ErrorType EncModule::SetDynamic(std::string index, void const*
   {
     assert(roiCtx);
     auto roi = static_cast<RegionQuality const*>(param);
+    unique_lock<std::mutex> lock(roiMutex);
     auto ret = AL_RoiMngr_AddROI(roiCtx, roi->region.point.x, roi->region.point.y, roi->region.dimension.horizontal, roi->region.dimension.vertical, ConvertModuleToSoftQualityByPreset(roi->quality.byPreset));
     assert(ret);
     return SUCCESS;
@@ -1287,6 +1575,7 @@ ModuleInterface::ErrorType EncModule::SetDynamic(std::string index, void const*
   {
     assert(roiCtx);
     auto roi = static_cast<RegionQuality const*>(param);
+    unique_lock<std::mutex> lock(roiMutex);
     auto ret = AL_RoiMngr_AddROI(roiCtx, roi->region.point.x, roi->region.point.y, roi->region.dimension.horizontal, roi->region.dimension.vertical, static_cast<AL_ERoiQuality>(roi->quality.byValue));
     assert(ret);
     return SUCCESS;
@@ -1295,10 +1584,32 @@ ModuleInterface::ErrorType EncModule::SetDynamic(std::string index, void const*
   if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_CLEAR")
   {
     assert(roiCtx);
+    unique_lock<std::mutex> lock(roiMutex);
     AL_RoiMngr_Clear(roiCtx);
     return SUCCESS;
   }
 
+  if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_LIST")
+  {
+    assert(roiCtx);
+    auto list = static_cast<RegionQualityList const*>(param);
+    unique_lock<std::mutex> lock(roiMutex);
+
+    if(list->replace)
+      AL_RoiMngr_Clear(roiCtx);
+
+    for(auto const& entry : list->regions)
+    {
+      auto const& roi = entry.regionQuality;
+      auto quality = entry.isByValue ? static_cast<AL_ERoiQuality>(roi.quality.byValue) : ConvertModuleToSoftQualityByPreset(roi.quality.byPreset);
+
+      if(!AL_RoiMngr_AddMovingROI(roiCtx, roi.region.point.x, roi.region.point.y, entry.endPoint.x, entry.endPoint.y, roi.region.dimension.horizontal, roi.region.dimension.vertical, entry.motionFrames, quality))
+        LOG_WARNING("Region of interest outside of the picture is ignored");
+    }
+
+    return SUCCESS;
+  }
+
   if(index == "DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE")
   {
     auto lookAhead = static_cast<int>((intptr_t)param);
@@ -1416,24 +1727,13 @@ ModuleInterface::ErrorType EncModule::GetDynamic(std::string index, void* param)
   if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_FILL")
   {
     assert(roiCtx);
-    auto bufferToFill = static_cast<unsigned char*>(param);
-    auto const iLcuQpOffset = 0;
-    AL_RoiMngr_FillBuff(roiCtx, 1, 1, bufferToFill + EP2_BUF_QP_BY_MB.Offset, iLcuQpOffset);
+    FillROIQPTable(static_cast<uint8_t*>(param));
     return SUCCESS;
   }
 
   if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE")
   {
-    Resolution resolution {};
-    auto ret = media->Get(SETTINGS_INDEX_RESOLUTION, &resolution);
-    assert(ret == SettingsInterface::SUCCESS);
-    AL_TDimension tDim {
-      resolution.dimension.horizontal, resolution.dimension.vertical
-    };
-    MinMax<int> log2CodingUnit {};
-    ret = media->Get(SETTINGS_INDEX_LOG2_CODING_UNIT, &log2CodingUnit);
-    assert(ret == SettingsInterface::SUCCESS);
-    *static_cast<int*>(param) = AL_GetAllocSizeEP2(tDim, static_cast<AL_ECodec>(AL_GET_CODEC(media->settings.tChParam[0].eProfile)), log2CodingUnit.max);
+    *static_cast<int*>(param) = GetQPTableSize();
     return SUCCESS;
   }
 
@@ -1457,13 +1757,97 @@ ModuleInterface::ErrorType EncModule::GetDynamic(std::string index, void* param)
     return SUCCESS;
   }
 
+  if(index == "DYNAMIC_INDEX_CPU_TIME")
+  {
+    auto cpuTime = static_cast<ModuleCpuTime*>(param);
+    cpuTime->threads = threadsCpuTime;
+    cpuTime->callbacks = callbacksCpuTime;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_SCENE_CHANGE_ANALYSIS")
+  {
+    auto analysis = static_cast<SceneChangeAnalysis*>(param);
+    analysis->isEnabled = isSceneChangeAnalysisEnabled;
+    analysis->detected = detectedSceneChanges;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_STATIC_FRAME_SKIP")
+  {
+    auto skip = static_cast<StaticFrameSkip*>(param);
+    skip->isEnabled = isStaticFrameSkipEnabled;
+    skip->maxConsecutiveSkips = maxConsecutiveSkips;
+    skip->skipped = skippedStaticFrames;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_HOLDS_INPUTS")
+  {
+    *static_cast<bool*>(param) = encoders.size() != 1 || twoPassMngr->iPass || channelSettings.tChParam[0].tGopParam.uNumB;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_LOOKAHEAD_STATISTICS")
+  {
+    auto statistics = static_cast<LookAheadStatistics*>(param);
+    statistics->processed = lookAheadProcessed;
+    statistics->queued = lookAheadQueued;
+    statistics->depth = statistics->queued - statistics->processed;
+    statistics->maxDepth = lookAheadMaxDepth;
+    statistics->waitTime = lookAheadWaitTime;
+    statistics->blocked = lookAheadBlocked;
+    statistics->blockedTime = lookAheadBlockedTime;
+    statistics->metaDataAllocations = lookAheadMetaDataPool ? lookAheadMetaDataPool->GetNumAllocations() : 0;
+    return SUCCESS;
+  }
+
+  /* BAD_STATE when no engine thread runs: not started or without lookahead */
+  if(index == "DYNAMIC_INDEX_THREAD_SCHEDULING")
+  {
+    unique_lock<std::mutex> lock(threadSchedulingMutex);
+
+    if(engines.empty())
+      return BAD_STATE;
+
+    *static_cast<ThreadScheduling*>(param) = appliedThreadScheduling;
+    return SUCCESS;
+  }
+
   return BAD_INDEX;
 }
 
+void EncModule::AddEngine(ProcessorFifo<EmptyFifoParam>& engine)
+{
+  unique_lock<std::mutex> lock(threadSchedulingMutex);
+  engines.push_back(&engine);
+  ApplyThreadScheduling(engine);
+}
+
+/* Called with threadSchedulingMutex held */
+bool EncModule::ApplyThreadScheduling(ProcessorFifo<EmptyFifoParam>& engine)
+{
+  if(!hasThreadScheduling)
+  {
+    appliedThreadScheduling = engine.GetScheduling();
+    return true;
+  }
+
+  auto isApplied = engine.SetScheduling(threadScheduling);
+
+  if(!isApplied)
+    LOG_WARNING(string { "Engine - Enc: " } +ToString(threadScheduling) + " was not fully applied");
+
+  appliedThreadScheduling = engine.GetScheduling();
+  LOG_IMPORTANT(string { "Engine - Enc: " } +ToString(appliedThreadScheduling));
+  return isApplied;
+}
+
 void EncModule::_ProcessEmptyFifo(EmptyFifoParam param)
 {
   assert(param.encoder);
+  ThreadCpuTimeScope scope { threadsCpuTime };
   GenericEncoder& encoder = *(param.encoder);
-  EmptyFifo(encoder, param.isEOS);
+  EmptyFifo(encoder, param.source, param.isEOS, param.queuedAt);
 }
 
@@ -9,8 +9,13 @@
 #include "settings_enc_interface.h"
 
 #include "ROIMngr.h"
+#include "scene_change_analyzer.h"
+#include "static_frame_detector.h"
 
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <deque>
 #include <vector>
 #include <list>
 #include <future>
@@ -40,7 +45,9 @@ struct GenericEncoder;
 struct EmptyFifoParam
 {
   GenericEncoder* encoder;
+  AL_TBuffer* source;
   bool isEOS;
+  std::chrono::steady_clock::time_point queuedAt;
 };
 
 struct GenericEncoder
@@ -54,6 +61,7 @@ struct GenericEncoder
   std::vector<AL_TBuffer*> streamBuffers {};
   std::shared_ptr<ProcessorFifo<EmptyFifoParam>> threadFifo {};
   std::shared_ptr<LookAheadMngr> lookAheadMngr {};
+  std::deque<std::chrono::steady_clock::time_point> lookAheadArrivals {}; // of the sources in the lookahead window
   LookAheadCallBackParam callbackParam {};
 };
 
@@ -93,16 +101,55 @@ private:
   AL_TBuffer* nextQPBuffer;
   Dimension<int> initialDimension;
   Dimension<int> currentDimension;
+  AL_TEncSettings channelSettings; // those the running channel encodes with, copied byte for byte
+  bool isChannelPrepared {}; // created before Start
   AL_ESliceType currentPictureType;
   bool currentPictureIsSkipped;
 
   AL_TRoiMngrCtx* roiCtx;
+  std::mutex roiMutex;
+  std::vector<uint8_t> roiCachedQPs;
+  uint32_t roiCachedGeneration;
   std::shared_ptr<TwoPassMngr> twoPassMngr;
   AL_TBuffer* currentOutputtedStreamForSei;
   int currentTemporalId;
   Flags currentFlags;
+  std::atomic<uint64_t> threadsCpuTime {};
+  std::atomic<uint64_t> callbacksCpuTime {};
+
+  /* Each input takes a slot until the lookahead hands it to the next pass. Swapped out
+   * atomically when the encoder is destroyed: an input waiting on the previous slots then
+   * sees they are no longer current and gives up */
+  std::shared_ptr<semaphore> lookAheadSlots;
+  std::shared_ptr<LookAheadMetaDataPool> lookAheadMetaDataPool; // metadata still attached to a source keeps it alive
+  std::atomic<uint64_t> lookAheadQueued {};
+  std::atomic<uint64_t> lookAheadProcessed {};
+  std::atomic<uint64_t> lookAheadMaxDepth {};
+  std::atomic<uint64_t> lookAheadWaitTime {};
+  std::atomic<uint64_t> lookAheadBlocked {};
+  std::atomic<uint64_t> lookAheadBlockedTime {};
+
+  /* Applied to the engine threads of the lookahead, reported as read back from the system.
+   * The engines are registered under the lock so that the scheduling can be set from any thread */
+  std::mutex threadSchedulingMutex;
+  std::vector<ProcessorFifo<EmptyFifoParam>*> engines;
+  bool hasThreadScheduling {};
+  ThreadScheduling threadScheduling {};
+  ThreadScheduling appliedThreadScheduling {};
+
+  /* Only used by the input, enabled from the commands */
+  SceneChangeAnalyzer sceneChangeAnalyzer;
+  std::atomic<bool> isSceneChangeAnalysisEnabled {};
+  std::atomic<uint64_t> detectedSceneChanges {};
+  StaticFrameDetector staticFrameDetector;
+  std::atomic<bool> isStaticFrameSkipEnabled {};
+  std::atomic<int> maxConsecutiveSkips {};
+  std::atomic<uint64_t> skippedStaticFrames {};
+  int consecutiveSkips {};
 
   void InitEncoders(int numPass);
+  int GetQPTableSize();
+  void FillROIQPTable(uint8_t* qpTable);
   bool Use(BufferHandleInterface* handle, uint8_t* buffer, int size);
   void Unuse(BufferHandleInterface* handle);
   bool UseDMA(BufferHandleInterface* handle, int fd, int size);
@@ -115,6 +162,7 @@ private:
   static void RedirectionEndEncoding(void* userParam, AL_TBuffer* pStream, AL_TBuffer const* pSource, int)
   {
     auto pThis = static_cast<EncModule*>(userParam);
+    ThreadCpuTimeScope scope { pThis->callbacksCpuTime };
     pThis->EndEncoding(pStream, pSource);
   };
   void EndEncoding(AL_TBuffer* pStream, AL_TBuffer const* pSource);
@@ -123,12 +171,20 @@ private:
   {
     auto params = static_cast<LookAheadCallBackParam*>(userParam);
     auto pThis = static_cast<EncModule*>(params->module);
+    ThreadCpuTimeScope scope { pThis->callbacksCpuTime };
     pThis->EndEncodingLookAhead(pStream, pSource, params->index);
   };
   void EndEncodingLookAhead(AL_TBuffer* pStream, AL_TBuffer const* pSource, int index);
   void _ProcessEmptyFifo(EmptyFifoParam param);
   void AddFifo(GenericEncoder& encoder, AL_TBuffer* src);
-  void EmptyFifo(GenericEncoder& encoder, bool isEOS);
+  void EmptyFifo(GenericEncoder& encoder, AL_TBuffer* src, bool isEOS, std::chrono::steady_clock::time_point queuedAt);
+  void ProcessLookAhead(GenericEncoder& encoder);
+  bool WaitLookAheadSlot(std::shared_ptr<semaphore> const& slots);
+  void AnalyzeSceneChange(AL_TBuffer* input, AL_HEncoder encoder);
+  bool IsStaticFrame(AL_TBuffer* input, int size);
+  ErrorType Reconfigure();
+  void AddEngine(ProcessorFifo<EmptyFifoParam>& engine);
+  bool ApplyThreadScheduling(ProcessorFifo<EmptyFifoParam>& engine);
 
   ThreadSafeMap<AL_TBuffer const*, BufferHandleInterface*> handles;
   ThreadSafeMap<void*, AL_HANDLE> allocated;
@@ -47,9 +47,18 @@ static std::string const DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_ADD_BY_VALUE {
 static std::string const DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_CLEAR {
   "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_CLEAR"
 };
+static std::string const DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_LIST {
+  "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_LIST"
+};
 static std::string const DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE {
   "DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE"
 };
+static std::string const DYNAMIC_INDEX_SCENE_CHANGE_ANALYSIS {
+  "DYNAMIC_INDEX_SCENE_CHANGE_ANALYSIS"
+};
+static std::string const DYNAMIC_INDEX_STATIC_FRAME_SKIP {
+  "DYNAMIC_INDEX_STATIC_FRAME_SKIP"
+};
 static std::string const DYNAMIC_INDEX_IS_LONG_TERM {
   "DYNAMIC_INDEX_IS_LONG_TERM"
 };
@@ -77,6 +86,8 @@ static std::string const DYNAMIC_INDEX_HIGH_DYNAMIC_RANGE_SEIS {
 static std::string const DYNAMIC_INDEX_CURRENT_DISPLAY_PICTURE_INFO {
   "DYNAMIC_INDEX_CURRENT_DISPLAY_PICTURE_INFO"
 };
+/* param is a table from Allocate(). The module owns it only when SetDynamic returns SUCCESS,
+ * it must not return SUCCESS without keeping or freeing it */
 static std::string const DYNAMIC_INDEX_INSERT_QUANTIZATION_PARAMETER_BUFFER {
   "DYNAMIC_INDEX_INSERT_QUANTIZATION_PARAMETER_BUFFER"
 };
@@ -92,6 +103,26 @@ static std::string const DYNAMIC_INDEX_LOOP_FILTER_TC {
 static std::string const DYNAMIC_INDEX_SKIP_PICTURE {
   "DYNAMIC_INDEX_SKIP_PICTURE"
 };
+static std::string const DYNAMIC_INDEX_CPU_TIME {
+  "DYNAMIC_INDEX_CPU_TIME"
+};
+static std::string const DYNAMIC_INDEX_LOOKAHEAD_STATISTICS {
+  "DYNAMIC_INDEX_LOOKAHEAD_STATISTICS"
+};
+static std::string const DYNAMIC_INDEX_RECONFIGURE {
+  "DYNAMIC_INDEX_RECONFIGURE"
+};
+/* bool: the channel keeps inputs until the next ones come, to reorder them or to look ahead */
+static std::string const DYNAMIC_INDEX_HOLDS_INPUTS {
+  "DYNAMIC_INDEX_HOLDS_INPUTS"
+};
+static std::string const DYNAMIC_INDEX_THREAD_SCHEDULING {
+  "DYNAMIC_INDEX_THREAD_SCHEDULING"
+};
+/* bool: creates the channel before Start, which keeps it when the settings didn't change since */
+static std::string const DYNAMIC_INDEX_PREPARE_CHANNEL {
+  "DYNAMIC_INDEX_PREPARE_CHANNEL"
+};
 
 struct Callbacks
 {
@@ -168,6 +199,8 @@ struct ModuleInterface
   virtual bool Stop() = 0;
   virtual ErrorType Restart() = 0;
 
+  /* A param handing memory over is owned by the module on SUCCESS only: on any other return
+   * the caller frees it */
   virtual ErrorType SetDynamic(std::string index, void const* param) = 0;
   virtual ErrorType GetDynamic(std::string index, void* param) = 0;
 };
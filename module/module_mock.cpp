@@ -0,0 +1,499 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "module_mock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include <utility/logger.h>
+
+using namespace std;
+
+static void GetEnv(char const* name, int& value)
+{
+  char* envValue = getenv(name);
+
+  if(envValue == nullptr)
+    return;
+
+  stringstream ss {
+    string {
+      envValue
+    }
+  };
+  int parsed;
+
+  if(ss >> parsed)
+    value = parsed;
+  else
+    LOG_WARNING(string { name } +string { " is not an integer: " } +envValue);
+}
+
+static void GetEnv(char const* name, bool& value)
+{
+  int parsed = value;
+  GetEnv(name, parsed);
+  value = (parsed != 0);
+}
+
+MockModuleSettings GetMockModuleSettings(bool isDecoder)
+{
+  MockModuleSettings settings {};
+  settings.isDecoder = isDecoder;
+  GetEnv("ALLEGRO_MOCK_LATENCY", settings.latency);
+  GetEnv("ALLEGRO_MOCK_JITTER", settings.jitter);
+  GetEnv("ALLEGRO_MOCK_MAX_JOBS", settings.maxJobs);
+  GetEnv("ALLEGRO_MOCK_REORDER_DEPTH", settings.reorderDepth);
+  GetEnv("ALLEGRO_MOCK_SECTIONS", settings.sectionsPerFrame);
+  GetEnv("ALLEGRO_MOCK_FRAME_SIZE", settings.frameSize);
+  GetEnv("ALLEGRO_MOCK_INTRA_RATIO", settings.intraRatio);
+  GetEnv("ALLEGRO_MOCK_GOP_LENGTH", settings.gopLength);
+  GetEnv("ALLEGRO_MOCK_RECONFIGURE", settings.canReconfigure);
+
+  settings.latency = max(settings.latency, 0);
+  settings.jitter = max(settings.jitter, 0);
+  settings.maxJobs = max(settings.maxJobs, 1);
+  settings.reorderDepth = max(settings.reorderDepth, 0);
+  settings.sectionsPerFrame = max(settings.sectionsPerFrame, 1);
+  settings.frameSize = max(settings.frameSize, 1);
+  settings.intraRatio = max(settings.intraRatio, 1);
+  settings.gopLength = max(settings.gopLength, 1);
+  return settings;
+}
+
+MockModule::MockModule(MockModuleSettings settings) :
+  settings{settings},
+  nextInput{0},
+  nextRelease{0},
+  eosIndex{-1},
+  currentDisplayPictureInfo{0, false}
+{
+}
+
+MockModule::~MockModule()
+{
+  Stop();
+}
+
+void MockModule::Free(void* buffer)
+{
+  if(!buffer)
+    return;
+
+  free(buffer);
+}
+
+void* MockModule::Allocate(size_t size)
+{
+  return malloc(size);
+}
+
+static void StubCallbackEvent(Callbacks::Event, void*)
+{
+}
+
+bool MockModule::SetCallbacks(Callbacks callbacks)
+{
+  if(!callbacks.emptied || !callbacks.associate || !callbacks.filled || !callbacks.release)
+    return false;
+
+  if(!callbacks.event)
+    callbacks.event = &StubCallbackEvent;
+
+  this->callbacks = callbacks;
+
+  return true;
+}
+
+ModuleInterface::ErrorType MockModule::Start(bool)
+{
+  if(!workers.empty())
+    return SUCCESS;
+
+  nextInput = 0;
+  nextRelease = 0;
+  eosIndex = -1;
+  currentFlags = Flags {};
+
+  unique_lock<std::mutex> lock(threadSchedulingMutex);
+  delivery.reset(new ProcessorFifo<bool> { [this](bool) {
+                                             ThreadCpuTimeScope scope { threadsCpuTime };
+                                             Pump();
+                                           }, [](bool) {}, "Mock - Out" });
+
+  for(int i = 0; i < settings.maxJobs; ++i)
+  {
+    workers.emplace_back(new ProcessorFifo<Frame> { [this](Frame frame) {
+                                                      ThreadCpuTimeScope scope { threadsCpuTime };
+                                                      Process(frame);
+                                                    }, [this](Frame frame) {
+                                                      Drop(frame);
+                                                    }, "Mock - Job" });
+  }
+
+  ApplyThreadScheduling();
+  return SUCCESS;
+}
+
+bool MockModule::Stop()
+{
+  if(workers.empty())
+    return false;
+
+  {
+    unique_lock<std::mutex> lock(threadSchedulingMutex);
+    workers.clear();
+    delivery.reset();
+    appliedThreadScheduling = ThreadScheduling {};
+  }
+
+  ReleaseAll();
+  return true;
+}
+
+ModuleInterface::ErrorType MockModule::Restart()
+{
+  if(!Stop())
+    return UNDEFINED;
+
+  return Start(false);
+}
+
+bool MockModule::Empty(BufferHandleInterface* handle)
+{
+  if(workers.empty())
+    return false;
+
+  auto eos = (handle == nullptr || handle->payload == 0);
+
+  unique_lock<std::mutex> lock(mutex);
+
+  if(eos)
+  {
+    eosIndex = nextInput;
+    ReleaseCompletedGroups();
+    lock.unlock();
+    delivery->queue(true);
+    return true;
+  }
+
+  Frame frame { handle, nextInput++, false };
+  lock.unlock();
+
+  workers[frame.index % workers.size()]->queue(frame);
+  return true;
+}
+
+bool MockModule::Fill(BufferHandleInterface* handle)
+{
+  if(workers.empty() || !handle)
+    return false;
+
+  unique_lock<std::mutex> lock(mutex);
+  outputs.push_back(handle);
+  lock.unlock();
+
+  delivery->queue(true);
+  return true;
+}
+
+void MockModule::Process(Frame frame)
+{
+  auto latency = settings.latency;
+
+  if(settings.jitter)
+  {
+    minstd_rand engine { static_cast<unsigned int>(frame.index) + 1 };
+    uniform_int_distribution<int> distribution { -settings.jitter, settings.jitter };
+    latency = max(latency + distribution(engine), 0);
+  }
+
+  if(latency)
+    this_thread::sleep_for(chrono::microseconds(latency));
+
+  unique_lock<std::mutex> lock(mutex);
+  completed[frame.index] = frame;
+  ReleaseCompletedGroups();
+  lock.unlock();
+
+  delivery->queue(true);
+}
+
+void MockModule::Drop(Frame frame)
+{
+  callbacks.release(true, frame.input);
+}
+
+/* Must be called with the lock held */
+void MockModule::ReleaseCompletedGroups()
+{
+  int const groupSize = settings.reorderDepth + 1;
+
+  while(true)
+  {
+    if(nextRelease == eosIndex)
+    {
+      ready.push_back(Frame { nullptr, eosIndex, true });
+      eosIndex = -1;
+      return;
+    }
+
+    int groupEnd = nextRelease + groupSize;
+
+    if(eosIndex >= 0)
+      groupEnd = min(groupEnd, eosIndex);
+
+    for(int i = nextRelease; i < groupEnd; ++i)
+    {
+      if(completed.find(i) == completed.end())
+        return;
+    }
+
+    ready.push_back(completed[groupEnd - 1]);
+    completed.erase(groupEnd - 1);
+
+    for(int i = nextRelease; i < groupEnd - 1; ++i)
+    {
+      ready.push_back(completed[i]);
+      completed.erase(i);
+    }
+
+    nextRelease = groupEnd;
+  }
+}
+
+/* Only runs on the delivery thread, so that callbacks are serialized */
+void MockModule::Pump()
+{
+  while(true)
+  {
+    unique_lock<std::mutex> lock(mutex);
+
+    if(ready.empty())
+      return;
+
+    if(ready.front().isEOS)
+    {
+      ready.pop_front();
+      lock.unlock();
+      callbacks.filled(nullptr);
+      continue;
+    }
+
+    if(outputs.empty())
+      return;
+
+    auto frame = ready.front();
+    ready.pop_front();
+    auto output = outputs.front();
+    outputs.pop_front();
+    lock.unlock();
+
+    Deliver(frame, output);
+  }
+}
+
+int MockModule::FrameSize(int index) const
+{
+  minstd_rand engine { static_cast<unsigned int>(index) + 1 };
+  normal_distribution<double> distribution { 1.0, 0.2 };
+  auto factor = min(max(distribution(engine), 0.25), 4.0);
+  auto isIntra = (index % settings.gopLength) == 0;
+  auto size = settings.frameSize * (isIntra ? settings.intraRatio : 1) * factor;
+  return max(static_cast<int>(size), settings.sectionsPerFrame * 8);
+}
+
+static int constexpr NAL_HEADER_SIZE = 5;
+
+/* Annex B sections: a start code, a nal type byte and a filler payload without emulation */
+static void WriteSections(uint8_t* data, int size, int numSections, bool isIntra)
+{
+  int const sectionSize = size / numSections;
+
+  for(int i = 0; i < numSections; ++i)
+  {
+    auto section = data + i * sectionSize;
+    auto length = (i == numSections - 1) ? size - i * sectionSize : sectionSize;
+
+    if(length < NAL_HEADER_SIZE)
+    {
+      memset(section, 0xFF, length);
+      continue;
+    }
+
+    section[0] = 0x00;
+    section[1] = 0x00;
+    section[2] = 0x00;
+    section[3] = 0x01;
+    section[4] = isIntra ? 0x65 : 0x41;
+    memset(section + NAL_HEADER_SIZE, 0xFF, length - NAL_HEADER_SIZE);
+  }
+}
+
+void MockModule::Deliver(Frame frame, BufferHandleInterface* output)
+{
+  auto input = frame.input;
+  int size = output->size;
+
+  if(settings.isDecoder)
+    currentDisplayPictureInfo = DisplayPictureInfo { 0, false };
+  else
+  {
+    auto isIntra = (frame.index % settings.gopLength) == 0;
+    size = min(FrameSize(frame.index), output->size);
+
+    if(output->data)
+      WriteSections(reinterpret_cast<uint8_t*>(output->data), size, settings.sectionsPerFrame, isIntra);
+
+    currentFlags = Flags {};
+    currentFlags.isSync = isIntra;
+    currentFlags.isEndOfSlice = true;
+    currentFlags.isEndOfFrame = true;
+  }
+
+  callbacks.associate(input, output);
+
+  input->offset = 0;
+  input->payload = 0;
+  callbacks.emptied(input);
+
+  output->offset = 0;
+  output->payload = size;
+  callbacks.filled(output);
+}
+
+/* Called once the worker and delivery threads are gone */
+void MockModule::ReleaseAll()
+{
+  for(auto& it : completed)
+    callbacks.release(true, it.second.input);
+
+  completed.clear();
+
+  for(auto& frame : ready)
+  {
+    if(!frame.isEOS)
+      callbacks.release(true, frame.input);
+  }
+
+  ready.clear();
+
+  for(auto output : outputs)
+    callbacks.release(false, output);
+
+  outputs.clear();
+}
+
+/* The workers stand for the hardware but are threads of the component all the same.
+ * Called with threadSchedulingMutex held */
+bool MockModule::ApplyThreadScheduling()
+{
+  if(!delivery)
+    return true;
+
+  auto isApplied = true;
+
+  if(hasThreadScheduling)
+  {
+    isApplied = delivery->SetScheduling(threadScheduling);
+
+    for(auto& worker : workers)
+      isApplied = worker->SetScheduling(threadScheduling) && isApplied;
+
+    if(!isApplied)
+      LOG_WARNING(string { "Mock: " } +ToString(threadScheduling) + " was not fully applied");
+  }
+
+  appliedThreadScheduling = delivery->GetScheduling();
+
+  if(hasThreadScheduling)
+    LOG_IMPORTANT(string { "Mock: " } +ToString(appliedThreadScheduling));
+
+  return isApplied;
+}
+
+ModuleInterface::ErrorType MockModule::SetDynamic(std::string index, void const* param)
+{
+  if(index == "DYNAMIC_INDEX_THREAD_SCHEDULING")
+  {
+    unique_lock<std::mutex> lock(threadSchedulingMutex);
+    hasThreadScheduling = true;
+    threadScheduling = *static_cast<ThreadScheduling const*>(param);
+    return ApplyThreadScheduling() ? SUCCESS : BAD_PARAMETER;
+  }
+
+  // Refused, the component stops and starts the module to apply the settings
+  if(index == "DYNAMIC_INDEX_RECONFIGURE")
+    return settings.canReconfigure ? SUCCESS : NOT_IMPLEMENTED;
+
+  /* The table is not kept: the caller keeps its ownership and frees it */
+  if(index == "DYNAMIC_INDEX_INSERT_QUANTIZATION_PARAMETER_BUFFER")
+    return BAD_INDEX;
+
+  LOG_VERBOSE(index + string { " is ignored by the mock module" });
+  return SUCCESS;
+}
+
+ModuleInterface::ErrorType MockModule::GetDynamic(std::string index, void* param)
+{
+  if(index == "DYNAMIC_INDEX_STREAM_FLAGS")
+  {
+    *static_cast<Flags*>(param) = currentFlags;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_SKIP_PICTURE")
+  {
+    *static_cast<bool*>(param) = false;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_CURRENT_DISPLAY_PICTURE_INFO")
+  {
+    *static_cast<DisplayPictureInfo*>(param) = currentDisplayPictureInfo;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_SIZE")
+  {
+    *static_cast<int*>(param) = 0;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_REGION_OF_INTEREST_QUALITY_BUFFER_FILL")
+    return SUCCESS;
+
+  if(index == "DYNAMIC_INDEX_CPU_TIME")
+  {
+    auto cpuTime = static_cast<ModuleCpuTime*>(param);
+    cpuTime->threads = threadsCpuTime;
+    cpuTime->callbacks = 0;
+    return SUCCESS;
+  }
+
+  // The frames of a group are only released with the last one
+  if(index == "DYNAMIC_INDEX_HOLDS_INPUTS")
+  {
+    *static_cast<bool*>(param) = settings.reorderDepth > 0;
+    return SUCCESS;
+  }
+
+  if(index == "DYNAMIC_INDEX_THREAD_SCHEDULING")
+  {
+    unique_lock<std::mutex> lock(threadSchedulingMutex);
+
+    if(!delivery)
+      return BAD_STATE;
+
+    *static_cast<ThreadScheduling*>(param) = appliedThreadScheduling;
+    return SUCCESS;
+  }
+
+  return BAD_INDEX;
+}
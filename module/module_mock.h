@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "module_interface.h"
+#include "module_structs.h"
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <utility/processor_fifo.h>
+
+/* Behaviour of the simulated hardware. Times are in microseconds, sizes in bytes */
+struct MockModuleSettings
+{
+  bool isDecoder = false;
+  int latency = 0;
+  int jitter = 0;
+  int maxJobs = 1;
+  int reorderDepth = 0;
+  int sectionsPerFrame = 1;
+  int frameSize = 4096;
+  int intraRatio = 6;
+  int gopLength = 30;
+  bool canReconfigure = true; // applies new settings without a new channel
+};
+
+/* Reads ALLEGRO_MOCK_* environment variables on top of the defaults */
+MockModuleSettings GetMockModuleSettings(bool isDecoder);
+
+/* Software stand-in for the hardware modules, used to load test the component layer.
+ * Each frame is held for the configured latency by one of maxJobs workers. Completed
+ * frames are released by groups of reorderDepth + 1, last frame of the group first. */
+struct MockModule final : ModuleInterface
+{
+  MockModule(MockModuleSettings settings);
+  ~MockModule() override;
+
+  void Free(void* buffer) override;
+  void* Allocate(size_t size) override;
+
+  bool SetCallbacks(Callbacks callbacks) override;
+
+  bool Empty(BufferHandleInterface* handle) override;
+  bool Fill(BufferHandleInterface* handle) override;
+
+  ErrorType Start(bool shouldPrealloc) override;
+  bool Stop() override;
+  ErrorType Restart() override;
+
+  ErrorType SetDynamic(std::string index, void const* param) override;
+  ErrorType GetDynamic(std::string index, void* param) override;
+
+private:
+  struct Frame
+  {
+    BufferHandleInterface* input;
+    int index;
+    bool isEOS;
+  };
+
+  MockModuleSettings const settings;
+  Callbacks callbacks;
+
+  std::vector<std::unique_ptr<ProcessorFifo<Frame>>> workers;
+  std::unique_ptr<ProcessorFifo<bool>> delivery;
+  std::atomic<uint64_t> threadsCpuTime {};
+
+  /* Also guards the creation and the destruction of the threads, so that the scheduling can
+   * be set from any thread */
+  std::mutex threadSchedulingMutex;
+  bool hasThreadScheduling {};
+  ThreadScheduling threadScheduling {};
+  ThreadScheduling appliedThreadScheduling {};
+
+  std::mutex mutex;
+  std::map<int, Frame> completed;
+  std::deque<Frame> ready;
+  std::deque<BufferHandleInterface*> outputs;
+  int nextInput;
+  int nextRelease;
+  int eosIndex;
+
+  Flags currentFlags;
+  DisplayPictureInfo currentDisplayPictureInfo;
+
+  void Process(Frame frame);
+  void Drop(Frame frame);
+  void ReleaseCompletedGroups();
+  void Pump();
+  void Deliver(Frame frame, BufferHandleInterface* output);
+  int FrameSize(int index) const;
+  void ReleaseAll();
+  bool ApplyThreadScheduling();
+};
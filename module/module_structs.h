@@ -188,6 +188,20 @@ struct RegionQuality
   } quality;
 };
 
+struct RegionQualityListEntry
+{
+  RegionQuality regionQuality;
+  bool isByValue;
+  Point<int> endPoint;
+  int motionFrames;
+};
+
+struct RegionQualityList
+{
+  bool replace;
+  std::vector<RegionQualityListEntry> regions;
+};
+
 struct LookAhead
 {
   int lookAhead;
@@ -377,3 +391,35 @@ struct RateControlPlugin
   int dmaBuf;
   uint32_t dmaSize;
 };
+
+struct ModuleCpuTime
+{
+  uint64_t threads; // microseconds consumed by the threads owned by the module
+  uint64_t callbacks; // microseconds consumed by the library threads in the module callbacks
+};
+
+struct SceneChangeAnalysis
+{
+  bool isEnabled;
+  uint64_t detected; // scene changes notified since the analysis was enabled
+};
+
+struct StaticFrameSkip
+{
+  bool isEnabled;
+  int maxConsecutiveSkips; // 0 when unbounded
+  uint64_t skipped; // inputs identical to the previous one not encoded since the skip was enabled
+};
+
+/* Frames between the end of the first pass and their submission to the next pass */
+struct LookAheadStatistics
+{
+  uint64_t queued; // frames given by the first pass
+  uint64_t processed; // frames given to the next pass or dropped on stop
+  uint64_t depth;
+  uint64_t maxDepth;
+  uint64_t waitTime; // microseconds spent by the processed frames between the passes
+  uint64_t blocked; // times an input waited for the lookahead to make room
+  uint64_t blockedTime; // microseconds spent by the inputs waiting for room
+  uint64_t metaDataAllocations; // lookahead metadata allocated since the encoder creation
+};
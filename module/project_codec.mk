@@ -12,6 +12,7 @@ MODULE_CODEC_SRCS+=\
                     $(THIS.module_codec)/settings_dummy.cpp\
                     $(THIS.module_codec)/module_interface.cpp\
                     $(THIS.module_codec)/module_dummy.cpp\
+                    $(THIS.module_codec)/module_mock.cpp\
                     $(THIS.module_codec)/buffer_handle_interface.cpp\
 
     MODULE_CODEC_SRCS+= $(THIS.module_codec)/convert_module_soft_mjpeg.cpp
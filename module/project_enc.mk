@@ -7,12 +7,16 @@ MODULE_ENC_SRCS+=\
                  $(THIS.module_enc)/convert_module_soft_enc.cpp\
                  $(THIS.module_enc)/convert_module_soft_enc_roi.cpp\
                  $(THIS.module_enc)/module_enc.cpp\
+                 $(THIS.module_enc)/stream_sections.cpp\
                  $(THIS.module_enc)/memory_interface.cpp\
                  $(THIS.module_enc)/dma_memory.cpp\
                  $(THIS.module_enc)/cpp_memory.cpp\
                  $(THIS.module_enc)/device_enc_interface.cpp\
                  $(THIS.module_enc)/ROIMngr.cpp\
                  $(THIS.module_enc)/TwoPassMngr.cpp\
+                 $(THIS.module_enc)/two_pass_log.cpp\
+                 $(THIS.module_enc)/scene_change_analyzer.cpp\
+                 $(THIS.module_enc)/static_frame_detector.cpp\
 
 
 
@@ -0,0 +1,124 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "scene_change_analyzer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+/* A cut either changes the histogram of most of the picture, or changes a part of it
+ * while the picture differs much more than during the recent frames.
+ * Histogram changes are in percent of the thumbnail, differences in 1/16th of a luma level */
+static int constexpr LARGE_HISTOGRAM_CHANGE = 30;
+static int constexpr SMALL_HISTOGRAM_CHANGE = 10;
+static int constexpr SAD_RATIO = 5; // in halves
+static int constexpr MIN_SAD = 8 * 16;
+
+template<typename Sample>
+static void DecimateRow(Sample const* row, int numSamples, int shift, uint8_t* thumbnailRow)
+{
+  auto const numBlocks = numSamples / SceneChangeAnalyzer::DECIMATION;
+
+  for(int block = 0; block < numBlocks; ++block)
+  {
+    auto samples = row + block * SceneChangeAnalyzer::DECIMATION;
+    int sum = 0;
+
+    for(int i = 0; i < SceneChangeAnalyzer::DECIMATION; ++i)
+      sum += samples[i];
+
+    thumbnailRow[block] = static_cast<uint8_t>(min(255, (sum / SceneChangeAnalyzer::DECIMATION) >> shift));
+  }
+}
+
+/* One sample per block of DECIMATION samples, on one row out of DECIMATION */
+void SceneChangeAnalyzer::ComputeThumbnail(LumaPlane const& plane)
+{
+  auto const numSamples = plane.rowSize / plane.bytesPerSample;
+  auto const width = numSamples / DECIMATION;
+  auto const height = plane.rows / DECIMATION;
+  thumbnail.resize(width * height);
+
+  for(int y = 0; y < height; ++y)
+  {
+    auto row = plane.data + static_cast<size_t>(y) * DECIMATION * plane.pitch;
+
+    if(plane.bytesPerSample == 2)
+      DecimateRow(reinterpret_cast<uint16_t const*>(row), numSamples, plane.shift, &thumbnail[y * width]);
+    else
+      DecimateRow(row, numSamples, plane.shift, &thumbnail[y * width]);
+  }
+}
+
+/* Percentage of the thumbnail samples which moved to another bin */
+int SceneChangeAnalyzer::ComputeHistogramChange()
+{
+  histogram.fill(0);
+
+  for(auto sample : thumbnail)
+    ++histogram[sample * HISTOGRAM_BINS / 256];
+
+  int change = 0;
+
+  for(int bin = 0; bin < HISTOGRAM_BINS; ++bin)
+    change += abs(histogram[bin] - previousHistogram[bin]);
+
+  return change * 100 / (2 * static_cast<int>(thumbnail.size()));
+}
+
+/* In 1/16th of a luma level */
+int SceneChangeAnalyzer::ComputeMeanSad()
+{
+  auto const size = thumbnail.size();
+  int64_t sad = 0;
+
+  for(size_t i = 0; i < size; ++i)
+    sad += abs(thumbnail[i] - previousThumbnail[i]);
+
+  return static_cast<int>(sad * 16 / static_cast<int64_t>(size));
+}
+
+bool SceneChangeAnalyzer::Analyze(LumaPlane const& plane)
+{
+  ComputeThumbnail(plane);
+
+  if(thumbnail.empty())
+    return false;
+
+  auto const isFirstFrame = previousThumbnail.size() != thumbnail.size();
+  auto isSceneChange = false;
+
+  if(isFirstFrame)
+  {
+    histogram.fill(0);
+
+    for(auto sample : thumbnail)
+      ++histogram[sample * HISTOGRAM_BINS / 256];
+
+    averageSad = 0;
+  }
+  else
+  {
+    auto histogramChange = ComputeHistogramChange();
+    auto meanSad = ComputeMeanSad();
+    auto isLargeChange = histogramChange >= LARGE_HISTOGRAM_CHANGE && meanSad >= MIN_SAD;
+    auto isUnusualChange = histogramChange >= SMALL_HISTOGRAM_CHANGE && meanSad >= max(MIN_SAD, SAD_RATIO * averageSad / 2);
+    isSceneChange = isLargeChange || isUnusualChange;
+
+    /* The first frame of a scene does not tell how much the new scene moves */
+    if(!isSceneChange)
+      averageSad += (meanSad - averageSad) / 8;
+  }
+
+  swap(thumbnail, previousThumbnail);
+  swap(histogram, previousHistogram);
+  return isSceneChange;
+}
+
+void SceneChangeAnalyzer::Reset()
+{
+  previousThumbnail.clear();
+  averageSad = 0;
+}
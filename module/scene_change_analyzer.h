@@ -0,0 +1,44 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/* The luma plane as the analyzer reads it: rows are the lines of memory holding the plane,
+ * picture lines in raster, lines of tiles in tiled storages. Only rowSize bytes of a row are read */
+struct LumaPlane
+{
+  uint8_t const* data;
+  int rowSize;
+  int rows;
+  int pitch;
+  int bytesPerSample; // 1, or 2 for samples stored on 16 bits
+  int shift; // brings a sample on 8 bits
+};
+
+/* Detects the scene cuts of the input frames on a thumbnail of their luma.
+ * A cut needs both a large change of the luma histogram and a difference with the previous
+ * frame well above the recent ones, so that motion or fades alone do not trigger it */
+struct SceneChangeAnalyzer
+{
+  static int constexpr DECIMATION = 8;
+  static int constexpr HISTOGRAM_BINS = 64;
+
+  /* Returns true when the frame starts a new scene */
+  bool Analyze(LumaPlane const& plane);
+  void Reset();
+
+private:
+  void ComputeThumbnail(LumaPlane const& plane);
+  int ComputeHistogramChange();
+  int ComputeMeanSad();
+
+  std::vector<uint8_t> thumbnail {};
+  std::vector<uint8_t> previousThumbnail {};
+  std::array<int, HISTOGRAM_BINS> histogram {};
+  std::array<int, HISTOGRAM_BINS> previousHistogram {};
+  int averageSad = 0; // of the recent frames, in 1/16th of a luma level
+};
@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "static_frame_detector.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+bool StaticFrameDetector::IsUnchanged(uint8_t const* frame, size_t size)
+{
+  if(size == 0 || size != reference.size())
+  {
+    reference.assign(frame, frame + size);
+    return false;
+  }
+
+  for(size_t offset = 0; offset < size; offset += TILE_SIZE)
+  {
+    auto tileSize = min(TILE_SIZE, size - offset);
+
+    if(memcmp(frame + offset, reference.data() + offset, tileSize) == 0)
+      continue;
+
+    // The tiles before are already those of the reference
+    copy(frame + offset, frame + size, reference.begin() + offset);
+    return false;
+  }
+
+  return true;
+}
+
+void StaticFrameDetector::Reset()
+{
+  reference.clear();
+}
@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Finds the input frames identical to the previous one, as in screen sharing or fixed cameras.
+ * The frames are compared tile by tile with the copy of the previous one: a change stops the
+ * comparison and only the tiles from the first change on are copied as the next reference */
+struct StaticFrameDetector
+{
+  static size_t constexpr TILE_SIZE = 4096;
+
+  /* Returns true when the size bytes of the frame are those of the previous frame */
+  bool IsUnchanged(uint8_t const* frame, size_t size);
+  void Reset();
+
+private:
+  std::vector<uint8_t> reference {};
+};
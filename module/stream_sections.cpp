@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "stream_sections.h"
+#include <cassert>
+
+extern "C"
+{
+#include <lib_common/BufferStreamMeta.h>
+#include <lib_common/StreamBuffer.h>
+}
+
+using namespace std;
+
+static int WriteFillerDataSection(shared_ptr<MemoryInterface> memory, AL_TBuffer* source, AL_TBuffer* destination, int offset, int numSection)
+{
+  auto meta = reinterpret_cast<AL_TStreamMetaData*>(AL_Buffer_GetMetaData(source, AL_META_TYPE_STREAM));
+  auto& section = meta->pSections[numSection];
+
+  auto src = AL_Buffer_GetData(source);
+  auto dst = AL_Buffer_GetData(destination);
+  auto srcOffset = section.uOffset;
+  auto dstOffset = offset;
+  auto length = section.uLength;
+
+  while(--length && (src[srcOffset] != 0xFF))
+  {
+    dst[dstOffset++] = src[srcOffset++];
+  }
+
+  if(length > 0)
+    memory->set(destination, dstOffset, 0xFF, length);
+
+  assert(src[srcOffset + length] == 0x80);
+  dst[dstOffset + length] = src[srcOffset + length];
+
+  return section.uLength;
+}
+
+static int WriteOneSection(shared_ptr<MemoryInterface> memory, AL_TBuffer* source, AL_TBuffer* destination, int offset, int numSection)
+{
+  auto meta = reinterpret_cast<AL_TStreamMetaData*>(AL_Buffer_GetMetaData(source, AL_META_TYPE_STREAM));
+  auto& section = meta->pSections[numSection];
+
+  if(!section.uLength)
+    return 0;
+
+  auto size = source->zSizes[0] - section.uOffset;
+
+  if(size < section.uLength)
+  {
+    memory->move(destination, offset, source, section.uOffset, size);
+    memory->move(destination, offset, source, 0, section.uLength - size);
+  }
+  else
+    memory->move(destination, offset, source, section.uOffset, section.uLength);
+
+  return section.uLength;
+}
+
+int ConstructConfigStream(shared_ptr<MemoryInterface> memory, AL_TBuffer* config, AL_TBuffer* stream, int& firstSection)
+{
+  auto size = 0;
+  auto meta = (AL_TStreamMetaData*)(AL_Buffer_GetMetaData(stream, AL_META_TYPE_STREAM));
+  assert(meta);
+
+  assert(firstSection <= meta->uNumSection);
+
+  while(((meta->pSections[firstSection].eFlags & AL_SECTION_CONFIG_FLAG) != 0) && (firstSection < meta->uNumSection))
+  {
+    if(meta->pSections[firstSection].eFlags & AL_SECTION_APP_FILLER_FLAG)
+      size += WriteFillerDataSection(memory, stream, config, size, firstSection);
+    else
+      size += WriteOneSection(memory, stream, config, size, firstSection);
+    firstSection++;
+  }
+
+  return size;
+}
+
+int ReconstructStream(shared_ptr<MemoryInterface> memory, AL_TBuffer* stream, int firstSection)
+{
+  auto size = 0;
+  auto meta = (AL_TStreamMetaData*)(AL_Buffer_GetMetaData(stream, AL_META_TYPE_STREAM));
+  assert(meta);
+
+  assert(firstSection <= meta->uNumSection);
+
+  for(int i = firstSection; i < meta->uNumSection; i++)
+  {
+    if(meta->pSections[i].eFlags & AL_SECTION_APP_FILLER_FLAG)
+      size += WriteFillerDataSection(memory, stream, stream, size, i);
+    else
+      size += WriteOneSection(memory, stream, stream, size, i);
+  }
+
+  return size;
+}
@@ -0,0 +1,15 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "memory_interface.h"
+
+#include <memory>
+
+/* Moves the configuration sections of stream, starting at firstSection, at the beginning of config.
+ * firstSection is updated to the first section which is not a configuration one. Returns the size written */
+int ConstructConfigStream(std::shared_ptr<MemoryInterface> memory, AL_TBuffer* config, AL_TBuffer* stream, int& firstSection);
+
+/* Compacts the sections of stream from firstSection at the beginning of its data. Returns the size written */
+int ReconstructStream(std::shared_ptr<MemoryInterface> memory, AL_TBuffer* stream, int firstSection);
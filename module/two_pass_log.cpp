@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "two_pass_log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+static string const TEXT_LOG_EXTENSION = ".txt";
+
+/* Enough for the first frame of a chunk to be a P frame, see TwoPassChunk */
+static int constexpr CHUNK_WARM_UP_FRAMES = 2;
+
+bool IsTwoPassTextLogName(string const& sFileName)
+{
+  return sFileName.size() >= TEXT_LOG_EXTENSION.size() && sFileName.compare(sFileName.size() - TEXT_LOG_EXTENSION.size(), TEXT_LOG_EXTENSION.size(), TEXT_LOG_EXTENSION) == 0;
+}
+
+void WriteTwoPassLogHeader(ofstream& file)
+{
+  TwoPassLogHeader tHeader {};
+  memcpy(tHeader.cMagic, TWOPASS_LOG_MAGIC, sizeof(tHeader.cMagic));
+  tHeader.uVersion = TWOPASS_LOG_VERSION;
+  tHeader.uRecordSize = sizeof(TwoPassLogRecord);
+  file.write(reinterpret_cast<char const*>(&tHeader), sizeof(tHeader));
+}
+
+void WriteTwoPassLogRecords(ofstream& file, bool bBinary, vector<TwoPassLogRecord> const& tRecords)
+{
+  if(bBinary)
+  {
+    file.write(reinterpret_cast<char const*>(tRecords.data()), tRecords.size() * sizeof(TwoPassLogRecord));
+    return;
+  }
+
+  for(auto const& tRecord : tRecords)
+    file << tRecord.iPictureSize << " " << tRecord.iPercentIntra << "\n";
+}
+
+bool ParseTwoPassTextRecord(char* sLine, TwoPassLogRecord& tRecord)
+{
+  auto str_PicSize = strtok(sLine, " ");
+  auto str_PercentIntra = strtok(nullptr, " ");
+
+  if((str_PicSize == nullptr) || (str_PercentIntra == nullptr))
+    return false;
+
+  tRecord.iPictureSize = atoi(str_PicSize);
+  tRecord.iPercentIntra = atoi(str_PercentIntra);
+  return true;
+}
+
+vector<TwoPassLogRecord> ReadTwoPassLogRecords(string const& sFileName)
+{
+  ifstream file(sFileName, ios::binary);
+
+  if(!file.is_open())
+    throw runtime_error("Can't open TwoPass LogFile " + sFileName);
+
+  vector<TwoPassLogRecord> tRecords;
+  TwoPassLogRecord tRecord;
+  TwoPassLogHeader tHeader {};
+
+  if(file.read(reinterpret_cast<char*>(&tHeader), sizeof(tHeader)) && memcmp(tHeader.cMagic, TWOPASS_LOG_MAGIC, sizeof(tHeader.cMagic)) == 0)
+  {
+    if(tHeader.uVersion != TWOPASS_LOG_VERSION || tHeader.uRecordSize != sizeof(TwoPassLogRecord))
+      throw runtime_error("Unsupported TwoPass LogFile version");
+
+    while(file.read(reinterpret_cast<char*>(&tRecord), sizeof(tRecord)))
+      tRecords.push_back(tRecord);
+
+    return tRecords;
+  }
+
+  file.clear();
+  file.seekg(0);
+  char sLine[256];
+
+  while(file.getline(sLine, 256) && ParseTwoPassTextRecord(sLine, tRecord))
+    tRecords.push_back(tRecord);
+
+  return tRecords;
+}
+
+/* The chunks start on a gop, the gops are spread evenly between them */
+vector<TwoPassChunk> SplitTwoPassIntoChunks(int iNumFrames, int iNumChunks, int iGopSize)
+{
+  auto iAlignment = max(iGopSize, 1);
+  auto iNumGops = (iNumFrames + iAlignment - 1) / iAlignment;
+  iNumChunks = max(1, min(iNumChunks, iNumGops));
+
+  vector<TwoPassChunk> tChunks;
+
+  for(int i = 0; i < iNumChunks; ++i)
+  {
+    auto iFirstFrame = min(iNumFrames, static_cast<int>(int64_t(i) * iNumGops / iNumChunks) * iAlignment);
+    auto iEndFrame = min(iNumFrames, static_cast<int>(int64_t(i + 1) * iNumGops / iNumChunks) * iAlignment);
+    tChunks.push_back({ iFirstFrame, iEndFrame - iFirstFrame, min(iFirstFrame, CHUNK_WARM_UP_FRAMES) });
+  }
+
+  return tChunks;
+}
+
+string GetTwoPassChunkLogName(string const& sFileName, int iChunk)
+{
+  auto sChunk = ".chunk" + to_string(iChunk);
+
+  if(!IsTwoPassTextLogName(sFileName))
+    return sFileName + sChunk;
+
+  return sFileName.substr(0, sFileName.size() - TEXT_LOG_EXTENSION.size()) + sChunk + TEXT_LOG_EXTENSION;
+}
+
+void MergeTwoPassChunkLogs(string const& sFileName, vector<TwoPassChunk> const& tChunks)
+{
+  auto bBinaryLog = !IsTwoPassTextLogName(sFileName);
+  ofstream outputFile(sFileName, bBinaryLog ? ios::binary : ios::out);
+
+  if(!outputFile.is_open())
+    throw runtime_error("Can't open TwoPass LogFile");
+
+  if(bBinaryLog)
+    WriteTwoPassLogHeader(outputFile);
+
+  for(int i = 0; i < static_cast<int>(tChunks.size()); ++i)
+  {
+    auto const& tChunk = tChunks[i];
+    auto tRecords = ReadTwoPassLogRecords(GetTwoPassChunkLogName(sFileName, i));
+    auto iExpected = tChunk.iNumWarmUpFrames + tChunk.iNumFrames;
+
+    if(static_cast<int>(tRecords.size()) != iExpected)
+      throw runtime_error("[Pass 1] : Chunk " + to_string(i) + " Logfile has " + to_string(tRecords.size()) + " frames instead of " + to_string(iExpected));
+
+    tRecords.erase(tRecords.begin(), tRecords.begin() + tChunk.iNumWarmUpFrames);
+    WriteTwoPassLogRecords(outputFile, bBinaryLog, tRecords);
+  }
+
+  if(!outputFile.flush())
+    throw runtime_error("Can't write TwoPass LogFile");
+}
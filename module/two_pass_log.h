@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/* Logfile of the offline two-pass, written by the first pass and read by the second one.
+ * Does not depend on the encoder library, so that applications can split the first pass
+ * in chunks and merge their logfiles on their own */
+
+/* Binary logfile: a header followed by one record per frame. A logfile whose name ends
+ * with ".txt" holds a line per frame instead */
+static char const TWOPASS_LOG_MAGIC[4] = { 'A', 'L', '2', 'P' };
+static uint32_t constexpr TWOPASS_LOG_VERSION = 1;
+
+struct TwoPassLogHeader
+{
+  char cMagic[4];
+  uint32_t uVersion;
+  uint32_t uRecordSize;
+  uint32_t uReserved;
+};
+
+struct TwoPassLogRecord
+{
+  int32_t iPictureSize;
+  int32_t iPercentIntra;
+};
+
+bool IsTwoPassTextLogName(std::string const& sFileName);
+void WriteTwoPassLogHeader(std::ofstream& file);
+void WriteTwoPassLogRecords(std::ofstream& file, bool bBinary, std::vector<TwoPassLogRecord> const& tRecords);
+/* Parses a line of a text logfile, sLine is modified */
+bool ParseTwoPassTextRecord(char* sLine, TwoPassLogRecord& tRecord);
+/* Reads a whole logfile, of either format */
+std::vector<TwoPassLogRecord> ReadTwoPassLogRecords(std::string const& sFileName);
+
+/*
+** Gop aligned part of the input, for a first pass running on its own channel
+** The warm up frames before the part are encoded first and left out of the merged logfile:
+** the first frame of the part is then a P frame as in a first pass over the whole input,
+** instead of the intra frame starting a new channel. Its references still come from the
+** warm up frames only, so the records of the first frames of a part can differ slightly
+** from the ones of a first pass over the whole input
+*/
+struct TwoPassChunk
+{
+  int iFirstFrame;
+  int iNumFrames;
+  int iNumWarmUpFrames;
+};
+
+std::vector<TwoPassChunk> SplitTwoPassIntoChunks(int iNumFrames, int iNumChunks, int iGopSize);
+std::string GetTwoPassChunkLogName(std::string const& sFileName, int iChunk);
+/* Writes the logfile of the whole input from the logfiles of its chunks, in the format of its name */
+void MergeTwoPassChunkLogs(std::string const& sFileName, std::vector<TwoPassChunk> const& tChunks);
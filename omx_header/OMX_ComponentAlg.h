@@ -131,6 +131,186 @@ typedef struct OMX_ALG_PARAM_PREALLOCATION
   OMX_BOOL bDisablePreallocation;
 }OMX_ALG_PARAM_PREALLOCATION;
 
+/**
+ * Channel prepared in OMX_StateLoaded, ahead of the transition to OMX_StateIdle
+ *
+ * The encoder creates its channel and allocates the buffers of the current port definitions.
+ * OMX_AllocateBuffer hands out the prepared buffers, the ones left are freed once the ports are
+ * populated. The transition to OMX_StateExecuting keeps the channel when the settings didn't
+ * change since, and creates a new one otherwise. The decoders create their channel from the
+ * stream and return OMX_ErrorUnsupportedIndex
+ *
+ * STRUCT MEMBERS:
+ *  nSize    : Size of the structure in bytes
+ *  nVersion : OMX specification version information
+ *  bPrepare : Prepare the channel and the buffers, or release them
+ */
+typedef struct OMX_ALG_PARAM_PREPARE_CHANNEL
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_BOOL bPrepare;
+}OMX_ALG_PARAM_PREPARE_CHANNEL;
+
+/**
+ * Task queue statistics
+ *
+ * STRUCT MEMBERS:
+ *  nEnqueued  : Number of tasks pushed in the queue
+ *  nProcessed : Number of tasks taken out of the queue and processed
+ *  nDepth     : Number of tasks currently waiting in the queue
+ *  nMaxDepth  : Highest number of tasks that waited in the queue
+ *  nWaitTime  : Cumulative time spent in the queue by the processed tasks in microseconds
+ */
+typedef struct OMX_ALG_QUEUE_STATISTICS
+{
+  OMX_U64 nEnqueued;
+  OMX_U64 nProcessed;
+  OMX_U64 nDepth;
+  OMX_U64 nMaxDepth;
+  OMX_U64 nWaitTime;
+}OMX_ALG_QUEUE_STATISTICS;
+
+/**
+ * Port statistics
+ *
+ * STRUCT MEMBERS:
+ *  nWaitFullBlocked  : Number of times the component waited for all the buffers of the port to be populated
+ *  nWaitFullTime     : Cumulative time spent waiting for the port to be populated in microseconds
+ *  nWaitEmptyBlocked : Number of times the component waited for all the buffers of the port to be freed
+ *  nWaitEmptyTime    : Cumulative time spent waiting for the port to be unpopulated in microseconds
+ */
+typedef struct OMX_ALG_PORT_STATISTICS
+{
+  OMX_U64 nWaitFullBlocked;
+  OMX_U64 nWaitFullTime;
+  OMX_U64 nWaitEmptyBlocked;
+  OMX_U64 nWaitEmptyTime;
+}OMX_ALG_PORT_STATISTICS;
+
+/**
+ * Component statistics configuration, GetConfig only
+ *
+ * STRUCT MEMBERS:
+ *  nSize                 : Size of the structure in bytes
+ *  nVersion              : OMX specification version information
+ *  nInputFrames          : Number of buffers flagged OMX_BUFFERFLAG_ENDOFFRAME sent to the input port
+ *  nOutputFrames         : Number of frames outputted by the component
+ *  nLatency              : Cumulative time between an input and its frame on the output in microseconds
+ *  nLatencyFrames        : Number of frames taken into account in nLatency
+ *  nBufferMemory         : Bytes of the buffers populating the ports
+ *  tCommands             : Statistics of the queue of commands and buffers sent to the component
+ *  tEmptyQueue           : Statistics of the queue of input buffers given to the module
+ *  tFillQueue            : Statistics of the queue of output buffers given to the module
+ *  tInputPort            : Statistics of the input port
+ *  tOutputPort           : Statistics of the output port
+ *  tLookAhead            : Statistics of the frames between the first pass and the next pass of an encoder with lookahead
+ *  nLookAheadBlocked     : Number of times an input waited for the lookahead to make room
+ *  nLookAheadBlockedTime : Cumulative time spent by the inputs waiting for the lookahead in microseconds
+ *  nLookAheadAllocations : Number of lookahead metadata allocated since the encoder creation
+ *  nReconfigurations     : Number of port settings applied while executing
+ *  nReconfigInPlace      : Number of them applied on the running channel, without a new one
+ *  nReconfigDowntime     : Cumulative time the reconfigurations held the channel in microseconds
+ *  nReconfigLostFrames   : Cumulative downtime of the reconfigurations in frame periods
+ */
+typedef struct OMX_ALG_CONFIG_STATISTICS
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U64 nInputFrames;
+  OMX_U64 nOutputFrames;
+  OMX_U64 nLatency;
+  OMX_U64 nLatencyFrames;
+  OMX_U64 nBufferMemory;
+  OMX_ALG_QUEUE_STATISTICS tCommands;
+  OMX_ALG_QUEUE_STATISTICS tEmptyQueue;
+  OMX_ALG_QUEUE_STATISTICS tFillQueue;
+  OMX_ALG_PORT_STATISTICS tInputPort;
+  OMX_ALG_PORT_STATISTICS tOutputPort;
+  OMX_ALG_QUEUE_STATISTICS tLookAhead;
+  OMX_U64 nLookAheadBlocked;
+  OMX_U64 nLookAheadBlockedTime;
+  OMX_U64 nLookAheadAllocations;
+  OMX_U64 nReconfigurations;
+  OMX_U64 nReconfigInPlace;
+  OMX_U64 nReconfigDowntime;
+  OMX_U64 nReconfigLostFrames;
+}OMX_ALG_CONFIG_STATISTICS;
+
+/**
+ * Component host cpu usage configuration, GetConfig only
+ * All the times are cumulative cpu times in microseconds
+ *
+ * STRUCT MEMBERS:
+ *  nSize                   : Size of the structure in bytes
+ *  nVersion                : OMX specification version information
+ *  nFrames                 : Number of frames outputted by the component
+ *  nCommandsCpuTime        : Cpu time of the thread processing the commands
+ *  nEmptyCpuTime           : Cpu time of the thread giving the input buffers to the module
+ *  nFillCpuTime            : Cpu time of the thread giving the output buffers to the module
+ *  nModuleThreadsCpuTime   : Cpu time of the threads owned by the module
+ *  nModuleCallbacksCpuTime : Cpu time of the codec library threads in the module callbacks
+ */
+typedef struct OMX_ALG_CONFIG_CPU_USAGE
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U64 nFrames;
+  OMX_U64 nCommandsCpuTime;
+  OMX_U64 nEmptyCpuTime;
+  OMX_U64 nFillCpuTime;
+  OMX_U64 nModuleThreadsCpuTime;
+  OMX_U64 nModuleCallbacksCpuTime;
+}OMX_ALG_CONFIG_CPU_USAGE;
+
+/** Threads started by a component */
+typedef enum OMX_ALG_THREAD
+{
+  OMX_ALG_THREAD_COMMANDS, /**< Commands and buffer dispatch */
+  OMX_ALG_THREAD_INPUT,    /**< Input buffers handed to the module */
+  OMX_ALG_THREAD_OUTPUT,   /**< Output buffers returned to the application */
+  OMX_ALG_THREAD_MODULE,   /**< Threads of the module, such as the lookahead engine */
+  OMX_ALG_THREAD_MAX_ENUM = 0x7FFFFFFF,
+}OMX_ALG_THREAD;
+
+typedef enum OMX_ALG_THREAD_POLICY
+{
+  OMX_ALG_THREAD_POLICY_OTHER,       /**< Default time sharing policy */
+  OMX_ALG_THREAD_POLICY_FIFO,        /**< Real time, first in first out */
+  OMX_ALG_THREAD_POLICY_ROUND_ROBIN, /**< Real time, round robin */
+  OMX_ALG_THREAD_POLICY_MAX_ENUM = 0x7FFFFFFF,
+}OMX_ALG_THREAD_POLICY;
+
+/**
+ * Cpu affinity and scheduling of the threads of a component
+ *
+ * SetConfig applies the scheduling to the threads at once and to those started later. It fails
+ * with OMX_ErrorUnsupportedSetting when the system refused a part of it, for instance a real
+ * time policy without CAP_SYS_NICE: what was accepted stays applied.
+ * GetConfig reports what the threads run with, as read back from the system. The mask is 0
+ * when the component has no such thread of its own, for instance on a shared thread pool.
+ * For OMX_ALG_THREAD_MODULE, GetConfig fails with OMX_ErrorNotReady while no module thread
+ * runs, for instance an encoder without lookahead or not started yet, and both fail with
+ * OMX_ErrorUnsupportedIndex when the module has no threads of its own
+ *
+ * STRUCT MEMBERS:
+ *  nSize     : Size of the structure in bytes
+ *  nVersion  : OMX specification version information
+ *  eThread   : Threads to configure or to report
+ *  nCpuMask  : Cpus the threads may run on, one bit per cpu. 0 keeps the affinity of the process
+ *  ePolicy   : Scheduling policy
+ *  nPriority : Priority under a real time policy, 0 otherwise
+ */
+typedef struct OMX_ALG_CONFIG_THREAD_SCHEDULING
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_ALG_THREAD eThread;
+  OMX_U64 nCpuMask;
+  OMX_ALG_THREAD_POLICY ePolicy;
+  OMX_S32 nPriority;
+}OMX_ALG_CONFIG_THREAD_SCHEDULING;
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -162,6 +162,49 @@ typedef enum OMX_ALG_COREINDEXTYPE
  */
 OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_ALG_GetHandle(OMX_OUT OMX_HANDLETYPE* pHandle, OMX_IN OMX_STRING cComponentName, OMX_IN OMX_PTR pAppData, OMX_IN OMX_CALLBACKTYPE* pCallBacks, OMX_IN OMX_ALG_COREINDEXTYPE nCoreParamIndex, OMX_IN OMX_PTR pSettings);
 
+/**
+ * Core device load
+ * STRUCT MEMBERS:
+ *  nSize      : Size of the structure in bytes
+ *  nVersion   : OMX specification version information
+ *  cDevice    : Device name, as given with OMX_ALG_CoreIndexDevice. "mock" for the mock components
+ *  nCapacity  : Capacity of the device, in pixels per second weighted by codec and sample format
+ *  nLoad      : Load of the channels admitted on the device
+ *  nRemaining : Load the device can still take
+ *  nChannels  : Number of channels admitted on the device
+ */
+typedef struct OMX_ALG_CORE_DEVICE_LOAD
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_STRING cDevice;
+  OMX_U64 nCapacity;
+  OMX_U64 nLoad;
+  OMX_U64 nRemaining;
+  OMX_U32 nChannels;
+}OMX_ALG_CORE_DEVICE_LOAD;
+
+/** The OMX_ALG_GetDeviceLoad method gives the load of a device.
+
+    A channel is admitted on its device when it goes from OMX_StateLoaded to
+    OMX_StateIdle, and released when its transition back to OMX_StateLoaded
+    completes. Its load is its pixel rate weighted by its codec, profile, bit
+    depth and chroma format. A channel that doesn't fit in the remaining
+    capacity is refused with OMX_ALG_ErrorChannelHardwareCapacityExceeded
+    before any buffer is allocated. The capacity is unlimited unless
+    OMX_ALLEGRO_DEVICE_CAPACITY is set, either to a single capacity for all
+    the devices or to a list such as "/dev/al_e2xx=500000000,1000000000"
+    where the entry without a device applies to the devices not listed.
+
+    @param [inout] pLoad
+        pointer to an OMX_ALG_CORE_DEVICE_LOAD structure whose cDevice is set
+    @return OMX_ERRORTYPE
+        If the command successfully executes, the return code will be
+        OMX_ErrorNone.  Otherwise the appropriate OMX error will be returned.
+    @ingroup core
+ */
+OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_ALG_GetDeviceLoad(OMX_INOUT OMX_ALG_CORE_DEVICE_LOAD* pLoad);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
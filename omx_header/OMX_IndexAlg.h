@@ -54,6 +54,10 @@ typedef enum OMX_ALG_INDEXTYPE
   OMX_ALG_IndexVendorComponentStartUnused = OMX_IndexVendorStartUnused + 0x00100000,
   OMX_ALG_IndexParamReportedLatency, /**< reference: OMX_ALG_PARAM_REPORTED_LATENCY */
   OMX_ALG_IndexParamPreallocation,   /**< reference: OMX_ALG_PARAM_PREALLOCATION */
+  OMX_ALG_IndexConfigStatistics,     /**< reference: OMX_ALG_CONFIG_STATISTICS */
+  OMX_ALG_IndexConfigCpuUsage,       /**< reference: OMX_ALG_CONFIG_CPU_USAGE */
+  OMX_ALG_IndexConfigThreadScheduling, /**< reference: OMX_ALG_CONFIG_THREAD_SCHEDULING */
+  OMX_ALG_IndexParamPrepareChannel,    /**< reference: OMX_ALG_PARAM_PREPARE_CHANNEL */
 
   /* Port parameters and configurations */
   OMX_ALG_IndexVendorPortStartUnused = OMX_IndexVendorStartUnused + 0x00200000,
@@ -136,6 +140,9 @@ typedef enum OMX_ALG_INDEXTYPE
   OMX_ALG_IndexConfigVideoLoopFilterTc,                       /**< reference: OMX_ALG_VIDEO_CONFIG_LOOP_FILTER_TC */
   OMX_ALG_IndexConfigVideoHighDynamicRangeSEI,                /**< reference: OMX_ALG_VIDEO_CONFIG_HIGH_DYNAMIC_RANGE_SEI */
   OMX_ALG_IndexConfigVideoMaxResolutionChange,                /**< reference: OMX_ALG_VIDEO_CONFIG_MAX_RESOLUTION_CHANGE */
+  OMX_ALG_IndexConfigVideoRegionOfInterestList,               /**< reference: OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST_LIST */
+  OMX_ALG_IndexConfigVideoSceneChangeAnalysis,                /**< reference: OMX_ALG_VIDEO_CONFIG_SCENE_CHANGE_ANALYSIS */
+  OMX_ALG_IndexConfigVideoStaticFrameSkip,                    /**< reference: OMX_ALG_VIDEO_CONFIG_STATIC_FRAME_SKIP */
 
   /* Vender Image & Video common configurations */
   OMX_ALG_IndexVendorCommonStartUnused = OMX_IndexVendorStartUnused + 0x00700000,
@@ -1221,6 +1221,60 @@ typedef struct OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST_BY_VALUE
   OMX_S32 nQuality;
 }OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST_BY_VALUE;
 
+/**
+ * Region of interest entry of a region of interest list
+ *
+ * STRUCT MEMBERS:
+ *  nLeft         : X Coordinate of the top left corner of the rectangle
+ *  nTop          : Y Coordinate of the top left corner of the rectangle
+ *  nWidth        : Width of the rectangle
+ *  nHeight       : Height of the rectangle
+ *  bByValue      : Use nQuality instead of eQuality
+ *  eQuality      : Quality of the region of interest by enum
+ *  nQuality      : Quality of the region of interest by value
+ *  nEndLeft      : X Coordinate of the top left corner after nMotionFrames frames
+ *  nEndTop       : Y Coordinate of the top left corner after nMotionFrames frames
+ *  nMotionFrames : Number of frames to linearly move the rectangle to its end position, 0 for a static rectangle
+ */
+typedef struct OMX_ALG_VIDEO_REGION_OF_INTEREST
+{
+  OMX_S32 nLeft;
+  OMX_S32 nTop;
+  OMX_U32 nWidth;
+  OMX_U32 nHeight;
+  OMX_BOOL bByValue;
+  OMX_ALG_ERoiQuality eQuality;
+  OMX_S32 nQuality;
+  OMX_S32 nEndLeft;
+  OMX_S32 nEndTop;
+  OMX_U32 nMotionFrames;
+}OMX_ALG_VIDEO_REGION_OF_INTEREST;
+
+/** Maximum number of regions of interest in a list */
+#define OMX_ALG_MAX_REGIONS_OF_INTEREST 256
+
+/**
+ * Structure for dynamically setting several regions of interest at once.
+ * The whole list is applied on the same frame
+ *
+ * STRUCT MEMBERS:
+ *  nSize       : Size of the structure in bytes
+ *  nVersion    : OMX specification version information
+ *  nPortIndex  : Port that this structure applies to
+ *  bReplace    : Remove the current regions of interest before adding the list
+ *  nNumRegions : Number of regions of interest in pRegions, at most OMX_ALG_MAX_REGIONS_OF_INTEREST
+ *  pRegions    : Pointer to the regions of interest, in priority order
+ */
+typedef struct OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST_LIST
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_BOOL bReplace;
+  OMX_U32 nNumRegions;
+  OMX_ALG_VIDEO_REGION_OF_INTEREST* pRegions;
+}OMX_ALG_VIDEO_CONFIG_REGION_OF_INTEREST_LIST;
+
 /**
  * Structure for dynamically notifying a scene change
  *
@@ -1238,6 +1292,50 @@ typedef struct OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE
   OMX_U32 nLookAhead;
 }OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE;
 
+/**
+ * Structure for dynamically enabling the detection of the scene changes on the input frames.
+ * Each detected scene change is notified to the encoder as if the application did it.
+ * Used without lookahead, which detects the scene changes with a first pass
+ *
+ * STRUCT MEMBERS:
+ *  nSize                 : Size of the structure in bytes
+ *  nVersion              : OMX specification version information
+ *  nPortIndex            : Port that this structure applies to
+ *  bEnableAnalysis       : Analyze the luma of the input frames
+ *  nDetectedSceneChanges : Number of scene changes notified by the analysis, ignored by SetConfig
+ */
+typedef struct OMX_ALG_VIDEO_CONFIG_SCENE_CHANGE_ANALYSIS
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_BOOL bEnableAnalysis;
+  OMX_U64 nDetectedSceneChanges;
+}OMX_ALG_VIDEO_CONFIG_SCENE_CHANGE_ANALYSIS;
+
+/**
+ * Structure for dynamically skipping the input frames identical to the previous one.
+ * A skipped frame is not encoded and produces no output buffer: the decoder keeps
+ * displaying the previous picture until the next frame
+ *
+ * STRUCT MEMBERS:
+ *  nSize                : Size of the structure in bytes
+ *  nVersion             : OMX specification version information
+ *  nPortIndex           : Port that this structure applies to
+ *  bEnableSkip          : Skip the input frames identical to the previous one
+ *  nMaxConsecutiveSkips : Number of consecutive frames skipped before one is encoded anyway, 0 to skip all of them
+ *  nSkippedFrames       : Number of frames skipped since the skip was enabled, ignored by SetConfig
+ */
+typedef struct OMX_ALG_VIDEO_CONFIG_STATIC_FRAME_SKIP
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_BOOL bEnableSkip;
+  OMX_U32 nMaxConsecutiveSkips;
+  OMX_U64 nSkippedFrames;
+}OMX_ALG_VIDEO_CONFIG_STATIC_FRAME_SKIP;
+
 /**
  * Structure for dynamically notifying a resolution change
  *
@@ -352,6 +352,10 @@ static std::map<OMX_INDEXTYPE, std::string> OMXIndexInStringMap =
   { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexVendorComponentStartUnused), "OMX_ALG_IndexVendorComponentStartUnused" },
   { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamReportedLatency), "OMX_ALG_IndexParamReportedLatency" },
   { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamPreallocation), "OMX_ALG_IndexParamPreallocation" },
+  { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigStatistics), "OMX_ALG_IndexConfigStatistics" },
+  { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigCpuUsage), "OMX_ALG_IndexConfigCpuUsage" },
+  { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigThreadScheduling), "OMX_ALG_IndexConfigThreadScheduling" },
+  { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamPrepareChannel), "OMX_ALG_IndexParamPrepareChannel" },
 
   { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexVendorPortStartUnused), "OMX_ALG_IndexVendorPortStartUnused" },
   { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexPortParamBufferMode), "OMX_ALG_IndexPortParamBufferMode" },
@@ -430,6 +434,9 @@ static std::map<OMX_INDEXTYPE, std::string> OMXIndexInStringMap =
   { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoColorPrimaries), "OMX_ALG_IndexConfigVideoColorPrimaries" },
   { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoHighDynamicRangeSEI), "OMX_ALG_IndexConfigVideoHighDynamicRangeSEI" },
   { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoMaxResolutionChange), "OMX_ALG_IndexConfigVideoMaxResolutionChange" },
+  { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoRegionOfInterestList), "OMX_ALG_IndexConfigVideoRegionOfInterestList" },
+  { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoSceneChangeAnalysis), "OMX_ALG_IndexConfigVideoSceneChangeAnalysis" },
+  { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoStaticFrameSkip), "OMX_ALG_IndexConfigVideoStaticFrameSkip" },
 
   { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexVendorCommonStartUnused), "OMX_ALG_IndexVendorCommonStartUnused" },
   { static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamCommonSequencePictureModeCurrent), "OMX_ALG_IndexParamCommonSequencePictureModeCurrent" },
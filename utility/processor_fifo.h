@@ -4,8 +4,16 @@
 #pragma once
 
 #include <utility/locked_queue.h>
+#include <utility/thread_cpu_time.h>
+#include <utility/thread_pool.h>
+#include <utility/thread_scheduling.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <thread>
 #include <functional>
+#include <memory>
 #include <string>
 
 #if defined __linux__
@@ -22,12 +30,38 @@ static inline void SetCurrentThreadName(char const*)
 
 #endif
 
+struct ProcessorFifoStatistics
+{
+  uint64_t enqueued = 0;
+  uint64_t processed = 0;
+  uint64_t depth = 0;
+  uint64_t maxDepth = 0;
+  uint64_t waitTime = 0; // microseconds spent in the queue by the processed tasks
+  uint64_t cpuTime = 0; // microseconds of cpu consumed by the worker thread
+};
+
+/* Used to keep the history of a processor that has been recreated.
+ * The depth is not carried over as the pending tasks of the old processor are dropped */
+static inline void AccumulateStatistics(ProcessorFifoStatistics& total, ProcessorFifoStatistics const& statistics)
+{
+  total.enqueued += statistics.enqueued;
+  total.processed += statistics.processed;
+  total.maxDepth = std::max(total.maxDepth, statistics.maxDepth);
+  total.waitTime += statistics.waitTime;
+  total.cpuTime += statistics.cpuTime;
+}
+
+/* Processes its tasks in order on its own thread, or on a strand of a pool when one is given */
 template<typename T>
 struct ProcessorFifo
 {
-  ProcessorFifo(std::function<void(T)> process_, std::function<void(T)> delete_, std::string name_) :
-    process_{process_}, delete_{delete_}, name_{name_}, thread{ & ProcessorFifo::Worker, this}
+  ProcessorFifo(std::function<void(T)> process_, std::function<void(T)> delete_, std::string name_, std::shared_ptr<ThreadPool> pool = nullptr) :
+    process_{process_}, delete_{delete_}, name_{name_}, isShared{pool != nullptr}
   {
+    if(isShared)
+      strand.reset(new Strand { pool });
+    else
+      thread = std::thread { &ProcessorFifo::Worker, this };
   }
 
   ~ProcessorFifo()
@@ -36,14 +70,68 @@ struct ProcessorFifo
       std::unique_lock<std::mutex> sync(mutex);
       process_ = delete_;
     }
-    tasks.push(Task { true, T {}
+
+    if(isShared)
+    {
+      strand.reset();
+      return;
+    }
+
+    tasks.push(Task { true, T {}, std::chrono::steady_clock::now()
                });
     thread.join();
   }
 
   void queue(T process)
   {
-    tasks.push(Task { false, process });
+    auto depth = ++this->depth;
+    auto maxDepth = this->maxDepth.load();
+
+    while(depth > maxDepth && !this->maxDepth.compare_exchange_weak(maxDepth, depth))
+      ;
+
+    ++enqueued;
+    Task task { false, process, std::chrono::steady_clock::now() };
+
+    if(isShared)
+    {
+      strand->Post([this, task]() {
+        Process(task);
+      });
+      return;
+    }
+
+    tasks.push(task);
+  }
+
+  /* Returns false when the system refused a part of it, or when the tasks run on a pool */
+  bool SetScheduling(ThreadScheduling const& scheduling)
+  {
+    if(isShared)
+      return false;
+
+    return SetThreadScheduling(thread.native_handle(), scheduling);
+  }
+
+  /* A null mask when the tasks run on a pool */
+  ThreadScheduling GetScheduling()
+  {
+    if(isShared)
+      return ThreadScheduling {};
+
+    return GetThreadScheduling(thread.native_handle());
+  }
+
+  ProcessorFifoStatistics GetStatistics() const
+  {
+    ProcessorFifoStatistics statistics {};
+    statistics.enqueued = enqueued;
+    statistics.processed = processed;
+    statistics.depth = depth;
+    statistics.maxDepth = maxDepth;
+    statistics.waitTime = waitTime;
+    statistics.cpuTime = cpuTime;
+    return statistics;
   }
 
 private:
@@ -52,6 +140,7 @@ private:
   {
     bool quit;
     T data;
+    std::chrono::steady_clock::time_point enqueuedAt;
   };
   locked_queue<Task> tasks;
 
@@ -59,6 +148,40 @@ private:
   std::function<void(T)> delete_;
   std::string name_;
 
+  std::atomic<uint64_t> enqueued {};
+  std::atomic<uint64_t> processed {};
+  std::atomic<uint64_t> depth {};
+  std::atomic<uint64_t> maxDepth {};
+  std::atomic<uint64_t> waitTime {};
+  std::atomic<uint64_t> cpuTime {};
+
+  bool const isShared;
+
+  void Process(Task const& task)
+  {
+    --depth;
+    waitTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - task.enqueuedAt).count();
+
+    std::function<void(T)> p {};
+    {
+      std::unique_lock<std::mutex> sync(mutex);
+      p = process_;
+    }
+
+    auto start = isShared ? GetCurrentThreadCpuTime() : 0;
+
+    if(p)
+      p(task.data);
+
+    ++processed;
+
+    // The threads of a pool run the tasks of other processors too
+    if(isShared)
+      cpuTime += GetCurrentThreadCpuTime() - start;
+    else
+      cpuTime = GetCurrentThreadCpuTime();
+  }
+
   void Worker(void)
   {
     if(!name_.empty())
@@ -71,16 +194,10 @@ private:
       if(task.quit)
         break;
 
-      std::function<void(T)> p {};
-      {
-        std::unique_lock<std::mutex> sync(mutex);
-        p = process_;
-      }
-
-      if(p)
-        p(task.data);
+      Process(task);
     }
   }
 
+  std::unique_ptr<Strand> strand;
   std::thread thread;
 };
@@ -2,6 +2,7 @@ THIS.utility:=$(call get-my-dir)
 
 UTILITY_SRCS+=\
 	$(THIS.utility)/logger.cpp\
+	$(THIS.utility)/thread_pool.cpp\
 
 UNITTESTS+=$(UTILITY_SRCS)
 UNITTESTS+=$(shell find $(THIS.utility)/unittests -name "*.cpp")
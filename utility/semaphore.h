@@ -44,6 +44,17 @@ struct semaphore
     --m_Count;
   }
 
+  bool try_wait()
+  {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    if(m_Count == 0)
+      return false;
+
+    --m_Count;
+    return true;
+  }
+
   void reset()
   {
     m_Count = 0;
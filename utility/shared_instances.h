@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+
+/* Process wide instances shared by key, such as the contexts of a device. The first user
+ * creates the instance, the next ones reuse it, and it is destroyed with its last user */
+template<class K, class V>
+struct SharedInstances
+{
+  template<class Create>
+  std::shared_ptr<V> Get(K const& key, Create create)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto instance = instances[key].lock();
+
+    if(!instance)
+    {
+      instance = create();
+      instances[key] = instance;
+    }
+
+    return instance;
+  }
+
+  int Count()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    int count = 0;
+
+    for(auto const& instance : instances)
+    {
+      if(!instance.second.expired())
+        ++count;
+    }
+
+    return count;
+  }
+
+private:
+  std::mutex mutex;
+  std::map<K, std::weak_ptr<V>> instances;
+};
@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if defined __linux__
+#include <time.h>
+
+/* CPU time consumed by the calling thread, in microseconds */
+static inline uint64_t GetCurrentThreadCpuTime()
+{
+  struct timespec ts {};
+
+  if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+    return 0;
+
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+#else
+static inline uint64_t GetCurrentThreadCpuTime()
+{
+  return 0;
+}
+
+#endif
+
+/* Adds the CPU time spent by the calling thread in the current scope to total */
+struct ThreadCpuTimeScope
+{
+  explicit ThreadCpuTimeScope(std::atomic<uint64_t>& total) :
+    total(total), start{GetCurrentThreadCpuTime()}
+  {
+  }
+
+  ~ThreadCpuTimeScope()
+  {
+    total += GetCurrentThreadCpuTime() - start;
+  }
+
+  ThreadCpuTimeScope(ThreadCpuTimeScope const &) = delete;
+  ThreadCpuTimeScope & operator = (ThreadCpuTimeScope const &) = delete;
+
+private:
+  std::atomic<uint64_t>& total;
+  uint64_t const start;
+};
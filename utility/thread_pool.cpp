@@ -0,0 +1,208 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#include "thread_pool.h"
+#include "logger.h"
+#include "processor_fifo.h"
+#include "shared_instances.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <system_error>
+#include <thread>
+
+using namespace std;
+
+static thread_local ThreadPool* currentPool = nullptr;
+
+ThreadPool::ThreadPool(int size, string name) :
+  size{max(size, 1)}, name{name}
+{
+  lock_guard<std::mutex> lock(mutex);
+
+  for(int i = 0; i < this->size; ++i)
+    StartWorker();
+}
+
+ThreadPool::~ThreadPool()
+{
+  unique_lock<std::mutex> lock(mutex);
+  stopped = true;
+  wakeUp.notify_all();
+  stoppedWorker.wait(lock, [this]() {
+    return workers == 0;
+  });
+}
+
+void ThreadPool::Post(function<void()> task)
+{
+  lock_guard<std::mutex> lock(mutex);
+  tasks.push_back(move(task));
+
+  if(idle > 0)
+    wakeUp.notify_one();
+  else if(workers - blocked < size)
+    StartWorker();
+}
+
+int ThreadPool::GetThreads()
+{
+  lock_guard<std::mutex> lock(mutex);
+  return workers;
+}
+
+void ThreadPool::StartWorker()
+{
+  ++workers;
+
+  try
+  {
+    thread { &ThreadPool::Worker, this }.detach();
+  }
+  catch(system_error const& error)
+  {
+    // The queued tasks wait for a thread already started
+    --workers;
+    LOG_ERROR(name + ": couldn't start a thread: " + error.what());
+  }
+}
+
+void ThreadPool::Worker()
+{
+  SetCurrentThreadName(name.c_str());
+  currentPool = this;
+  unique_lock<std::mutex> lock(mutex);
+
+  while(true)
+  {
+    if(tasks.empty())
+    {
+      if(stopped || workers - blocked > size)
+        break;
+
+      ++idle;
+      wakeUp.wait(lock);
+      --idle;
+      continue;
+    }
+
+    auto task = move(tasks.front());
+    tasks.pop_front();
+    lock.unlock();
+    task();
+    lock.lock();
+  }
+
+  --workers;
+  stoppedWorker.notify_all();
+}
+
+ThreadPool::BlockingScope::BlockingScope() :
+  pool{currentPool}
+{
+  if(!pool)
+    return;
+
+  lock_guard<std::mutex> lock(pool->mutex);
+  ++pool->blocked;
+
+  if(!pool->tasks.empty() && pool->idle == 0 && pool->workers - pool->blocked < pool->size)
+    pool->StartWorker();
+}
+
+ThreadPool::BlockingScope::~BlockingScope()
+{
+  if(!pool)
+    return;
+
+  lock_guard<std::mutex> lock(pool->mutex);
+  --pool->blocked;
+
+  // A spare thread started meanwhile can stop once it is idle
+  if(pool->workers - pool->blocked > pool->size)
+    pool->wakeUp.notify_all();
+}
+
+Strand::Strand(shared_ptr<ThreadPool> pool) :
+  pool{pool}
+{
+}
+
+Strand::~Strand()
+{
+  ThreadPool::BlockingScope blocking {};
+  unique_lock<std::mutex> lock(mutex);
+  drained.wait(lock, [this]() {
+    return !scheduled;
+  });
+}
+
+void Strand::Post(function<void()> task)
+{
+  {
+    lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(move(task));
+
+    if(scheduled)
+      return;
+
+    scheduled = true;
+  }
+
+  pool->Post([this]() {
+    Drain();
+  });
+}
+
+static int constexpr MAX_TASKS_PER_TURN = 16;
+
+void Strand::Drain()
+{
+  for(int i = 0; i < MAX_TASKS_PER_TURN; ++i)
+  {
+    function<void()> task;
+    {
+      lock_guard<std::mutex> lock(mutex);
+
+      if(tasks.empty())
+      {
+        scheduled = false;
+        drained.notify_all();
+        return;
+      }
+
+      task = move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+
+  // The other strands of the pool run before the remaining tasks
+  pool->Post([this]() {
+    Drain();
+  });
+}
+
+static int GetSharedThreadPoolSize()
+{
+  char* envValue = getenv("OMX_ALLEGRO_SHARED_THREADS");
+
+  if(envValue == nullptr)
+    return 0;
+
+  return max(atoi(envValue), 0);
+}
+
+shared_ptr<ThreadPool> GetSharedThreadPool()
+{
+  static SharedInstances<int, ThreadPool> pools;
+  auto size = GetSharedThreadPoolSize();
+
+  if(size == 0)
+    return nullptr;
+
+  return pools.Get(size, [size]() {
+    LOG_IMPORTANT("Components share a pool of " + to_string(size) + " thread(s)");
+    return make_shared<ThreadPool>(size, "OMX - Pool");
+  });
+}
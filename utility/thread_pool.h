@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/* Threads shared by the components of a process. Size threads are kept runnable: a task that
+ * waits inside a BlockingScope lends its thread, and a spare thread is started if work is queued
+ * meanwhile. The spare threads stop once they are idle and no longer needed.
+ * The pool must not be destroyed from one of its own threads */
+struct ThreadPool
+{
+  ThreadPool(int size, std::string name);
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool & operator = (ThreadPool const &) = delete;
+
+  void Post(std::function<void()> task);
+
+  int GetSize() const
+  {
+    return size;
+  }
+
+  /* Threads currently started, spare ones included */
+  int GetThreads();
+
+  /* Marks a wait of the calling thread on work that may be queued behind it in its pool.
+   * Does nothing outside of the threads of a pool */
+  struct BlockingScope
+  {
+    BlockingScope();
+    ~BlockingScope();
+
+    BlockingScope(BlockingScope const &) = delete;
+    BlockingScope & operator = (BlockingScope const &) = delete;
+
+  private:
+    ThreadPool* const pool;
+  };
+
+private:
+  int const size;
+  std::string const name;
+  std::mutex mutex;
+  std::condition_variable wakeUp;
+  std::condition_variable stoppedWorker;
+  std::deque<std::function<void()>> tasks;
+  int workers = 0;
+  int idle = 0;
+  int blocked = 0;
+  bool stopped = false;
+
+  /* Must be called with the lock held */
+  void StartWorker();
+  void Worker();
+};
+
+/* Runs its tasks one at a time, in the order they were posted, on the threads of a pool */
+struct Strand
+{
+  explicit Strand(std::shared_ptr<ThreadPool> pool);
+
+  /* Waits for the tasks already posted */
+  ~Strand();
+
+  Strand(Strand const &) = delete;
+  Strand & operator = (Strand const &) = delete;
+
+  void Post(std::function<void()> task);
+
+private:
+  std::shared_ptr<ThreadPool> const pool;
+  std::mutex mutex;
+  std::condition_variable drained;
+  std::deque<std::function<void()>> tasks;
+  bool scheduled = false;
+
+  void Drain();
+};
+
+/* The pool the components of the process share, sized by OMX_ALLEGRO_SHARED_THREADS as read when
+ * the component is created: the components created with the same size share a pool.
+ * Returns nullptr when the variable is unset or 0: each component then has its own threads */
+std::shared_ptr<ThreadPool> GetSharedThreadPool();
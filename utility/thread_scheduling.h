@@ -0,0 +1,137 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+
+enum class SchedulingPolicy
+{
+  OTHER,
+  FIFO,
+  ROUND_ROBIN,
+};
+
+struct ThreadScheduling
+{
+  uint64_t cpuMask; // one bit per cpu, 0 keeps the affinity of the process
+  SchedulingPolicy policy;
+  int priority; // only for the real time policies
+};
+
+static inline std::string ToString(ThreadScheduling const& scheduling)
+{
+  static char const* const policies[] = { "other", "fifo", "rr" };
+  std::stringstream ss;
+  ss << "cpus 0x" << std::hex << scheduling.cpuMask << std::dec << ", " << policies[static_cast<int>(scheduling.policy)];
+
+  if(scheduling.policy != SchedulingPolicy::OTHER)
+    ss << " " << scheduling.priority;
+
+  return ss.str();
+}
+
+/* Parses "mask[,policy[,priority]]" where the mask is in hexadecimal as for taskset and the
+ * policy is one of other, fifo or rr: "0xc,fifo,50" */
+static inline bool ParseThreadScheduling(std::string const& text, ThreadScheduling& scheduling)
+{
+  std::stringstream ss { text };
+  std::string mask, policy, priority;
+  std::getline(ss, mask, ',');
+  std::getline(ss, policy, ',');
+  std::getline(ss, priority, ',');
+
+  char* end;
+  scheduling.cpuMask = strtoull(mask.c_str(), &end, 16);
+
+  if(mask.empty() || *end != '\0')
+    return false;
+
+  if(policy.empty() || policy == "other")
+    scheduling.policy = SchedulingPolicy::OTHER;
+  else if(policy == "fifo")
+    scheduling.policy = SchedulingPolicy::FIFO;
+  else if(policy == "rr")
+    scheduling.policy = SchedulingPolicy::ROUND_ROBIN;
+  else
+    return false;
+
+  scheduling.priority = priority.empty() ? 0 : atoi(priority.c_str());
+  return true;
+}
+
+#if defined __linux__
+#include <pthread.h>
+#include <sched.h>
+
+static int constexpr MAX_SCHEDULING_CPUS = 64;
+
+/* Returns false when the system refused a part of the scheduling, for instance a real time
+ * policy without CAP_SYS_NICE. What was accepted stays applied */
+static inline bool SetThreadScheduling(std::thread::native_handle_type thread, ThreadScheduling const& scheduling)
+{
+  bool isApplied = true;
+
+  if(scheduling.cpuMask)
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+
+    for(int cpu = 0; cpu < MAX_SCHEDULING_CPUS; ++cpu)
+    {
+      if(scheduling.cpuMask & (uint64_t { 1 } << cpu))
+        CPU_SET(cpu, &cpus);
+    }
+
+    isApplied = pthread_setaffinity_np(thread, sizeof(cpus), &cpus) == 0;
+  }
+
+  static int const policies[] = { SCHED_OTHER, SCHED_FIFO, SCHED_RR };
+  struct sched_param param {};
+  param.sched_priority = scheduling.priority;
+  return pthread_setschedparam(thread, policies[static_cast<int>(scheduling.policy)], &param) == 0 && isApplied;
+}
+
+/* What the thread runs with, as reported by the system */
+static inline ThreadScheduling GetThreadScheduling(std::thread::native_handle_type thread)
+{
+  ThreadScheduling scheduling {};
+  cpu_set_t cpus;
+
+  if(pthread_getaffinity_np(thread, sizeof(cpus), &cpus) == 0)
+  {
+    for(int cpu = 0; cpu < MAX_SCHEDULING_CPUS; ++cpu)
+    {
+      if(CPU_ISSET(cpu, &cpus))
+        scheduling.cpuMask |= uint64_t { 1 } << cpu;
+    }
+  }
+
+  int policy;
+  struct sched_param param {};
+
+  if(pthread_getschedparam(thread, &policy, &param) == 0)
+  {
+    scheduling.policy = policy == SCHED_FIFO ? SchedulingPolicy::FIFO : policy == SCHED_RR ? SchedulingPolicy::ROUND_ROBIN : SchedulingPolicy::OTHER;
+    scheduling.priority = param.sched_priority;
+  }
+
+  return scheduling;
+}
+
+#else
+static inline bool SetThreadScheduling(std::thread::native_handle_type, ThreadScheduling const&)
+{
+  return false;
+}
+
+static inline ThreadScheduling GetThreadScheduling(std::thread::native_handle_type)
+{
+  return ThreadScheduling {};
+}
+
+#endif
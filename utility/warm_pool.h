@@ -0,0 +1,101 @@
+// SPDX-FileCopyrightText: © 2024 Allegro DVT <github-ip@allegrodvt.com>
+// SPDX-License-Identifier: MIT
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/* Instances created ahead of time by a background thread, so taking one is a handoff instead of
+ * a construction. The pool is refilled after each take. A failed creation stops the refill until
+ * the next take, so a missing device doesn't keep the thread busy */
+template<class T>
+struct WarmPool
+{
+  WarmPool(int size, std::function<bool(T&)> create, std::function<void(T)> destroy) :
+    size{size}, create{create}, destroy{destroy}
+  {
+    filler = std::thread { &WarmPool::Fill, this };
+  }
+
+  ~WarmPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopped = true;
+    }
+    wakeUp.notify_one();
+    filler.join();
+
+    for(auto& instance : ready)
+      destroy(instance);
+  }
+
+  /* Hands over a ready instance. Returns false when none is ready */
+  bool Take(T& instance)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    failed = false;
+    wakeUp.notify_one();
+
+    if(ready.empty())
+      return false;
+
+    instance = ready.front();
+    ready.pop_front();
+    return true;
+  }
+
+  int Ready()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(ready.size());
+  }
+
+private:
+  void Fill()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while(true)
+    {
+      wakeUp.wait(lock, [&]() {
+        return stopped || (!failed && static_cast<int>(ready.size()) < size);
+      });
+
+      if(stopped)
+        return;
+
+      lock.unlock();
+      T instance;
+      auto created = create(instance);
+      lock.lock();
+
+      if(!created)
+      {
+        failed = true;
+        continue;
+      }
+
+      if(stopped)
+      {
+        destroy(instance);
+        return;
+      }
+
+      ready.push_back(instance);
+    }
+  }
+
+  int const size;
+  std::function<bool(T&)> const create;
+  std::function<void(T)> const destroy;
+  std::mutex mutex;
+  std::condition_variable wakeUp;
+  std::deque<T> ready;
+  bool stopped = false;
+  bool failed = false;
+  std::thread filler;
+};